@@ -0,0 +1,161 @@
+/**
+ * 服务端处理每个请求的内存分配次数
+ *
+ * 替换malloc/calloc/realloc(glibc)统计分配次数. 客户端在子进程中运行，只统计服务端进程：
+ * 客户端先发送/bench/begin，再发送N个相同的请求，最后发送/bench/end，服务端在两个标记之间计数.
+ *
+ * 分别统计文本编码、二进制编码、延迟解析、类型化路由和携带数据体的请求.
+ */
+#include <atomic>
+#include <string>
+#include <thread>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "uds/json/client.h"
+#include "uds/json/router.h"
+#include "uds/json/server.h"
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void __libc_free(void* ptr);
+
+static std::atomic<uint64_t> g_allocations{0};
+
+extern "C" void* malloc(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+struct Profile {
+    int64_t uid = 0;
+    std::string name;
+    std::string email;
+    int age = 0;
+    double score = 0;
+    bool vip = false;
+    std::vector<std::string> tags;
+};
+IC_UDS_FIELDS(Profile, uid, name, email, age, score, vip, tags)
+
+struct Result {
+    int code = 0;
+    std::string msg;
+    int64_t uid = 0;
+    std::string name;
+};
+IC_UDS_FIELDS(Result, code, msg, uid, name)
+
+const char* socket_file = "/dev/shm/.benchmark_allocations.sock";
+const char* client_socket_file = "/dev/shm/.benchmark_allocations_client.sock";
+const int N = 10000;
+
+/* 客户端(子进程) */
+void run_client(const char* path, bool binary, bool with_body) {
+    usleep(200000);
+    ic::uds::Client client;
+    std::error_code ec;
+    client.Init(socket_file, client_socket_file, ec);
+    if (ec) {
+        printf("[Error] UDS.Client init failed. %s\n", ec.message().c_str());
+        return;
+    }
+    client.set_binary_envelope(binary);
+    ic::uds::Request req(path);
+    req["uid"] = 1001;
+    req["name"] = "Leopard-C";
+    req["email"] = "leopard.c@outlook.com";
+    req["age"] = 28;
+    req["score"] = 98.5;
+    req["vip"] = true;
+    req["tags"].append("cpp");
+    req["tags"].append("uds");
+    if (with_body) {
+        req.AddBody("image", std::string(4096, 'x'));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        client.SendRequest(req, 1000);
+    }
+    ic::uds::Request begin("/bench/begin");
+    client.SendRequest(begin, 1000);
+    for (int i = 0; i < N; ++i) {
+        client.SendRequest(req, 1000);
+    }
+    ic::uds::Request end("/bench/end");
+    client.SendRequest(end, 1000);
+    ic::uds::Request stop("/bench/stop");
+    client.SendRequest(stop, 1000);
+}
+
+/* 服务端(当前进程) */
+void run(const char* name, const char* path, bool binary, bool lazy, bool with_body) {
+    unlink(socket_file);
+    pid_t pid = fork();
+    if (pid == 0) {
+        run_client(path, binary, with_body);
+        _exit(0);
+    }
+    ic::uds::Server server;
+    std::error_code ec;
+    server.Init(socket_file, 1, ec);
+    if (ec) {
+        printf("[Error] UDS.Server init failed. %s\n", ec.message().c_str());
+        return;
+    }
+    server.set_lazy_parsing(lazy);
+    ic::uds::Router* router = server.router();
+    router->AddRoute("/user/UpdateProfile", [](ic::uds::Request& req, ic::uds::Response& res){
+        res["code"] = 0;
+        res["msg"] = "OK";
+        res["uid"] = req["uid"];
+        res["name"] = req["name"];
+    });
+    router->AddRoute("/image/Upload", [](ic::uds::Request& req, ic::uds::Response& res){
+        res["code"] = 0;
+        res["size"] = static_cast<Json::UInt64>(req.GetBody("image").size());
+    });
+    router->AddRoute<Profile, Result>("/user/UpdateProfileTyped", "",
+        [](ic::uds::Request& req, const Profile& in, Result& out){
+            out.msg = "OK";
+            out.uid = in.uid;
+            out.name = in.name;
+        });
+    uint64_t begin = 0;
+    router->AddRoute("/bench/begin", [&begin](ic::uds::Request& req, ic::uds::Response& res){
+        begin = g_allocations.load();
+    });
+    router->AddRoute("/bench/end", [&begin, name](ic::uds::Request& req, ic::uds::Response& res){
+        /* 包括/bench/end本身 */
+        printf("%-24s %6.1f allocations/request\n", name, (g_allocations.load() - begin) / static_cast<double>(N + 1));
+    });
+    router->AddRoute("/bench/stop", [&server](ic::uds::Request& req, ic::uds::Response& res){
+        std::thread([&server]{ server.Stop(); }).detach();
+    });
+    server.Start();
+    waitpid(pid, nullptr, 0);
+}
+
+int main() {
+    run("text", "/user/UpdateProfile", false, false, false);
+    run("binary", "/user/UpdateProfile", true, false, false);
+    run("text, lazy parsing", "/user/UpdateProfile", false, true, false);
+    run("text, typed route", "/user/UpdateProfileTyped", false, false, false);
+    run("binary, typed route", "/user/UpdateProfileTyped", true, false, false);
+    run("body only, lazy parsing", "/image/Upload", false, true, true);
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * 批处理路由(Router::AddBatchRoute)与普通路由的写入速度
+ *
+ * 模拟每次调用有固定开销的存储(如数据库的一次提交、日志的一次刷盘)：每次写入耗时200微秒，同一时刻只能执行一次写入.
+ * 普通路由每个请求写入一次，批处理路由每个批次写入一次.
+ *
+ * 64个客户端并发发送请求，统计每秒写入的记录数.
+ */
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <unistd.h>
+#include "uds/json/client.h"
+#include "uds/json/router.h"
+#include "uds/json/server.h"
+
+const char* socket_file = "/dev/shm/.benchmark_batch_route.sock";
+const int kClients = 64;
+const int kSeconds = 2;
+
+/* 模拟的存储 */
+class Storage {
+public:
+    void Write(size_t count) {
+        std::lock_guard<std::mutex> lck(mutex_);
+        usleep(200);
+        records_ += count;
+        ++writes_;
+    }
+    size_t records() const { return records_; }
+    size_t writes() const { return writes_; }
+
+private:
+    std::mutex mutex_;
+    size_t records_{0};
+    size_t writes_{0};
+};
+
+/* 运行kSeconds秒，返回每秒完成的请求数 */
+double run_clients(const char* path) {
+    std::atomic_bool stop{false};
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> failed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kClients; ++i) {
+        threads.emplace_back([&, i]{
+            ic::uds::Client client;
+            std::error_code ec;
+            std::string client_socket_file = "/dev/shm/.benchmark_batch_route_client_" + std::to_string(i) + ".sock";
+            client.Init(socket_file, client_socket_file.c_str(), ec);
+            if (ec) {
+                printf("[Error] UDS.Client init failed. %s\n", ec.message().c_str());
+                return;
+            }
+            ic::uds::Request req(path);
+            req["level"] = "info";
+            req["msg"] = "user 1001 login";
+            while (!stop.load()) {
+                ic::uds::Response res = client.SendRequest(req, 3000);
+                if (res.success() && res["code"].asInt() == 0) {
+                    ++done;
+                }
+                else {
+                    ++failed;
+                }
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(kSeconds));
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    if (failed) {
+        printf("[Error] %lu requests failed\n", failed.load());
+    }
+    return done / (elapsed / 1e6);
+}
+
+int main() {
+    unlink(socket_file);
+    ic::uds::Server server;
+    std::error_code ec;
+    server.Init(socket_file, 8, ec);
+    if (ec) {
+        printf("[Error] UDS.Server init failed. %s\n", ec.message().c_str());
+        return 1;
+    }
+    Storage storage;
+    Storage batch_storage;
+    ic::uds::Router* router = server.router();
+    router->AddRoute("/log/write", [&storage](ic::uds::Request& req, ic::uds::Response& res){
+        storage.Write(1);
+        res["code"] = 0;
+    });
+    ic::uds::RouteOptions options;
+    options.batch_max_size = 64;
+    options.batch_max_delay_us = 500;
+    router->AddBatchRoute("/log/write_batch", "", options, [&batch_storage](std::vector<ic::uds::BatchItem>& batch){
+        batch_storage.Write(batch.size());
+        for (auto& item : batch) {
+            item.res["code"] = 0;
+        }
+    });
+    std::thread thread([&server]{ server.Start(); });
+    usleep(200000);
+
+    double plain = run_clients("/log/write");
+    printf("route        %10.0f records/s   %6.1f records/write\n", plain, storage.records() / static_cast<double>(storage.writes()));
+    double batched = run_clients("/log/write_batch");
+    printf("batch route  %10.0f records/s   %6.1f records/write\n", batched, batch_storage.records() / static_cast<double>(batch_storage.writes()));
+    printf("%.2fx\n", batched / plain);
+
+    server.Stop();
+    thread.join();
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * 压缩对大数据量请求的影响
+ *
+ * 同一进程内启动服务端(回显)和客户端，分别在不启用/启用压缩时发送约1MB的JSON数据，
+ * 统计每个请求的分包数量和有效吞吐量(原始数据量/耗时).
+ */
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <unistd.h>
+#include <lz4/lz4_block.h>
+#include "uds/base/base_client.h"
+#include "uds/base/base_server.h"
+
+const char* server_socket_file = "/dev/shm/.benchmark_compression_server.sock";
+const char* client_socket_file = "/dev/shm/.benchmark_compression_client.sock";
+const size_t kRecordsCount = 8000;
+const size_t kThreadsCount = 8;
+const size_t kSendTimes = 50;
+const size_t kMaxPacketDataSize = 65507 - 40;  /* 单个数据报的最大长度 - v2头部长度 */
+
+/* 生成JSON数据，约1MB */
+std::string make_payload() {
+    std::string text = "{\"records\":[";
+    for (size_t i = 0; i < kRecordsCount; ++i) {
+        if (i > 0) {
+            text += ",";
+        }
+        text += "{\"id\":" + std::to_string(100000 + i * 7)
+            + ",\"name\":\"user_" + std::to_string(i % 1000)
+            + "\",\"email\":\"user_" + std::to_string(i % 1000) + "@example.com\""
+            + ",\"active\":" + (i % 3 ? "true" : "false")
+            + ",\"score\":" + std::to_string((i * 7919) % 10000) + "}";
+    }
+    text += "]}";
+    return text;
+}
+
+size_t packets_count(size_t len) {
+    return (len + kMaxPacketDataSize - 1) / kMaxPacketDataSize;
+}
+
+void run(ic::uds::BaseServer& server, ic::uds::BaseClient& client, const std::string& payload, bool compression) {
+    server.set_compression(compression, 4096);
+    client.set_compression(compression, 4096);
+    auto time_start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreadsCount; ++t) {
+        threads.emplace_back([&client, &payload]{
+            for (size_t i = 0; i < kSendTimes; ++i) {
+                std::error_code ec;
+                std::string response;
+                int64_t id = client.SendRequest(payload, &response, 5000, ec);
+                if (ec || response.length() != payload.length()) {
+                    printf("[%ld] SendRequest() failed. %s\n", id, ec.message().c_str());
+                    return;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto time_end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(time_end - time_start).count() / 1e6;
+    size_t requests = kThreadsCount * kSendTimes;
+    double mb = double(payload.length() * requests * 2) / (1024 * 1024);  /* 请求 + 响应 */
+    printf("compression=%-3s  %8.1f MB/s  %6.1f r/s\n", compression ? "on" : "off", mb / seconds, requests / seconds);
+}
+
+int main() {
+    std::string payload = make_payload();
+    std::string compressed(lz4_block::compress_bound(payload.length()), '\0');
+    size_t compressed_size = lz4_block::compress(payload.data(), payload.length(), &compressed[0], compressed.length());
+    printf("payload: %lu bytes, %lu packets\n", payload.length(), packets_count(payload.length()));
+    printf("compressed: %lu bytes, %lu packets (%.1fx)\n",
+        compressed_size, packets_count(compressed_size), double(payload.length()) / compressed_size);
+
+    ic::uds::BaseServer server;
+    std::error_code ec;
+    server.Init(server_socket_file, kThreadsCount, ec);
+    if (ec) {
+        printf("[Error] UDS.BaseServer init failed. %s\n", ec.message().c_str());
+        return 1;
+    }
+    server.set_request_callback([](ic::uds::BaseServer* server, const sockaddr_un& client_addr, int64_t request_id, const std::string& data){
+        server->SendResponse(client_addr, request_id, data);
+    });
+    std::thread t([&server]{ server.Start(); });
+
+    ic::uds::BaseClient client;
+    client.Init(server_socket_file, client_socket_file, ec);
+    if (ec) {
+        printf("[Error] UDS.BaseClient init failed. %s\n", ec.message().c_str());
+        server.Stop();
+        t.join();
+        return 1;
+    }
+
+    run(server, client, payload, false);
+    run(server, client, payload, true);
+
+    server.Stop();
+    t.join();
+    return 0;
+}
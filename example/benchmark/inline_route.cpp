@@ -0,0 +1,78 @@
+/**
+ * 在接收线程上执行的路由(RouteOptions::inline_execution)与在线程池中执行的路由的延迟
+ *
+ * 健康检查路由的处理函数几乎不耗时，延迟主要来自入队和唤醒工作线程.
+ * 客户端依次发送N个请求，统计各个分位的延迟.
+ */
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <unistd.h>
+#include "uds/json/client.h"
+#include "uds/json/router.h"
+#include "uds/json/server.h"
+
+const char* socket_file = "/dev/shm/.benchmark_inline_route.sock";
+const char* client_socket_file = "/dev/shm/.benchmark_inline_route_client.sock";
+const int N = 20000;
+
+/* 依次发送N个请求，输出各个分位的延迟(微秒) */
+void run(ic::uds::Client& client, const char* name, const char* path) {
+    ic::uds::Request req(path);
+    for (int i = 0; i < 1000; ++i) {
+        client.SendRequest(req, 1000);
+    }
+    std::vector<double> latencies;
+    latencies.reserve(N);
+    for (int i = 0; i < N; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        ic::uds::Response res = client.SendRequest(req, 1000);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (!res.success()) {
+            printf("[Error] %s failed. status=%d\n", path, static_cast<int>(res.status()));
+            return;
+        }
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / 1000.0);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p){ return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    printf("%-12s p50 %7.1fus   p99 %7.1fus   p99.9 %7.1fus\n", name, percentile(0.5), percentile(0.99), percentile(0.999));
+}
+
+int main() {
+    unlink(socket_file);
+    ic::uds::Server server;
+    std::error_code ec;
+    server.Init(socket_file, 4, ec);
+    if (ec) {
+        printf("[Error] UDS.Server init failed. %s\n", ec.message().c_str());
+        return 1;
+    }
+    ic::uds::Router* router = server.router();
+    router->AddRoute("/health", [](ic::uds::Request& req, ic::uds::Response& res){
+        res["ok"] = true;
+    });
+    ic::uds::RouteOptions options;
+    options.inline_execution = true;
+    router->AddRoute("/health_inline", "", options, [](ic::uds::Request& req, ic::uds::Response& res){
+        res["ok"] = true;
+    });
+    std::thread thread([&server]{ server.Start(); });
+    usleep(200000);
+
+    ic::uds::Client client;
+    client.Init(socket_file, client_socket_file, ec);
+    if (ec) {
+        printf("[Error] UDS.Client init failed. %s\n", ec.message().c_str());
+        return 1;
+    }
+    run(client, "thread pool", "/health");
+    run(client, "inline", "/health_inline");
+
+    server.Stop();
+    thread.join();
+    return 0;
+}
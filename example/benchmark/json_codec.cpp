@@ -0,0 +1,130 @@
+/**
+ * JSON编解码的吞吐量：jsoncpp(Json::FastWriter/Json::Reader) 与 json::Write/json::Parse
+ *
+ * 分别使用一个典型的小请求(十几个参数)和一个较大的请求(数百条记录)，
+ * 统计每秒序列化/解析的次数和吞吐量，并检查两者的序列化结果是否一致.
+ *
+ * 另外对比二进制编码(msgpack::Write/msgpack::Parse)的大小和编解码速度.
+ */
+#include <chrono>
+#include <functional>
+#include <string>
+#include <stdio.h>
+#include <jsoncpp/json/json.h>
+#include "uds/json/json_codec.h"
+#include "uds/json/msgpack_codec.h"
+
+/* 典型的小请求 */
+Json::Value make_small() {
+    Json::Value root;
+    root[":path"] = "/user/UpdateProfile";
+    Json::Value& param = root[":param"];
+    param["uid"] = 1001;
+    param["name"] = "Leopard-C";
+    param["email"] = "leopard.c@outlook.com";
+    param["age"] = 28;
+    param["score"] = 98.5;
+    param["vip"] = true;
+    param["bio"] = "Hello \"world\"\nline2\ttab";
+    param["tags"].append("cpp");
+    param["tags"].append("uds");
+    param["tags"].append("json");
+    param["address"]["city"] = "Beijing";
+    param["address"]["zip"] = "100000";
+    param["address"]["geo"]["lat"] = 39.9042;
+    param["address"]["geo"]["lng"] = 116.4074;
+    return root;
+}
+
+/* 较大的请求，约40KB */
+Json::Value make_large() {
+    Json::Value root;
+    root[":path"] = "/records/BatchInsert";
+    Json::Value& records = root[":param"]["records"];
+    for (int i = 0; i < 500; ++i) {
+        Json::Value record;
+        record["id"] = 100000 + i * 7;
+        record["name"] = "user_" + std::to_string(i % 1000);
+        record["email"] = "user_" + std::to_string(i % 1000) + "@example.com";
+        record["active"] = (i % 3 != 0);
+        record["score"] = (i * 7919) % 10000;
+        records.append(record);
+    }
+    return root;
+}
+
+/* 运行约1秒，返回每秒次数 */
+double measure(const std::function<void()>& func) {
+    size_t times = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    while (elapsed < std::chrono::seconds(1)) {
+        for (int i = 0; i < 100; ++i) {
+            func();
+        }
+        times += 100;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return times / (std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1e6);
+}
+
+void run(const char* name, const Json::Value& value) {
+    Json::FastWriter fw;
+    fw.emitUTF8();
+    fw.omitEndingLineFeed();
+    fw.dropNullKeyValues();
+    std::string expected = fw.write(value);
+    std::string actual;
+    ic::uds::json::Write(value, &actual);
+    printf("%s: %lu bytes, output %s\n", name, expected.length(), expected == actual ? "identical" : "DIFFERENT");
+
+    double mb = expected.length() / (1024.0 * 1024.0);
+    double jsoncpp_write = measure([&]{
+        Json::FastWriter writer;
+        writer.emitUTF8();
+        writer.omitEndingLineFeed();
+        writer.dropNullKeyValues();
+        std::string s = writer.write(value);
+    });
+    double codec_write = measure([&]{
+        std::string s;
+        ic::uds::json::Write(value, &s);
+    });
+    double jsoncpp_parse = measure([&]{
+        Json::Reader reader;
+        Json::Value v;
+        reader.parse(expected.data(), expected.data() + expected.length(), v, false);
+    });
+    double codec_parse = measure([&]{
+        Json::Value v;
+        ic::uds::json::Parse(expected.data(), expected.data() + expected.length(), &v);
+    });
+    printf("  serialize  jsoncpp %10.0f/s %7.1f MB/s   codec %10.0f/s %7.1f MB/s   %.2fx\n",
+        jsoncpp_write, jsoncpp_write * mb, codec_write, codec_write * mb, codec_write / jsoncpp_write);
+    printf("  parse      jsoncpp %10.0f/s %7.1f MB/s   codec %10.0f/s %7.1f MB/s   %.2fx\n",
+        jsoncpp_parse, jsoncpp_parse * mb, codec_parse, codec_parse * mb, codec_parse / jsoncpp_parse);
+
+    /* 二进制编码 */
+    std::string binary;
+    ic::uds::msgpack::Write(value, &binary, ":path");
+    Json::Value decoded;
+    bool same = ic::uds::msgpack::Parse(binary.data(), binary.data() + binary.length(), &decoded) && decoded == value;
+    printf("  binary: %lu bytes (%.1f%% of text), round trip %s\n",
+        binary.length(), binary.length() * 100.0 / expected.length(), same ? "identical" : "DIFFERENT");
+    double binary_write = measure([&]{
+        std::string s;
+        ic::uds::msgpack::Write(value, &s, ":path");
+    });
+    double binary_parse = measure([&]{
+        Json::Value v;
+        ic::uds::msgpack::Parse(binary.data(), binary.data() + binary.length(), &v);
+    });
+    printf("  serialize  text    %10.0f/s   binary %10.0f/s   %.2fx\n", codec_write, binary_write, binary_write / codec_write);
+    printf("  parse      text    %10.0f/s   binary %10.0f/s   %.2fx\n", codec_parse, binary_parse, binary_parse / codec_parse);
+}
+
+int main() {
+    run("small", make_small());
+    run("large", make_large());
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * 路由查找的耗时：std::map(原来的实现) 与 Router(路由树)
+ *
+ * 分别注册10个和1000个静态路由(如 /order/Module3/GetDetail)，依次查找所有路由，统计平均每次查找的耗时；
+ * 另外统计带路径参数的路由(如 /user/:id/profile)的查找耗时.
+ */
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include "uds/json/router.h"
+
+static const char* kServices[] = { "user", "order", "payment", "inventory", "search", "message", "file", "report" };
+static const char* kActions[] = { "Get", "GetDetail", "List", "Create", "Update", "Delete", "BatchGet", "Search" };
+
+/* 生成n个不重复的路径 */
+std::vector<std::string> make_paths(size_t n) {
+    std::vector<std::string> paths;
+    for (size_t i = 0; paths.size() < n; ++i) {
+        std::string path = "/";
+        path += kServices[i % 8];
+        path += "/Module" + std::to_string(i / 64);
+        path += "/";
+        path += kActions[(i / 8) % 8];
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+/* 运行约1秒，返回每次调用的纳秒数 */
+double measure(size_t batch, const std::function<void()>& func) {
+    size_t times = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    while (elapsed < std::chrono::seconds(1)) {
+        func();
+        times += batch;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / static_cast<double>(times);
+}
+
+void run(size_t n) {
+    auto handler = [](ic::uds::Request&, ic::uds::Response&){};
+    std::vector<std::string> paths = make_paths(n);
+    std::map<std::string, ic::uds::Route*, std::less<>> routes;
+    ic::uds::Router router;
+    for (auto& path : paths) {
+        routes.emplace(path, new ic::uds::Route(path, handler));
+        router.AddRoute(path, handler);
+    }
+
+    /* 查找的路径来自请求，使用string_view */
+    std::vector<std::string> requests(paths.rbegin(), paths.rend());
+    size_t found = 0;
+    double map_ns = measure(requests.size(), [&]{
+        for (auto& path : requests) {
+            found += (routes.find(std::string_view(path)) != routes.end());
+        }
+    });
+    double tree_ns = measure(requests.size(), [&]{
+        for (auto& path : requests) {
+            found += (router.FindRoute(std::string_view(path)) != nullptr);
+        }
+    });
+    printf("%4lu routes: map %6.1f ns   radix tree %6.1f ns   %.2fx\n", n, map_ns, tree_ns, map_ns / tree_ns);
+
+    for (auto& item : routes) {
+        delete item.second;
+    }
+    if (found == 0) {
+        printf("not found\n");
+    }
+}
+
+void run_params() {
+    auto handler = [](ic::uds::Request&, ic::uds::Response&){};
+    ic::uds::Router router;
+    for (auto& path : make_paths(1000)) {
+        router.AddRoute(path, handler);
+    }
+    router.AddRoute("/user/:id/profile", handler);
+    router.AddRoute("/user/:id/posts/:post_id", handler);
+    router.AddRoute("/static/*file", handler);
+
+    std::vector<std::string> requests = { "/user/1001/profile", "/user/1001/posts/42", "/static/css/main.css" };
+    size_t found = 0;
+    double ns = measure(requests.size(), [&]{
+        ic::uds::PathParams params;
+        for (auto& path : requests) {
+            found += (router.FindRoute(std::string_view(path), &params) != nullptr) + params.size();
+        }
+    });
+    printf("path parameters: %6.1f ns\n", ns);
+    if (found == 0) {
+        printf("not found\n");
+    }
+}
+
+int main() {
+    run(10);
+    run(1000);
+    run_params();
+    return 0;
+}
@@ -0,0 +1,237 @@
+/**
+ * 类型化路由的参数解码和响应编码：Json::Value(json::Parse + 逐个读取字段，构造Json::Value + json::Write)
+ * 与 typed::DecodeJson/typed::EncodeJson(直接在数据和结构体之间转换)
+ *
+ * 使用一个典型的请求(20个字段)，统计每秒解码/编码的次数，并检查两者的结果是否一致.
+ *
+ * 另外对比二进制编码(MessagePack)的解码/编码速度.
+ */
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <jsoncpp/json/json.h>
+#include "uds/json/json_codec.h"
+#include "uds/json/msgpack_codec.h"
+#include "uds/json/typed_codec.h"
+
+struct Geo {
+    double lat = 0;
+    double lng = 0;
+};
+IC_UDS_FIELDS(Geo, lat, lng)
+
+struct Profile {
+    int64_t uid = 0;
+    std::string name;
+    std::string email;
+    int age = 0;
+    double score = 0;
+    bool vip = false;
+    std::string bio;
+    std::vector<std::string> tags;
+    std::string city;
+    std::string zip;
+    Geo geo;
+    int64_t created_at = 0;
+    int64_t updated_at = 0;
+    uint32_t level = 0;
+    uint32_t exp = 0;
+    std::string avatar;
+    std::string phone;
+    bool verified = false;
+    std::vector<int> roles;
+    std::string locale;
+};
+IC_UDS_FIELDS(Profile, uid, name, email, age, score, vip, bio, tags, city, zip,
+    geo, created_at, updated_at, level, exp, avatar, phone, verified, roles, locale)
+
+Profile make_profile() {
+    Profile p;
+    p.uid = 1001;
+    p.name = "Leopard-C";
+    p.email = "leopard.c@outlook.com";
+    p.age = 28;
+    p.score = 98.5;
+    p.vip = true;
+    p.bio = "Hello \"world\"\nline2\ttab";
+    p.tags = { "cpp", "uds", "json" };
+    p.city = "Beijing";
+    p.zip = "100000";
+    p.geo.lat = 39.9042;
+    p.geo.lng = 116.4074;
+    p.created_at = 1680000000;
+    p.updated_at = 1682000000;
+    p.level = 12;
+    p.exp = 34567;
+    p.avatar = "https://example.com/avatar/1001.png";
+    p.phone = "+86 10 1234 5678";
+    p.verified = true;
+    p.roles = { 1, 3, 7 };
+    p.locale = "zh-CN";
+    return p;
+}
+
+/* 经由Json::Value解码 */
+bool dom_decode(const Json::Value& v, Profile* p) {
+    if (!v.isObject()) {
+        return false;
+    }
+    p->uid = v["uid"].asInt64();
+    p->name = v["name"].asString();
+    p->email = v["email"].asString();
+    p->age = v["age"].asInt();
+    p->score = v["score"].asDouble();
+    p->vip = v["vip"].asBool();
+    p->bio = v["bio"].asString();
+    p->tags.clear();
+    for (auto& tag : v["tags"]) {
+        p->tags.push_back(tag.asString());
+    }
+    p->city = v["city"].asString();
+    p->zip = v["zip"].asString();
+    p->geo.lat = v["geo"]["lat"].asDouble();
+    p->geo.lng = v["geo"]["lng"].asDouble();
+    p->created_at = v["created_at"].asInt64();
+    p->updated_at = v["updated_at"].asInt64();
+    p->level = v["level"].asUInt();
+    p->exp = v["exp"].asUInt();
+    p->avatar = v["avatar"].asString();
+    p->phone = v["phone"].asString();
+    p->verified = v["verified"].asBool();
+    p->roles.clear();
+    for (auto& role : v["roles"]) {
+        p->roles.push_back(role.asInt());
+    }
+    p->locale = v["locale"].asString();
+    return true;
+}
+
+/* 经由Json::Value编码 */
+void dom_encode(const Profile& p, Json::Value* v) {
+    Json::Value& root = *v;
+    root["uid"] = static_cast<Json::Int64>(p.uid);
+    root["name"] = p.name;
+    root["email"] = p.email;
+    root["age"] = p.age;
+    root["score"] = p.score;
+    root["vip"] = p.vip;
+    root["bio"] = p.bio;
+    root["tags"] = Json::arrayValue;
+    for (auto& tag : p.tags) {
+        root["tags"].append(tag);
+    }
+    root["city"] = p.city;
+    root["zip"] = p.zip;
+    root["geo"]["lat"] = p.geo.lat;
+    root["geo"]["lng"] = p.geo.lng;
+    root["created_at"] = static_cast<Json::Int64>(p.created_at);
+    root["updated_at"] = static_cast<Json::Int64>(p.updated_at);
+    root["level"] = p.level;
+    root["exp"] = p.exp;
+    root["avatar"] = p.avatar;
+    root["phone"] = p.phone;
+    root["verified"] = p.verified;
+    root["roles"] = Json::arrayValue;
+    for (int role : p.roles) {
+        root["roles"].append(role);
+    }
+    root["locale"] = p.locale;
+}
+
+/* 运行约1秒，返回每秒次数 */
+double measure(const std::function<void()>& func) {
+    size_t times = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    while (elapsed < std::chrono::seconds(1)) {
+        for (int i = 0; i < 100; ++i) {
+            func();
+        }
+        times += 100;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    return times / (std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1e6);
+}
+
+int main() {
+    using namespace ic::uds;
+    Profile profile = make_profile();
+
+    /* 检查结果一致(整数的intValue和uintValue不区分，比较序列化的结果) */
+    Json::Value dom;
+    dom_encode(profile, &dom);
+    std::string expected;
+    json::Write(dom, &expected);
+    std::string text;
+    typed::EncodeJson(profile, &text);
+    Json::Value parsed;
+    std::string actual;
+    bool same = json::Parse(text.data(), text.data() + text.length(), &parsed);
+    json::Write(parsed, &actual);
+    same = same && actual == expected;
+    Profile decoded;
+    same = same && typed::DecodeJson(text.data(), text.data() + text.length(), &decoded)
+        && decoded.bio == profile.bio && decoded.roles == profile.roles && decoded.geo.lng == profile.geo.lng;
+    printf("text: %lu bytes, result %s\n", text.length(), same ? "identical" : "DIFFERENT");
+
+    double dom_parse = measure([&]{
+        Json::Value v;
+        Profile p;
+        json::Parse(text.data(), text.data() + text.length(), &v);
+        dom_decode(v, &p);
+    });
+    double typed_parse = measure([&]{
+        Profile p;
+        typed::DecodeJson(text.data(), text.data() + text.length(), &p);
+    });
+    double dom_write = measure([&]{
+        Json::Value v;
+        std::string s;
+        dom_encode(profile, &v);
+        json::Write(v, &s);
+    });
+    double typed_write = measure([&]{
+        std::string s;
+        typed::EncodeJson(profile, &s);
+    });
+    printf("  decode  Json::Value %10.0f/s   typed %10.0f/s   %.2fx\n", dom_parse, typed_parse, typed_parse / dom_parse);
+    printf("  encode  Json::Value %10.0f/s   typed %10.0f/s   %.2fx\n", dom_write, typed_write, typed_write / dom_write);
+
+    /* 二进制编码 */
+    std::string binary;
+    typed::EncodeMsgpack(profile, &binary);
+    parsed = Json::Value();
+    actual.clear();
+    same = msgpack::Parse(binary.data(), binary.data() + binary.length(), &parsed);
+    json::Write(parsed, &actual);
+    same = same && actual == expected;
+    printf("binary: %lu bytes, result %s\n", binary.length(), same ? "identical" : "DIFFERENT");
+
+    double dom_binary_parse = measure([&]{
+        Json::Value v;
+        Profile p;
+        msgpack::Parse(binary.data(), binary.data() + binary.length(), &v);
+        dom_decode(v, &p);
+    });
+    double typed_binary_parse = measure([&]{
+        Profile p;
+        typed::DecodeMsgpack(binary.data(), binary.data() + binary.length(), &p);
+    });
+    double dom_binary_write = measure([&]{
+        Json::Value v;
+        std::string s;
+        dom_encode(profile, &v);
+        msgpack::Write(v, &s);
+    });
+    double typed_binary_write = measure([&]{
+        std::string s;
+        typed::EncodeMsgpack(profile, &s);
+    });
+    printf("  decode  Json::Value %10.0f/s   typed %10.0f/s   %.2fx\n",
+        dom_binary_parse, typed_binary_parse, typed_binary_parse / dom_binary_parse);
+    printf("  encode  Json::Value %10.0f/s   typed %10.0f/s   %.2fx\n",
+        dom_binary_write, typed_binary_write, typed_binary_write / dom_binary_write);
+    return 0;
+}
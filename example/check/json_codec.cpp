@@ -0,0 +1,273 @@
+/**
+ * JSON编解码与jsoncpp的差分检查(结果确定，固定随机数种子)
+ *
+ * 1. 随机生成的Json::Value：json::Write 的输出必须与 Json::FastWriter
+ *    (emitUTF8、omitEndingLineFeed、dropNullKeyValues) 逐字节一致.
+ * 2. 上述输出：json::Parse 与 Json::Reader 的解析结果(包括数值类型)必须一致.
+ * 3. 边界输入和随机截断、修改后的输入：json::Parse 成功时 Json::Reader 也必须成功且结果一致
+ *    (json::Parse 失败时调用方回退到 Json::Reader，不算错误).
+ * 4. Request::Serialize 的输出(文本和二进制封装)：Request::PeekPath 必须读到请求路径.
+ *
+ * 全部一致时返回0，否则打印前几个不一致的样本并返回1.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <jsoncpp/json/json.h>
+#include "uds/json/json_codec.h"
+#include "uds/json/request.h"
+
+/* 固定种子的伪随机数(splitmix64) */
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+    uint64_t Next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    size_t Below(size_t n) { return static_cast<size_t>(Next() % n); }
+private:
+    uint64_t state_;
+};
+
+static Random s_random(20230423);
+static int s_failures = 0;
+
+static void report(const char* what, const std::string& input, const std::string& expected, const std::string& actual) {
+    if (++s_failures > 5) {
+        return;
+    }
+    printf("MISMATCH %s\n  input:    %s\n  expected: %s\n  actual:   %s\n", what, input.c_str(), expected.c_str(), actual.c_str());
+}
+
+/* 包含需要转义的字符、控制字符、多字节UTF-8字符，长度覆盖SIMD的16字节分组边界 */
+static std::string random_string() {
+    static const char* kPieces[] = {
+        "a", "b", "Z", "0", " ", "/", "\"", "\\", "\n", "\t", "\r", "\b", "\f", "\x01", "\x1f", "\x7f",
+        "\xc3\xa9", "\xe4\xb8\xad", "\xf0\x9f\x98\x80", "<", ">", "&", "'",
+    };
+    static const size_t kLengths[] = { 0, 1, 2, 7, 15, 16, 17, 31, 32, 33, 64, 100 };
+    size_t length = kLengths[s_random.Below(sizeof(kLengths) / sizeof(kLengths[0]))];
+    std::string str;
+    /* 大部分字符串没有需要转义的字符 */
+    bool plain = s_random.Below(2) == 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (plain) {
+            str.push_back(static_cast<char>('a' + s_random.Below(26)));
+        }
+        else {
+            str += kPieces[s_random.Below(sizeof(kPieces) / sizeof(kPieces[0]))];
+        }
+    }
+    return str;
+}
+
+static Json::Value random_number() {
+    static const Json::Int64 kInts[] = {
+        0, 1, -1, 9, 10, 99, 2147483647LL, 2147483648LL, -2147483648LL, -2147483649LL,
+        9223372036854775807LL, -9223372036854775807LL - 1,
+    };
+    static const double kDoubles[] = {
+        0.0, -0.0, 0.1, 0.5, 1.0, -1.5, 1e-7, 1e21, 1e22, 1e300, -1e-300, 3.141592653589793, 123456789.125, 5e-324,
+    };
+    switch (s_random.Below(6)) {
+    case 0:
+        return Json::Value(kInts[s_random.Below(sizeof(kInts) / sizeof(kInts[0]))]);
+    case 1:
+        return Json::Value(static_cast<Json::Int64>(s_random.Next()) >> s_random.Below(64));
+    case 2:
+        return Json::Value(static_cast<Json::UInt64>(s_random.Next()) >> s_random.Below(64));
+    case 3:
+        return Json::Value(kDoubles[s_random.Below(sizeof(kDoubles) / sizeof(kDoubles[0]))]);
+    case 4: {
+        /* 任意的有限浮点数 */
+        double value;
+        do {
+            uint64_t bits = s_random.Next();
+            memcpy(&value, &bits, sizeof(value));
+        } while (!std::isfinite(value));
+        return Json::Value(value);
+    }
+    default:
+        return Json::Value(static_cast<double>(static_cast<int64_t>(s_random.Below(2000000)) - 1000000) / 1000.0);
+    }
+}
+
+static Json::Value random_value(int depth) {
+    size_t kind = s_random.Below(depth > 3 ? 5 : 7);
+    switch (kind) {
+    case 0: return Json::Value();
+    case 1: return Json::Value(s_random.Below(2) == 0);
+    case 2: return random_number();
+    case 3:
+    case 4: return Json::Value(random_string());
+    case 5: {
+        Json::Value array(Json::arrayValue);
+        size_t n = s_random.Below(6);
+        for (size_t i = 0; i < n; ++i) {
+            array.append(random_value(depth + 1));
+        }
+        return array;
+    }
+    default: {
+        Json::Value object(Json::objectValue);
+        size_t n = s_random.Below(6);
+        for (size_t i = 0; i < n; ++i) {
+            object[random_string()] = random_value(depth + 1);
+        }
+        return object;
+    }
+    }
+}
+
+static std::string fast_write(const Json::Value& value) {
+    Json::FastWriter writer;
+    writer.emitUTF8();
+    writer.omitEndingLineFeed();
+    writer.dropNullKeyValues();
+    return writer.write(value);
+}
+
+/* 类型和值都相同(Json::Value::operator== 不区分 -0.0 和 0.0，这里也不区分) */
+static bool same(const Json::Value& a, const Json::Value& b) {
+    return a.type() == b.type() && a == b;
+}
+
+static bool same_recursive(const Json::Value& a, const Json::Value& b) {
+    if (!same(a, b)) {
+        return false;
+    }
+    if (a.isArray()) {
+        for (Json::ArrayIndex i = 0; i < a.size(); ++i) {
+            if (!same_recursive(a[i], b[i])) {
+                return false;
+            }
+        }
+    }
+    else if (a.isObject()) {
+        for (auto iter = a.begin(); iter != a.end(); ++iter) {
+            if (!same_recursive(*iter, b[iter.name()])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* json::Parse 成功时，必须与 Json::Reader 的结果一致 */
+static void check_parse(const char* what, const std::string& text, bool must_succeed) {
+    Json::Value actual;
+    bool codec_ok = ic::uds::json::Parse(text.data(), text.data() + text.length(), &actual);
+    Json::Reader reader;
+    Json::Value expected;
+    bool reader_ok = reader.parse(text.data(), text.data() + text.length(), expected, false);
+    if (must_succeed && !codec_ok) {
+        report(what, text, "parsed", "rejected");
+    }
+    else if (codec_ok && !reader_ok) {
+        report(what, text, "rejected by Json::Reader", fast_write(actual));
+    }
+    else if (codec_ok && !same_recursive(expected, actual)) {
+        report(what, text, fast_write(expected), fast_write(actual));
+    }
+}
+
+static void check_generated(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        Json::Value value = random_value(0);
+        std::string expected = fast_write(value);
+        std::string actual;
+        ic::uds::json::Write(value, &actual);
+        if (actual != expected) {
+            report("write", expected, expected, actual);
+            continue;
+        }
+        check_parse("parse", expected, true);
+
+        /* 截断或修改一个字节 */
+        if (!expected.empty()) {
+            std::string mutated = expected.substr(0, s_random.Below(expected.length()));
+            check_parse("parse truncated", mutated, false);
+            mutated = expected;
+            static const char kBytes[] = "{}[]\":,\\ 0-1e.tnfu";
+            mutated[s_random.Below(mutated.length())] = kBytes[s_random.Below(sizeof(kBytes) - 1)];
+            check_parse("parse mutated", mutated, false);
+        }
+    }
+}
+
+static void check_edge_cases() {
+    static const char* kInputs[] = {
+        "", " ", "{", "}", "[", "[1,]", "[,1]", "{\"a\":1,}", "{,}", "{\"a\" 1}", "{\"a\":}", "{1:2}", "[1 2]", "1 2",
+        "01", "-01", "1.", ".5", "-", "+1", "1e", "1e+", "1E2", "1e-2", "0.1e1", "-0.0", "1e400", "-1e400", "1e-400",
+        "2147483647", "2147483648", "-2147483648", "-2147483649", "4294967296",
+        "9223372036854775807", "9223372036854775808", "-9223372036854775808", "-9223372036854775809",
+        "18446744073709551615", "18446744073709551616", "123456789012345678901234567890",
+        "true", "false", "null", "tru", "nul", "falsee", "True",
+        "\"abc", "\"\\x\"", "\"\\u00e9\"", "\"\\u4e2d\"", "\"\\ud83d\\ude00\"", "\"\\ud800\"", "\"\\udc00\"", "\"\\u0000\"",
+        "\"\\/\\b\\f\\n\\r\\t\\\"\\\\\"", "\"\t\"", "\"a\nb\"",
+        "[]", "{}", "[[]]", "[{}]", "{\"a\":{}}", "  {\"a\" : [ 1 , 2 ] , \"b\" : null }  ", "\n\r\t[1]\n",
+        "{\"a\":1,\"a\":2}", "{\"\":0}", "[1,[2,[3,[4,[5]]]]]",
+    };
+    for (const char* input : kInputs) {
+        check_parse("edge", input, false);
+    }
+
+    /* 较深的嵌套 */
+    std::string nested = std::string(200, '[') + std::string(200, ']');
+    check_parse("nested", nested, false);
+}
+
+/* 序列化接口只对Client开放 */
+class SerializableRequest : public ic::uds::Request {
+public:
+    using Request::Request;
+    using Request::Serialize;
+};
+
+/* Request::PeekPath 依赖序列化结果中":path"为最后一个键 */
+static void check_peek_path(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        std::string path = "/";
+        size_t segments = 1 + s_random.Below(4);
+        for (size_t j = 0; j < segments; ++j) {
+            path += "seg" + std::to_string(s_random.Below(1000)) + (j + 1 < segments ? "/" : "");
+        }
+        for (bool binary : { false, true }) {
+            SerializableRequest req(path);
+            req.set_binary(binary);
+            req["value"] = random_value(1);
+            if (s_random.Below(3) == 0) {
+                req.AddBody("file", random_string());
+            }
+            std::string head;
+            std::vector<std::string_view> buffers;
+            req.Serialize(&head, &buffers);
+            std::string data;
+            for (const auto& buffer : buffers) {
+                data.append(buffer.data(), buffer.size());
+            }
+            std::string_view peeked;
+            if (!ic::uds::Request::PeekPath(data, &peeked) || peeked != path) {
+                report(binary ? "peek path (binary)" : "peek path", path, path, std::string(peeked));
+            }
+        }
+    }
+}
+
+int main() {
+    check_generated(20000);
+    check_edge_cases();
+    check_peek_path(2000);
+    if (s_failures > 0) {
+        printf("json_codec: %d mismatches\n", s_failures);
+        return 1;
+    }
+    printf("json_codec: identical to jsoncpp\n");
+    return 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * LZ4块格式编解码的差分检查(结果确定，固定随机数种子)
+ *
+ * 1. 各种数据(不可压缩、小字母表、短周期重复、长字面量、超过64KB的偏移)压缩后解压，必须与原始数据一致；
+ *    输出缓冲区比原始数据小1字节时解压必须失败.
+ * 2. 截断、修改若干字节的压缩数据和随机数据：lz4_block::decompress 与逐字节复制的参考实现
+ *    结果必须一致(同时失败，或者输出相同).
+ * 3. util::compress/util::decompress(带原始长度的头部)往返一致，损坏的数据不越界.
+ *
+ * 输出缓冲区按实际容量在堆上分配，使用 -fsanitize=address 编译时可以发现越界读写.
+ * 全部一致时返回0，否则打印前几个不一致的样本并返回1.
+ */
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <lz4/lz4_block.h>
+#include "uds/base/impl/util/compress.h"
+
+/* 固定种子的伪随机数(splitmix64) */
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+    uint64_t Next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    size_t Below(size_t n) { return static_cast<size_t>(Next() % n); }
+private:
+    uint64_t state_;
+};
+
+static Random s_random(20230412);
+static int s_failures = 0;
+
+static void report(const char* what, size_t input_size, long expected, long actual) {
+    if (++s_failures > 5) {
+        return;
+    }
+    printf("MISMATCH %s\n  input:    %lu bytes\n  expected: %ld\n  actual:   %ld\n", what, input_size, expected, actual);
+}
+
+/* 参考实现：按格式逐字节解码，不使用8字节复制 */
+static long reference_decompress(const std::string& src, size_t capacity, std::string* out) {
+    out->clear();
+    size_t ip = 0, len = src.length();
+    while (ip < len) {
+        uint8_t token = static_cast<uint8_t>(src[ip++]);
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t b;
+            do {
+                if (ip >= len) {
+                    return -1;
+                }
+                b = static_cast<uint8_t>(src[ip++]);
+                literals += b;
+            } while (b == 255);
+        }
+        if (literals > len - ip || literals > capacity - out->length()) {
+            return -1;
+        }
+        out->append(src, ip, literals);
+        ip += literals;
+        if (ip == len) {
+            break;
+        }
+        if (len - ip < 2) {
+            return -1;
+        }
+        size_t offset = static_cast<uint8_t>(src[ip]) | (static_cast<size_t>(static_cast<uint8_t>(src[ip + 1])) << 8);
+        ip += 2;
+        if (offset == 0 || offset > out->length()) {
+            return -1;
+        }
+        size_t match_len = token & 15;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= len) {
+                    return -1;
+                }
+                b = static_cast<uint8_t>(src[ip++]);
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += 4;
+        if (match_len > capacity - out->length()) {
+            return -1;
+        }
+        for (size_t i = 0; i < match_len; ++i) {
+            out->push_back((*out)[out->length() - offset]);
+        }
+    }
+    return static_cast<long>(out->length());
+}
+
+/* 解压到恰好为capacity字节的堆缓冲区 */
+static long block_decompress(const std::string& src, size_t capacity, std::string* out) {
+    std::unique_ptr<char[]> buffer(new char[capacity > 0 ? capacity : 1]);
+    std::unique_ptr<char[]> input(new char[src.length() > 0 ? src.length() : 1]);
+    std::copy(src.begin(), src.end(), input.get());
+    long n = lz4_block::decompress(input.get(), src.length(), buffer.get(), capacity);
+    out->assign(buffer.get(), n > 0 ? static_cast<size_t>(n) : 0);
+    return n;
+}
+
+static std::string block_compress(const std::string& data) {
+    std::string out(lz4_block::compress_bound(data.length()), '\0');
+    size_t n = lz4_block::compress(data.data(), data.length(), &out[0], out.length());
+    out.resize(n);
+    return out;
+}
+
+static void check_decode(const char* what, const std::string& src, size_t capacity) {
+    std::string expected, actual;
+    long expected_n = reference_decompress(src, capacity, &expected);
+    long actual_n = block_decompress(src, capacity, &actual);
+    if (expected_n != actual_n || (expected_n >= 0 && expected != actual)) {
+        report(what, src.length(), expected_n, actual_n);
+    }
+}
+
+static std::string random_bytes(size_t size, size_t alphabet) {
+    std::string data(size, '\0');
+    for (auto& c : data) {
+        c = static_cast<char>(s_random.Below(alphabet));
+    }
+    return data;
+}
+
+/* 各种形态的数据 */
+static std::vector<std::string> make_inputs() {
+    std::vector<std::string> inputs;
+    static const size_t kSizes[] = { 0, 1, 4, 5, 11, 12, 13, 16, 17, 64, 255, 256, 270, 1000, 4096, 65536, 70000 };
+    for (size_t size : kSizes) {
+        inputs.push_back(random_bytes(size, 256));
+        inputs.push_back(random_bytes(size, 4));
+        inputs.push_back(std::string(size, 'a'));
+    }
+    /* 周期小于8(重叠复制)和较长的周期，匹配长度超过15+255 */
+    for (size_t period = 1; period <= 20; ++period) {
+        std::string unit = random_bytes(period, 256);
+        std::string data;
+        while (data.length() < 3000 + period * 37) {
+            data += unit;
+        }
+        inputs.push_back(data);
+    }
+    /* 长字面量之后的重复 */
+    for (size_t literals : { 14, 15, 16, 269, 270, 271, 600 }) {
+        std::string head = random_bytes(literals, 256);
+        inputs.push_back(head + head + random_bytes(20, 256) + head);
+    }
+    /* 偏移接近和超过64KB */
+    std::string block = random_bytes(4096, 256);
+    inputs.push_back(block + random_bytes(65535 - 4096, 256) + block);
+    inputs.push_back(block + random_bytes(65536 - 4096, 256) + block);
+    /* JSON文本 */
+    std::string json = "{\"records\":[";
+    for (int i = 0; i < 2000; ++i) {
+        json += "{\"id\":" + std::to_string(100000 + i * 7) + ",\"name\":\"user_" + std::to_string(i) + "\",\"active\":true},";
+    }
+    json += "{}]}";
+    inputs.push_back(json);
+    return inputs;
+}
+
+static void check_round_trip(const std::vector<std::string>& inputs) {
+    for (const auto& data : inputs) {
+        std::string compressed = block_compress(data);
+        if (compressed.empty()) {
+            report("compress", data.length(), 1, 0);
+            continue;
+        }
+        std::string out;
+        long n = block_decompress(compressed, data.length(), &out);
+        if (n != static_cast<long>(data.length()) || out != data) {
+            report("round trip", data.length(), static_cast<long>(data.length()), n);
+        }
+        check_decode("decode", compressed, data.length());
+        check_decode("decode larger capacity", compressed, data.length() + 100);
+        if (!data.empty() && block_decompress(compressed, data.length() - 1, &out) != -1) {
+            report("decode smaller capacity", data.length(), -1, static_cast<long>(out.length()));
+        }
+    }
+}
+
+static void check_corrupted(const std::vector<std::string>& inputs, size_t rounds) {
+    for (size_t round = 0; round < rounds; ++round) {
+        const std::string& data = inputs[s_random.Below(inputs.size())];
+        if (data.length() > 5000) {
+            continue;
+        }
+        std::string compressed = block_compress(data);
+        std::string truncated = compressed.substr(0, s_random.Below(compressed.length() + 1));
+        check_decode("decode truncated", truncated, data.length());
+        std::string mutated = compressed;
+        for (size_t i = 0, n = 1 + s_random.Below(3); i < n && !mutated.empty(); ++i) {
+            mutated[s_random.Below(mutated.length())] = static_cast<char>(s_random.Below(256));
+        }
+        check_decode("decode mutated", mutated, data.length());
+        check_decode("decode mutated", mutated, s_random.Below(data.length() + 64));
+        check_decode("decode random", random_bytes(s_random.Below(64), 256), s_random.Below(256));
+    }
+}
+
+static void check_wrapper(const std::vector<std::string>& inputs) {
+    for (const auto& data : inputs) {
+        std::string compressed, out;
+        if (!ic::uds::util::compress(data, &compressed)) {
+            continue;  /* 压缩后没有变小 */
+        }
+        if (!ic::uds::util::decompress(compressed, &out) || out != data) {
+            report("wrapper round trip", data.length(), static_cast<long>(data.length()), static_cast<long>(out.length()));
+        }
+        for (size_t i = 0; i < 20; ++i) {
+            std::string mutated = compressed;
+            mutated[s_random.Below(mutated.length())] = static_cast<char>(s_random.Below(256));
+            ic::uds::util::decompress(mutated, &out);
+            ic::uds::util::decompress(compressed.substr(0, s_random.Below(compressed.length())), &out);
+        }
+    }
+}
+
+int main() {
+    std::vector<std::string> inputs = make_inputs();
+    check_round_trip(inputs);
+    check_corrupted(inputs, 200000);
+    check_wrapper(inputs);
+    if (s_failures > 0) {
+        printf("lz4: %d mismatches\n", s_failures);
+        return 1;
+    }
+    printf("lz4: identical to the reference decoder\n");
+    return 0;
+}
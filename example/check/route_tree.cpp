@@ -0,0 +1,278 @@
+/**
+ * 路由树与逐个路由匹配的参考实现的差分检查(结果确定，固定随机数种子)
+ *
+ * 随机生成一组路由(静态路径、参数、通配符，包括重复、参数名冲突和格式错误的路径)，
+ * 插入 RouteTree，再随机生成请求路径，检查：
+ * 1. Insert 的结果与参考实现一致(格式错误、重复、同一位置参数名不一致时失败).
+ * 2. Find 找到的路由和路径参数与参考实现一致.
+ *
+ * 参考实现依次尝试每个路由：请求路径的每个位置记为静态、参数或通配符，
+ * 第一个不同的位置上静态优先于参数，参数优先于通配符，取最优的路由.
+ *
+ * 全部一致时返回0，否则打印前几个不一致的样本并返回1.
+ */
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include "uds/json/router.h"
+
+/* 固定种子的伪随机数(splitmix64) */
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+    uint64_t Next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    size_t Below(size_t n) { return static_cast<size_t>(Next() % n); }
+private:
+    uint64_t state_;
+};
+
+static Random s_random(20230426);
+static int s_failures = 0;
+
+static void report(const char* what, const std::string& input, const std::string& expected, const std::string& actual) {
+    if (++s_failures > 5) {
+        return;
+    }
+    printf("MISMATCH %s\n  input:    %s\n  expected: %s\n  actual:   %s\n", what, input.c_str(), expected.c_str(), actual.c_str());
+}
+
+/* 路径中的一段：静态文本、参数(':')或通配符('*') */
+struct Token {
+    char kind;
+    std::string text;
+};
+
+/* 参考实现的路由 */
+struct ReferenceRoute {
+    std::string path;
+    std::vector<Token> tokens;
+    const ic::uds::Route* route;
+};
+
+enum Kind { kStatic = 0, kParam = 1, kWildcard = 2 };
+
+/* 与RouteTree相同的格式规则：参数和通配符位于路径段的开头 */
+static bool tokenize(const std::string& path, std::vector<Token>* tokens) {
+    if (path.empty() || path[0] != '/') {
+        return false;
+    }
+    size_t pos = 0, params = 0;
+    while (pos < path.length()) {
+        bool param_start = pos > 0 && path[pos - 1] == '/' && (path[pos] == ':' || path[pos] == '*');
+        if (param_start) {
+            size_t end = path.find('/', pos);
+            if (end == std::string::npos) {
+                end = path.length();
+            }
+            if (end == pos + 1 || (path[pos] == '*' && end != path.length()) || ++params > ic::uds::PathParams::kMaxCount) {
+                return false;
+            }
+            tokens->push_back(Token{ path[pos], path.substr(pos + 1, end - pos - 1) });
+            pos = end;
+            continue;
+        }
+        if (tokens->empty() || tokens->back().kind != '/') {
+            tokens->push_back(Token{ '/', std::string() });
+        }
+        tokens->back().text.push_back(path[pos++]);
+    }
+    return true;
+}
+
+/* 路由前缀(到参数之前)相同、参数名不同 */
+static bool conflicts(const std::vector<ReferenceRoute>& routes, const std::string& path) {
+    for (size_t pos = 1; pos < path.length(); ++pos) {
+        if ((path[pos] != ':' && path[pos] != '*') || path[pos - 1] != '/') {
+            continue;
+        }
+        size_t end = path.find('/', pos);
+        std::string name = path.substr(pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+        for (const auto& route : routes) {
+            const std::string& other = route.path;
+            if (other.compare(0, pos + 1, path, 0, pos + 1) != 0) {
+                continue;
+            }
+            size_t other_end = other.find('/', pos);
+            std::string other_name = other.substr(pos + 1, other_end == std::string::npos ? std::string::npos : other_end - pos - 1);
+            if (other_name != name) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* 匹配成功时返回每个位置的类型(最后一个元素表示路径末尾)，参数名重复时 PathParams::Get 返回第一个 */
+static bool reference_match(const ReferenceRoute& route, const std::string& path, std::vector<int>* kinds,
+    std::map<std::string, std::string>* params)
+{
+    size_t pos = 0;
+    int end_kind = kStatic;
+    for (const auto& token : route.tokens) {
+        if (token.kind == '/') {
+            if (path.compare(pos, token.text.length(), token.text) != 0) {
+                return false;
+            }
+            kinds->insert(kinds->end(), token.text.length(), kStatic);
+            pos += token.text.length();
+        }
+        else if (token.kind == ':') {
+            size_t end = path.find('/', pos);
+            if (end == std::string::npos) {
+                end = path.length();
+            }
+            if (end == pos) {
+                return false;
+            }
+            kinds->insert(kinds->end(), end - pos, kParam);
+            params->emplace(token.text, path.substr(pos, end - pos));
+            pos = end;
+        }
+        else {
+            kinds->insert(kinds->end(), path.length() - pos, kWildcard);
+            params->emplace(token.text, path.substr(pos));
+            pos = path.length();
+            end_kind = kWildcard;
+        }
+    }
+    if (pos != path.length()) {
+        return false;
+    }
+    kinds->push_back(end_kind);
+    return true;
+}
+
+static const ReferenceRoute* reference_find(const std::vector<ReferenceRoute>& routes, const std::string& path,
+    std::map<std::string, std::string>* params)
+{
+    const ReferenceRoute* best = nullptr;
+    std::vector<int> best_kinds;
+    for (const auto& route : routes) {
+        std::vector<int> kinds;
+        std::map<std::string, std::string> route_params;
+        if (reference_match(route, path, &kinds, &route_params) && (!best || kinds < best_kinds)) {
+            best = &route;
+            best_kinds = std::move(kinds);
+            *params = std::move(route_params);
+        }
+    }
+    return best;
+}
+
+static std::string random_path(bool pattern) {
+    static const char* kSegments[] = { "a", "ab", "abc", "b", "user", "users", "u", "1", "42", "", "a:b", "x*" };
+    static const char* kParams[] = { ":id", ":name", ":id", ":x" };
+    static const char* kWildcards[] = { "*rest", "*file" };
+    std::string path;
+    size_t segments = 1 + s_random.Below(4);
+    for (size_t i = 0; i < segments; ++i) {
+        path.push_back('/');
+        size_t choice = s_random.Below(10);
+        if (pattern && choice < 2) {
+            path += kParams[s_random.Below(sizeof(kParams) / sizeof(kParams[0]))];
+        }
+        else if (pattern && choice == 2) {
+            path += kWildcards[s_random.Below(sizeof(kWildcards) / sizeof(kWildcards[0]))];
+            /* 偶尔生成通配符不在末尾的错误路径 */
+            if (s_random.Below(4) != 0) {
+                break;
+            }
+        }
+        else {
+            path += kSegments[s_random.Below(sizeof(kSegments) / sizeof(kSegments[0]))];
+        }
+    }
+    if (s_random.Below(8) == 0) {
+        path.push_back('/');
+    }
+    return path;
+}
+
+static std::string describe(const ReferenceRoute* route, const std::map<std::string, std::string>& params) {
+    if (!route) {
+        return "(none)";
+    }
+    std::string text = route->path;
+    for (const auto& param : params) {
+        text += " " + param.first + "=" + param.second;
+    }
+    return text;
+}
+
+static void check_round(size_t routes_count, size_t lookups) {
+    auto handler = [](ic::uds::Request&, ic::uds::Response&){};
+    std::vector<std::unique_ptr<ic::uds::Route>> storage;
+    std::vector<ReferenceRoute> routes;
+    ic::uds::RouteTree tree;
+
+    for (size_t i = 0; i < routes_count; ++i) {
+        std::string path = random_path(true);
+        if (s_random.Below(20) == 0) {
+            path = path.substr(1);  /* 不以'/'开头 */
+        }
+        storage.emplace_back(new ic::uds::Route(path, handler));
+        ReferenceRoute route{ path, {}, storage.back().get() };
+        bool expected = tokenize(path, &route.tokens) && !conflicts(routes, path);
+        for (const auto& other : routes) {
+            expected = expected && other.path != path;
+        }
+        bool actual = tree.Insert(path, route.route);
+        if (actual != expected) {
+            report("insert", path, expected ? "inserted" : "rejected", actual ? "inserted" : "rejected");
+        }
+        if (actual) {
+            routes.push_back(std::move(route));
+        }
+    }
+
+    for (size_t i = 0; i < lookups; ++i) {
+        std::string path = random_path(false);
+        /* 已注册的路由本身，参数替换为路径段 */
+        if (!routes.empty() && s_random.Below(2) == 0) {
+            path.clear();
+            for (const auto& token : routes[s_random.Below(routes.size())].tokens) {
+                path += (token.kind == '/') ? token.text : (token.kind == ':' ? "42" : "x/y.txt");
+            }
+        }
+        std::map<std::string, std::string> expected_params;
+        const ReferenceRoute* expected = reference_find(routes, path, &expected_params);
+        ic::uds::PathParams params;
+        const ic::uds::Route* found = tree.Find(path, &params);
+        const ReferenceRoute* actual = nullptr;
+        std::map<std::string, std::string> actual_params;
+        for (const auto& route : routes) {
+            if (route.route == found) {
+                actual = &route;
+            }
+        }
+        for (size_t j = 0; j < params.size(); ++j) {
+            actual_params[std::string(params[j].name)] = std::string(params.Get(path, params[j].name));
+        }
+        if (found && !actual) {
+            report("find", path, describe(expected, expected_params), "(unknown route)");
+        }
+        else if (actual != expected || (actual && actual_params != expected_params)) {
+            report("find", path, describe(expected, expected_params), describe(actual, actual_params));
+        }
+    }
+}
+
+int main() {
+    for (size_t round = 0; round < 2000; ++round) {
+        check_round(1 + s_random.Below(30), 200);
+    }
+    if (s_failures > 0) {
+        printf("route_tree: %d mismatches\n", s_failures);
+        return 1;
+    }
+    printf("route_tree: identical to the reference matcher\n");
+    return 0;
+}
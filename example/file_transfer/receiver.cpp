@@ -1,13 +1,21 @@
 #include <chrono>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdio.h>
+#include <string.h>
 #include <signal.h>
 #include "uds/base/base_server.h"
 
 std::shared_ptr<ic::uds::BaseServer> g_server;
 const char* socket_file = "/dev/shm/.file_receiver.sock";
 const size_t thread_pool_size = 4;
+const char* recv_prefix = "/dev/shm/recv_";
+
+/* 接收中的文件，键为 客户端地址+数据流ID */
+std::mutex g_files_mutex;
+std::map<std::pair<std::string, int64_t>, std::pair<std::string, std::shared_ptr<std::ofstream>>> g_files;
 
 /**
  * @brief 捕获Ctrl+C事件
@@ -37,26 +45,78 @@ int main() {
     }
 
     /*
-     * 3. 接收到请求后的回调函数
+     * 3. 接收到数据流后的回调函数，边接收边写入文件
      */
-    g_server->set_request_callback([](ic::uds::BaseServer* server, const sockaddr_un& client_addr, int64_t request_id, const std::string& data){
-        printf(
-            "client: %s\nrequest_id: %ld\ndata length: %lu\n\n",
-            client_addr.sun_path, request_id, data.length()
-        );
-        std::string filename = "/dev/shm/recv_" + std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-        std::ofstream ofs(filename);
-        if (ofs) {
-            ofs.write(data.data(), data.size());
-            server->SendResponse(client_addr, request_id, filename);
+    g_server->set_stream_callback([](ic::uds::BaseServer* server, const ic::uds::RequestContext& context, ic::uds::StreamEvent event, const std::string& chunk){
+        auto key = std::make_pair(std::string(context.client_addr.sun_path), context.request_id);
+        std::unique_lock<std::mutex> lck(g_files_mutex);
+        auto iter = g_files.find(key);
+        if (iter == g_files.end()) {
+            std::string filename = recv_prefix + std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+            auto ofs = std::make_shared<std::ofstream>(filename, std::ios::out | std::ios::binary);
+            iter = g_files.emplace(key, std::make_pair(filename, ofs)).first;
+        }
+        std::string filename = iter->second.first;
+        std::shared_ptr<std::ofstream> ofs = iter->second.second;
+        if (event != ic::uds::StreamEvent::Data) {
+            g_files.erase(iter);
+        }
+        lck.unlock();
+
+        /* 同一个数据流的事件不会并发调用 */
+        switch (event) {
+        case ic::uds::StreamEvent::Data:
+            ofs->write(chunk.data(), chunk.size());
+            break;
+        case ic::uds::StreamEvent::End:
+            ofs->close();
+            printf(
+                "client: %s\nstream_id: %ld\nsaved to: %s\n\n",
+                context.client_addr.sun_path, context.request_id, filename.c_str()
+            );
+            server->SendResponse(context.client_addr, context.request_id, *ofs ? filename : "save failed");
+            break;
+        case ic::uds::StreamEvent::Abort:
+            ofs->close();
+            remove(filename.c_str());
+            break;
+        }
+    });
+
+    /*
+     * 4. 下载已接收的文件(请求内容为文件路径)，以响应数据流返回，每次读取1MB，不需要将整个文件读入内存
+     */
+    g_server->set_request_callback([](ic::uds::BaseServer* server, const ic::uds::RequestContext& context, const std::string& data){
+        /* 只允许下载接收到的文件 */
+        std::ifstream ifs;
+        if (data.compare(0, strlen(recv_prefix), recv_prefix) == 0 && data.find("..") == std::string::npos) {
+            ifs.open(data, std::ios::in | std::ios::binary);
+        }
+        if (!ifs.is_open()) {
+            server->SendResponse(context.client_addr, context.request_id, "file not found");
+            return;
+        }
+        std::error_code ec;
+        auto stream = server->OpenResponseStream(context.client_addr, context.request_id, 2000, ec);
+        if (ec) {
+            server->SendResponse(context.client_addr, context.request_id, ec.message());
+            return;
         }
-        else {
-            server->SendResponse(client_addr, request_id, "save failed");
+        std::string buffer(1024 * 1024, '\0');
+        while (ifs) {
+            ifs.read(&buffer[0], buffer.size());
+            stream->Write(buffer.data(), static_cast<size_t>(ifs.gcount()), ec);
+            if (ec) {
+                printf("download %s failed. %s\n", data.c_str(), ec.message().c_str());
+                return;  /* 析构时中止数据流 */
+            }
         }
+        stream->Finish(ec);
+        printf("client: %s\nsent: %s\n\n", context.client_addr.sun_path, data.c_str());
     });
 
     /*
-     * 4. 启动服务器
+     * 5. 启动服务器
      */
     printf("Receiver started. SocketFile=%s\n", socket_file);
     g_server->Start();
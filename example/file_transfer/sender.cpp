@@ -1,39 +1,85 @@
 #include <fstream>
+#include <stdio.h>
 #include "uds/base/base_client.h"
 
 const char* server_socket_file = "/dev/shm/.file_receiver.sock";
 const char* client_socket_file = "/dev/shm/.file_sender.sock";
 
+/**
+ * @brief 下载接收端保存的文件，响应以数据流接收，边接收边写入文件.
+ */
+int download(ic::uds::BaseClient& client, const std::string& remote_file, const std::string& local_file) {
+    std::ofstream ofs(local_file, std::ios::out | std::ios::binary);
+    if (!ofs) {
+        printf("[Error] Open local file failed\n");
+        return 2;
+    }
+    size_t received = 0;
+    std::string response;
+    std::error_code ec;
+    client.SendRequest(client.NewRequestId(), remote_file, [&ofs, &received](const char* data, size_t len){
+        ofs.write(data, len);
+        received += len;
+    }, &response, 2000, ic::uds::Priority::Low, ec);
+    ofs.close();
+    if (ec || !response.empty()) {
+        printf("[Error] Download failed. %s\n", ec ? ec.message().c_str() : response.c_str());
+        remove(local_file.c_str());
+        return 2;
+    }
+    printf("Download file: %s\n Saved to: %s (%lu bytes)\n", remote_file.c_str(), local_file.c_str(), received);
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        printf("Usage:\n  sender {filepath}\n");
+    bool download_mode = (argc == 4 && std::string(argv[1]) == "-d");
+    if (argc != 2 && !download_mode) {
+        printf("Usage:\n  sender {filepath}\n  sender -d {remote_filepath} {local_filepath}\n");
         return 1;
     }
 
-    /* 读取文件内容 */
+    /* 创建并初始化客户端 */
+    ic::uds::BaseClient client;
+    std::error_code ec;
+    client.Init(server_socket_file, client_socket_file, ec);
+    if (ec) {
+        printf("[Error] UDS.BaseClient init failed. %s\n", ec.message().c_str());
+        return 1;
+    }
+
+    if (download_mode) {
+        return download(client, argv[2], argv[3]);
+    }
+
+    /* 打开文件 */
     std::string filename(argv[1]);
     std::ifstream ifs(filename, std::ios::in | std::ios::binary);
     if (!ifs) {
         printf("[Error] Open local file failed\n");
         return 2;
     }
-    std::string content(std::istreambuf_iterator<char>(ifs.rdbuf()), std::istreambuf_iterator<char>());
-    ifs.close();
 
-    /* 创建并初始化客户端 */
-    ic::uds::BaseClient client;
-    std::error_code ec;
-    client.Init(server_socket_file, client_socket_file, ec);
+    /* 以数据流发送文件内容，每次读取1MB，不需要将整个文件读入内存 */
+    auto stream = client.OpenStream(2000, ic::uds::Priority::Low, ec);
     if (ec) {
-        printf("[Error] UDS.BaseClient init failed. %s\n", ec.message().c_str());
-        return 1;
+        printf("[Error] OpenStream() failed. %s\n", ec.message().c_str());
+        return 2;
+    }
+    std::string buffer(1024 * 1024, '\0');
+    while (ifs) {
+        ifs.read(&buffer[0], buffer.size());
+        stream->Write(buffer.data(), static_cast<size_t>(ifs.gcount()), ec);
+        if (ec) {
+            printf("[Error] Write() failed. %s\n", ec.message().c_str());
+            return 2;
+        }
     }
+    ifs.close();
 
-    /* 发送文件内容 */
     std::string response;
-    client.SendRequest(content, &response, 2000, ec);
+    stream->Finish(&response, 2000, ec);
     if (ec) {
-        printf("[Error] SendRequest() failed. %s\n", ec.message().c_str());
+        printf("[Error] Finish() failed. %s\n", ec.message().c_str());
         return 2;
     }
 
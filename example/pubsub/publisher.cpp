@@ -0,0 +1,61 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <stdio.h>
+#include <signal.h>
+#include "uds/base/base_server.h"
+
+std::shared_ptr<ic::uds::BaseServer> g_server;
+const char* socket_file = "/dev/shm/.publisher.sock";
+const size_t thread_pool_size = 2;
+std::atomic_bool g_running{true};
+
+/**
+ * @brief 捕获Ctrl+C事件
+ */
+void CatchCtrlC(int sig) {
+    g_running = false;
+    if (g_server) {
+        g_server->Stop();
+    }
+}
+
+int main() {
+    signal(SIGINT, CatchCtrlC);
+
+    /*
+     * 1. 创建并初始化服务器
+     */
+    g_server = std::make_shared<ic::uds::BaseServer>();
+    std::error_code ec;
+    g_server->Init(socket_file, thread_pool_size, ec);
+    if (ec) {
+        printf("[Error] UDS.BaseServer init failed. %s\n", ec.message().c_str());
+        return 1;
+    }
+
+    /*
+     * 2. 在其他线程中每秒发布一次行情，订阅由服务器自动处理
+     */
+    std::thread publisher([]{
+        int64_t price = 10000;
+        while (g_running) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            price += (rand() % 21) - 10;
+            char quote[64];
+            snprintf(quote, sizeof(quote), "AAPL %ld.%02ld", price / 100, price % 100);
+            size_t count = g_server->Publish("quote.AAPL", quote);
+            printf("publish: %s -> %lu subscribers\n", quote, count);
+        }
+    });
+
+    /*
+     * 3. 启动服务器
+     */
+    printf("Publisher started. SocketFile=%s\n", socket_file);
+    g_server->Start();
+    publisher.join();
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <chrono>
+#include <thread>
+#include <stdio.h>
+#include <unistd.h>
+#include "uds/base/base_client.h"
+
+const char* server_socket_file = "/dev/shm/.publisher.sock";
+
+int main() {
+    /* 创建并初始化客户端 */
+    ic::uds::BaseClient client;
+    std::error_code ec;
+    std::string client_socket_file = "/dev/shm/.subscriber_" + std::to_string(getpid()) + ".sock";
+    client.Init(server_socket_file, client_socket_file, ec);
+    if (ec) {
+        printf("[Error] UDS.BaseClient init failed. %s\n", ec.message().c_str());
+        return 1;
+    }
+
+    /* 接收发布的消息(在接收线程上调用) */
+    client.set_publish_callback([](const std::string& topic, const std::string& data){
+        printf("[%s] %s\n", topic.c_str(), data.c_str());
+    });
+    client.set_evicted_callback([]{
+        printf("[Warn] evicted by publisher\n");
+    });
+
+    /* 订阅一次，之后不再需要轮询 */
+    client.Subscribe({ "quote.AAPL" }, 1000, ec);
+    if (ec) {
+        printf("[Error] Subscribe() failed. %s\n", ec.message().c_str());
+        return 2;
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(10));
+
+    client.Unsubscribe({}, 1000, ec);
+    return 0;
+}
@@ -77,6 +77,11 @@ int main() {
     router->AddRoute("/hello", [](ic::uds::Request& req, ic::uds::Response& res){
         ResponseOk(res, "hello");
     });
+    ic::uds::RouteOptions health_options;
+    health_options.priority = ic::uds::Priority::High;  /* 不排在大数据量的请求后面 */
+    router->AddRoute("/health", "健康检查", health_options, [](ic::uds::Request& req, ic::uds::Response& res){
+        ResponseOk(res);
+    });
     router->AddRoute("/echo", [](ic::uds::Request& req, ic::uds::Response& res){
         if (!req["text"].isString()) {
             return ResponseInvalidParam(res);
@@ -105,7 +110,7 @@ int main() {
         if (ext[0] != '.') {
             ext = "." + ext;
         }
-        auto& image = req.GetBody("image"); /* 图片文件数据 */
+        auto image = req.GetBody("image"); /* 图片文件数据(引用接收缓冲区，不复制) */
         if (image.empty()) {
             return ResponseInvalidParam(res);
         }
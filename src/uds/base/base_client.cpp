@@ -1,4 +1,6 @@
 #include "base_client.h"
+#include <algorithm>
+#include "error_code.h"
 #include "impl/impl_base_client.h"
 
 namespace ic {
@@ -21,10 +23,86 @@ int64_t BaseClient::Send(const std::string& data, std::error_code& ec) {
     return impl_->Send(data, ec);
 }
 
+int64_t BaseClient::Send(const std::string& data, Priority priority, std::error_code& ec) {
+    return impl_->Send(data, priority, ec);
+}
+
 int64_t BaseClient::SendRequest(const std::string& data, std::string* response, uint32_t timeout_ms, std::error_code& ec) {
     return impl_->SendRequest(data, response, timeout_ms, ec);
 }
 
+int64_t BaseClient::SendRequest(const std::string& data, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec) {
+    return impl_->SendRequest(data, response, timeout_ms, priority, ec);
+}
+
+int64_t BaseClient::SendRequest(int64_t request_id, const std::string& data, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec) {
+    return impl_->SendRequest(request_id, data, response, timeout_ms, priority, ec);
+}
+
+int64_t BaseClient::SendRequest(int64_t request_id, const std::vector<std::string_view>& buffers, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec) {
+    return impl_->SendRequest(request_id, buffers, response, timeout_ms, priority, ec);
+}
+
+int64_t BaseClient::SendRequest(int64_t request_id, const std::vector<std::string_view>& buffers, std::string_view route_hint,
+    std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec)
+{
+    return impl_->SendRequest(request_id, buffers, route_hint, response, timeout_ms, priority, ec);
+}
+
+int64_t BaseClient::SendRequest(int64_t request_id, const std::string& data, const ResponseChunkCallback& on_chunk,
+    std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec)
+{
+    return impl_->SendRequest(request_id, data, on_chunk, response, timeout_ms, priority, ec);
+}
+
+int64_t BaseClient::NewRequestId() {
+    return impl_->NewRequestId();
+}
+
+void BaseClient::Cancel(int64_t request_id, std::error_code& ec) {
+    impl_->Cancel(request_id, ec);
+}
+
+std::unique_ptr<ClientStream> BaseClient::OpenStream(uint32_t timeout_ms, Priority priority, std::error_code& ec) {
+    int64_t id = impl_->OpenStream(ec);
+    if (ec) {
+        return nullptr;
+    }
+    return std::unique_ptr<ClientStream>(new ClientStream(impl_, id, priority, timeout_ms));
+}
+
+std::unique_ptr<ClientStream> BaseClient::OpenStream(uint32_t timeout_ms, std::error_code& ec) {
+    return OpenStream(timeout_ms, Priority::Normal, ec);
+}
+
+void BaseClient::set_stream_window(uint32_t packets) {
+    impl_->set_stream_window(packets);
+}
+
+void BaseClient::Subscribe(const std::vector<std::string>& topics, uint32_t timeout_ms, std::error_code& ec) {
+    impl_->Subscribe(topics, timeout_ms, true, ec);
+}
+
+void BaseClient::Unsubscribe(const std::vector<std::string>& topics, uint32_t timeout_ms, std::error_code& ec) {
+    impl_->Subscribe(topics, timeout_ms, false, ec);
+}
+
+void BaseClient::set_publish_callback(PublishCallback callback) {
+    impl_->set_publish_callback(callback);
+}
+
+void BaseClient::set_evicted_callback(EvictedCallback callback) {
+    impl_->set_evicted_callback(callback);
+}
+
+void BaseClient::set_compression(bool enabled, size_t threshold_bytes/* = 4096*/) {
+    impl_->set_compression(enabled, threshold_bytes);
+}
+
+void BaseClient::set_checksum(bool enabled) {
+    impl_->set_checksum(enabled);
+}
+
 const std::string& BaseClient::server_socket_file() const {
     return impl_->server_socket_file();
 }
@@ -33,5 +111,42 @@ const std::string& BaseClient::client_socket_file() const {
     return impl_->client_socket_file();
 }
 
+ClientStream::ClientStream(_detail::ImplBaseClient* client, int64_t id, Priority priority, uint32_t timeout_ms)
+    : client_(client), id_(id), priority_(priority), timeout_ms_(timeout_ms)
+{
+}
+
+ClientStream::~ClientStream() {
+    if (!finished_) {
+        client_->CloseStream(id_, true);
+    }
+}
+
+void ClientStream::Write(const char* data, size_t len, std::error_code& ec) {
+    if (finished_) {
+        ec = make_error_code(BaseErrc::NotInitialized);
+        return;
+    }
+    size_t chunk_size = client_->stream_chunk_size();
+    for (size_t pos = 0; pos < len; pos += chunk_size) {
+        size_t n = std::min(chunk_size, len - pos);
+        client_->WriteStream(id_, next_seq_, data + pos, n, priority_, timeout_ms_, ec);
+        if (ec) {
+            return;
+        }
+        ++next_seq_;
+    }
+    ec.clear();
+}
+
+void ClientStream::Finish(std::string* response, uint32_t timeout_ms, std::error_code& ec) {
+    if (finished_) {
+        ec = make_error_code(BaseErrc::NotInitialized);
+        return;
+    }
+    finished_ = true;
+    client_->FinishStream(id_, next_seq_, priority_, response, timeout_ms, ec);
+}
+
 } // namespace uds
 } // namespace ic
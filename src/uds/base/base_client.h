@@ -9,9 +9,14 @@
  */
 #ifndef IC_UDS_BASE_CLIENT_H_
 #define IC_UDS_BASE_CLIENT_H_
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <system_error>
+#include <vector>
 #include <sys/un.h>
+#include "priority.h"
 
 namespace ic {
 namespace uds {
@@ -20,6 +25,55 @@ namespace _detail {
 class ImplBaseClient;
 } // namespace _detail
 
+/**
+ * @brief 客户端数据流，通过 BaseClient::OpenStream() 创建.
+ * 
+ * @details 数据按顺序分块发送，服务端每处理完一个数据块就确认一次，
+ *          未确认的数据块达到窗口大小时Write阻塞，两端缓存的数据量都不超过窗口大小.
+ * @note 不能在BaseClient析构之后使用
+ */
+class ClientStream {
+public:
+    /**
+     * @brief 未调用Finish时取消数据流.
+     */
+    ~ClientStream();
+
+    /**
+     * @brief 数据流的ID(即请求ID).
+     */
+    int64_t id() const { return id_; }
+
+    /**
+     * @brief 写入数据，数据被拆分为若干数据块发送.
+     * 
+     * @details 等待窗口的时间超过打开数据流时指定的超时时间时，ec 为 BaseErrc::Timeout.
+     */
+    void Write(const char* data, size_t len, std::error_code& ec);
+    void Write(const std::string& data, std::error_code& ec) { Write(data.data(), data.length(), ec); }
+
+    /**
+     * @brief 结束数据流，等待服务器返回响应.
+     * 
+     * @param  response 服务器响应数据
+     * @param  timeout_ms 超时时间，单位：毫秒
+     * @param  ec 错误代码
+     */
+    void Finish(std::string* response, uint32_t timeout_ms, std::error_code& ec);
+
+private:
+    friend class BaseClient;
+    ClientStream(_detail::ImplBaseClient* client, int64_t id, Priority priority, uint32_t timeout_ms);
+
+private:
+    _detail::ImplBaseClient* client_;
+    int64_t id_;
+    Priority priority_;
+    uint32_t timeout_ms_;
+    uint32_t next_seq_{1};
+    bool finished_{false};
+};
+
 class BaseClient {
 public:
     BaseClient();
@@ -40,6 +94,17 @@ public:
      */
     int64_t Send(const std::string& data, std::error_code& ec);
 
+    /**
+     * @brief 仅发送数据，不等待服务器返回响应.
+     * 
+     * @param  data 待发送的数据
+     * @param  priority 优先级
+     * @param  ec 错误代码
+     * @return 当前请求的ID
+     * @note 通过 ec 判断是否成功
+     */
+    int64_t Send(const std::string& data, Priority priority, std::error_code& ec);
+
     /**
      * @brief 发送数据，等待服务器返回响应.
      * 
@@ -52,6 +117,156 @@ public:
      */
     int64_t SendRequest(const std::string& data, std::string* response, uint32_t timeout_ms, std::error_code& ec);
 
+    /**
+     * @brief 发送数据，等待服务器返回响应.
+     * 
+     * @param  data 待发送的数据
+     * @param  response 服务器响应数据
+     * @param  timeout_ms 超时时间，单位：毫秒
+     * @param  priority 优先级
+     * @param  ec 错误代码
+     * @return 当前请求的ID
+     * @note 通过 ec 判断是否成功
+     * @note 服务端过载时 ec 为 BaseErrc::Overloaded，response 为服务端建议的重试间隔(毫秒)
+     */
+    int64_t SendRequest(const std::string& data, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 使用指定的请求ID发送数据，等待服务器返回响应.
+     * 
+     * @details 请求ID通过 NewRequestId() 获取，其他线程可以在等待响应期间调用 Cancel() 取消该请求.
+     * @note 被取消时 ec 为 BaseErrc::Cancelled
+     */
+    int64_t SendRequest(int64_t request_id, const std::string& data, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 使用指定的请求ID发送多个片段(按顺序组成一个请求)，等待服务器返回响应.
+     * 
+     * @details 各片段不合并，分包时直接引用(sendmsg)，适合携带大数据体的请求.
+     * @details 服务端收到的数据与所有片段拼接后的数据相同.
+     */
+    int64_t SendRequest(int64_t request_id, const std::vector<std::string_view>& buffers, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 同上，并指定请求的路由(如JSON请求的路径).
+     * 
+     * @details 内容被压缩时，路由(不超过128字节)在头部扩展字段中携带，服务端的分类回调函数
+     *          通过 DispatchInfo::route_hint 读取，不必解压；未压缩时不携带.
+     */
+    int64_t SendRequest(int64_t request_id, const std::vector<std::string_view>& buffers, std::string_view route_hint,
+        std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 响应数据流的回调函数，在调用 SendRequest 的线程上按顺序调用.
+     */
+    using ResponseChunkCallback = std::function<void(
+            const char* data,  /* 数据块 */
+            size_t      len    /* 数据块长度 */
+        )>;
+
+    /**
+     * @brief 使用指定的请求ID发送数据，接收服务端以数据流返回的响应(BaseServer::OpenResponseStream).
+     * 
+     * @details 数据块按顺序交给回调函数，不合并为一个字符串；回调函数返回后才确认该数据块，
+     *          处理较慢时服务端的写入被阻塞(流量控制，窗口大小由服务端设置).
+     * @details 服务端返回普通响应(SendResponse)时不调用回调函数，响应写入 response；数据流正常结束时 response 为空.
+     * @note 服务端中止数据流时 ec 为 BaseErrc::Cancelled，已交给回调函数的数据不完整
+     * 
+     * @param  timeout_ms 等待响应(以及每个数据块)的超时时间，单位：毫秒
+     */
+    int64_t SendRequest(int64_t request_id, const std::string& data, const ResponseChunkCallback& on_chunk,
+        std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 分配一个新的请求ID.
+     */
+    int64_t NewRequestId();
+
+    /**
+     * @brief 取消请求.
+     * 
+     * @details 通知服务端不再需要该请求的响应：尚未开始处理的请求不再处理，正在处理中的请求被标记为已取消.
+     *          本地正在等待该请求响应的 SendRequest 立即返回 BaseErrc::Cancelled.
+     * 
+     * @param  request_id 请求ID
+     * @param  ec 错误代码
+     */
+    void Cancel(int64_t request_id, std::error_code& ec);
+
+    /**
+     * @brief 打开数据流，用于发送大小未知或者不适合一次性放入内存的数据.
+     * 
+     * @param  timeout_ms 每次写入时等待窗口的超时时间，单位：毫秒
+     * @param  priority 优先级
+     * @param  ec 错误代码
+     * @return 数据流，失败时返回空指针
+     */
+    std::unique_ptr<ClientStream> OpenStream(uint32_t timeout_ms, Priority priority, std::error_code& ec);
+    std::unique_ptr<ClientStream> OpenStream(uint32_t timeout_ms, std::error_code& ec);
+
+    /**
+     * @brief 设置数据流的窗口大小(未确认的数据块数量，每块约64KB)，默认为32.
+     * 
+     * @details 只用于发送的数据流，响应数据流的窗口由服务端设置(BaseServer::set_stream_window).
+     */
+    void set_stream_window(uint32_t packets);
+
+    /**
+     * @brief 订阅主题，之后服务端发布(BaseServer::Publish)到这些主题的消息通过发布回调函数接收.
+     * 
+     * @param  topics 主题列表，主题中不能包含'\0'
+     * @param  timeout_ms 等待服务端确认的超时时间，单位：毫秒
+     * @param  ec 错误代码
+     */
+    void Subscribe(const std::vector<std::string>& topics, uint32_t timeout_ms, std::error_code& ec);
+
+    /**
+     * @brief 取消订阅.
+     * 
+     * @param  topics 主题列表，为空表示取消全部
+     */
+    void Unsubscribe(const std::vector<std::string>& topics, uint32_t timeout_ms, std::error_code& ec);
+
+    /**
+     * @brief 收到服务端发布的消息后的回调函数.
+     * 
+     * @details 在接收线程上调用，应当尽可能快，耗时的处理请交给其他线程.
+     */
+    using PublishCallback = std::function<void(
+            const std::string& topic,  /* 主题 */
+            const std::string& data    /* 消息内容 */
+        )>;
+    void set_publish_callback(PublishCallback callback);
+
+    /**
+     * @brief 因接收过慢被服务端移除全部订阅后的回调函数(在接收线程上调用).
+     * 
+     * @details 期间可能丢失了消息，可以重新订阅.
+     */
+    using EvictedCallback = std::function<void()>;
+    void set_evicted_callback(EvictedCallback callback);
+
+    /**
+     * @brief 启用/禁用请求数据压缩.
+     * 
+     * @details 数据长度不小于阈值时使用LZ4压缩后发送(头部标志位标识)，服务端在工作线程中解压.
+     *          服务端响应是否压缩由服务端设置，客户端总能解压.
+     * @details 服务端在解压前分类请求，只能读取发送时指定的路由(route_hint)；
+     *          未指定路由的压缩请求按头部携带的优先级调度.
+     * 
+     * @param  enabled 是否启用，默认禁用
+     * @param  threshold_bytes 压缩阈值
+     */
+    void set_compression(bool enabled, size_t threshold_bytes = 4096);
+
+    /**
+     * @brief 启用/禁用请求数据的CRC32C校验.
+     * 
+     * @details 每个分包和完整消息都携带校验值，服务端校验失败时 SendRequest 返回 BaseErrc::ChecksumMismatch.
+     *          服务端响应是否携带校验值由服务端设置，客户端总会校验携带的校验值.
+     */
+    void set_checksum(bool enabled);
+
     const std::string& server_socket_file() const;
     const std::string& client_socket_file() const;
 
@@ -1,4 +1,6 @@
 #include "base_server.h"
+#include <algorithm>
+#include "error_code.h"
 #include "impl/impl_base_server.h"
 
 namespace ic {
@@ -29,10 +31,100 @@ bool BaseServer::SendResponse(const sockaddr_un& client_addr, int64_t request_id
     return impl_->SendResponse(client_addr, request_id, data);
 }
 
+bool BaseServer::SendResponse(const sockaddr_un& client_addr, int64_t request_id, const std::vector<std::string_view>& buffers) {
+    return impl_->SendResponse(client_addr, request_id, buffers);
+}
+
+std::unique_ptr<ResponseStream> BaseServer::OpenResponseStream(const sockaddr_un& client_addr, int64_t request_id, uint32_t timeout_ms, std::error_code& ec) {
+    impl_->OpenResponseStream(client_addr, request_id, ec);
+    if (ec) {
+        return nullptr;
+    }
+    return std::unique_ptr<ResponseStream>(new ResponseStream(impl_, client_addr, request_id, timeout_ms));
+}
+
+void BaseServer::set_stream_window(uint32_t packets) {
+    impl_->set_stream_window(packets);
+}
+
+size_t BaseServer::Publish(const std::string& topic, const std::string& data) {
+    return impl_->Publish(topic, data);
+}
+
+void BaseServer::set_subscriber_timeout_ms(uint32_t timeout_ms) {
+    impl_->set_subscriber_timeout_ms(timeout_ms);
+}
+
+size_t BaseServer::subscribers_count(const std::string& topic) const {
+    return impl_->subscribers_count(topic);
+}
+
+uint64_t BaseServer::evicted_subscribers_count() const {
+    return impl_->evicted_subscribers_count();
+}
+
 void BaseServer::set_request_callback(RequestCallback callback) {
+    if (!callback) {
+        impl_->set_request_callback(nullptr);
+        return;
+    }
+    impl_->set_request_callback([callback](BaseServer* base_server, const RequestContext& context, const std::string& data){
+        callback(base_server, context.client_addr, context.request_id, data);
+    });
+}
+
+void BaseServer::set_request_callback(RequestContextCallback callback) {
     impl_->set_request_callback(callback);
 }
 
+void BaseServer::set_stream_callback(StreamCallback callback) {
+    impl_->set_stream_callback(callback);
+}
+
+void BaseServer::set_classify_callback(ClassifyCallback callback) {
+    impl_->set_classify_callback(callback);
+}
+
+void BaseServer::set_priority_aging_ms(uint32_t aging_ms) {
+    impl_->set_priority_aging_ms(aging_ms);
+}
+
+void BaseServer::set_fair_queuing(bool enabled, size_t quantum_bytes/* = 8192*/) {
+    impl_->set_fair_queuing(enabled, quantum_bytes);
+}
+
+std::map<std::string, size_t> BaseServer::GetClientQueueDepths() const {
+    return impl_->GetClientQueueDepths();
+}
+
+void BaseServer::set_admission_limits(const AdmissionLimits& limits) {
+    impl_->set_admission_limits(limits);
+}
+
+uint64_t BaseServer::rejected_requests_count() const {
+    return impl_->rejected_requests_count();
+}
+
+uint64_t BaseServer::expired_requests_count() const {
+    return impl_->expired_requests_count();
+}
+
+uint64_t BaseServer::cancelled_requests_count() const {
+    return impl_->cancelled_requests_count();
+}
+
+void BaseServer::set_compression(bool enabled, size_t threshold_bytes/* = 4096*/) {
+    impl_->set_compression(enabled, threshold_bytes);
+}
+
+void BaseServer::set_checksum(bool enabled) {
+    impl_->set_checksum(enabled);
+}
+
+uint64_t BaseServer::checksum_errors_count() const {
+    return impl_->checksum_errors_count();
+}
+
 const std::string& BaseServer::socket_file() const {
     return impl_->socket_file();
 }
@@ -45,5 +137,42 @@ bool BaseServer::stopped() const {
     return impl_->stopped();
 }
 
+ResponseStream::ResponseStream(_detail::ImplBaseServer* server, const sockaddr_un& client_addr, int64_t id, uint32_t timeout_ms)
+    : server_(server), client_addr_(client_addr), id_(id), timeout_ms_(timeout_ms)
+{
+}
+
+ResponseStream::~ResponseStream() {
+    if (!finished_) {
+        server_->CloseResponseStream(client_addr_, id_, true);
+    }
+}
+
+void ResponseStream::Write(const char* data, size_t len, std::error_code& ec) {
+    if (finished_) {
+        ec = make_error_code(BaseErrc::NotInitialized);
+        return;
+    }
+    size_t chunk_size = server_->stream_chunk_size();
+    for (size_t pos = 0; pos < len; pos += chunk_size) {
+        size_t n = std::min(chunk_size, len - pos);
+        server_->WriteResponseStream(client_addr_, id_, next_seq_, data + pos, n, timeout_ms_, ec);
+        if (ec) {
+            return;
+        }
+        ++next_seq_;
+    }
+    ec.clear();
+}
+
+void ResponseStream::Finish(std::error_code& ec) {
+    if (finished_) {
+        ec = make_error_code(BaseErrc::NotInitialized);
+        return;
+    }
+    finished_ = true;
+    server_->FinishResponseStream(client_addr_, id_, next_seq_, ec);
+}
+
 } // namespace uds
 } // namespace ic
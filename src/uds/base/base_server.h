@@ -9,10 +9,17 @@
  */
 #ifndef IC_UDS_BASE_SERVER_H_
 #define IC_UDS_BASE_SERVER_H_
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <system_error>
+#include <vector>
 #include <sys/un.h>
+#include "priority.h"
 
 namespace ic {
 namespace uds {
@@ -21,6 +28,98 @@ namespace _detail {
 class ImplBaseServer;
 } // namespace _detail
 
+/**
+ * @brief 请求的调度信息.
+ */
+struct DispatchInfo {
+    Priority priority{Priority::Normal};  /* 优先级，默认为客户端请求头部携带的优先级 */
+    bool inline_execution{false};         /* 在接收线程上直接调用回调函数，不进入线程池(只用于很快的请求) */
+    std::string_view route_hint;          /* 客户端在头部携带的路由(仅压缩的请求)，分类回调函数返回前有效 */
+};
+
+/**
+ * @brief 请求上下文.
+ */
+struct RequestContext {
+    using tp = std::chrono::steady_clock::time_point;
+
+    sockaddr_un client_addr;               /* 来源客户端地址 */
+    int64_t     request_id{-1};            /* 请求ID，由客户端保证每次发送的请求ID是唯一的 */
+    Priority    priority{Priority::Normal};  /* 优先级 */
+    tp          deadline{tp::max()};       /* 客户端的截止时间，超过后客户端不再接收响应，tp::max()表示没有 */
+    tp          receive_time;              /* 收到完整请求(进入队列)的时间 */
+    std::shared_ptr<std::atomic_bool> cancel_flag;  /* 客户端取消请求后置为true */
+    bool        inline_execution{false};   /* 在接收线程上调用(DispatchInfo::inline_execution) */
+
+    bool has_deadline() const { return deadline != tp::max(); }
+    bool expired() const { return has_deadline() && std::chrono::steady_clock::now() >= deadline; }
+    bool cancelled() const { return cancel_flag && cancel_flag->load(std::memory_order_relaxed); }
+};
+
+/**
+ * @brief 数据流事件.
+ */
+enum class StreamEvent {
+    Data,   /* 收到一个数据块(按发送顺序) */
+    End,    /* 客户端结束发送，应当调用SendResponse返回响应 */
+    Abort,  /* 客户端取消，或者长时间没有新的数据块 */
+};
+
+/**
+ * @brief 响应数据流，通过 BaseServer::OpenResponseStream() 创建.
+ * 
+ * @details 响应按顺序分块发送，客户端每处理完一个数据块就确认一次，
+ *          未确认的数据块达到窗口大小时Write阻塞，两端缓存的数据量都不超过窗口大小.
+ * @note 不能在BaseServer析构之后使用
+ */
+class ResponseStream {
+public:
+    /**
+     * @brief 未调用Finish时中止数据流，客户端收到 BaseErrc::Cancelled.
+     */
+    ~ResponseStream();
+
+    /**
+     * @brief 写入数据，数据被拆分为若干数据块发送.
+     * 
+     * @details 等待窗口的时间超过打开数据流时指定的超时时间时，ec 为 BaseErrc::Timeout；
+     *          客户端取消请求(或者不接收数据流)时，ec 为 BaseErrc::Cancelled.
+     */
+    void Write(const char* data, size_t len, std::error_code& ec);
+    void Write(const std::string& data, std::error_code& ec) { Write(data.data(), data.length(), ec); }
+
+    /**
+     * @brief 结束数据流.
+     */
+    void Finish(std::error_code& ec);
+
+private:
+    friend class BaseServer;
+    ResponseStream(_detail::ImplBaseServer* server, const sockaddr_un& client_addr, int64_t id, uint32_t timeout_ms);
+
+private:
+    _detail::ImplBaseServer* server_;
+    sockaddr_un client_addr_;
+    int64_t id_;
+    uint32_t timeout_ms_;
+    uint32_t next_seq_{1};
+    bool finished_{false};
+};
+
+/**
+ * @brief 准入限制，超出限制的请求被立即拒绝，客户端收到BaseErrc::Overloaded.
+ * 
+ * @details 各项为0表示不限制.
+ */
+struct AdmissionLimits {
+    size_t max_queue_length{0};         /* 排队中的请求数量上限 */
+    size_t max_queued_bytes{0};         /* 排队中的请求的总字节数上限 */
+    size_t max_client_queue_length{0};  /* 单个客户端排队中的请求数量上限(仅公平排队时有效) */
+    uint32_t target_delay_ms{0};        /* 排队时间的目标值：连续interval_ms都超过该值时拒绝新请求(高优先级除外) */
+    uint32_t interval_ms{100};          /* 判断排队时间的观察窗口 */
+    uint32_t retry_after_ms{100};       /* 建议客户端重试间隔的最小值 */
+};
+
 class BaseServer {
 public:
     BaseServer();
@@ -55,6 +154,59 @@ public:
      */
     bool SendResponse(const sockaddr_un& client_addr, int64_t request_id, const std::string& data);
 
+    /**
+     * @brief 返回给客户端响应数据(多个片段按顺序组成一个响应).
+     * 
+     * @details 各片段不合并，分包时直接引用(sendmsg)，适合携带大数据体的响应.
+     */
+    bool SendResponse(const sockaddr_un& client_addr, int64_t request_id, const std::vector<std::string_view>& buffers);
+
+    /**
+     * @brief 打开响应数据流，代替SendResponse返回大小未知或者不适合一次性放入内存的响应.
+     * 
+     * @details 客户端通过携带数据块回调函数的 BaseClient::SendRequest 接收，不合并为一个字符串.
+     * 
+     * @param  client_addr 客户端地址
+     * @param  request_id 客户端的请求ID
+     * @param  timeout_ms 每次写入时等待窗口的超时时间，单位：毫秒
+     * @param  ec 错误代码(v1客户端不支持数据流，为 BaseErrc::SendFailed)
+     * @return 数据流，失败时返回空指针
+     */
+    std::unique_ptr<ResponseStream> OpenResponseStream(const sockaddr_un& client_addr, int64_t request_id, uint32_t timeout_ms, std::error_code& ec);
+
+    /**
+     * @brief 设置响应数据流的窗口大小(未确认的数据块数量，每块约64KB)，默认为32.
+     */
+    void set_stream_window(uint32_t packets);
+
+    /**
+     * @brief 发布消息给主题的所有订阅者(客户端通过Subscribe订阅).
+     * 
+     * @details 消息只序列化一次，批量、非阻塞地发送给所有订阅者，可以在任意线程调用.
+     * @details 接收缓冲区已满的订阅者不会阻塞发布(该订阅者丢失本条消息)，
+     *          一个观察窗口内丢失超过一半消息的订阅者被移除(客户端收到通知).
+     * 
+     * @param topic 主题，不超过65535字节
+     * @param data 消息内容
+     * @return 发送成功的订阅者数量
+     */
+    size_t Publish(const std::string& topic, const std::string& data);
+
+    /**
+     * @brief 判断订阅者是否过慢的观察窗口(毫秒)，默认1000毫秒.
+     */
+    void set_subscriber_timeout_ms(uint32_t timeout_ms);
+
+    /**
+     * @brief 主题的订阅者数量.
+     */
+    size_t subscribers_count(const std::string& topic) const;
+
+    /**
+     * @brief 因发送失败(过慢或者已退出)被移除的订阅者数量.
+     */
+    uint64_t evicted_subscribers_count() const;
+
     /**
      * @brief 接收到完成数据后的回调函数.
      */
@@ -66,6 +218,121 @@ public:
         )>;
     void set_request_callback(RequestCallback callback);
 
+    /**
+     * @brief 接收到完成数据后的回调函数(携带请求上下文).
+     * 
+     * @details 已超过客户端截止时间的请求不会调用回调函数.
+     */
+    using RequestContextCallback = std::function<void(
+            BaseServer*           base_server,  /* 当前服务器指针 */
+            const RequestContext& context,      /* 请求上下文 */
+            const std::string&    data          /* 请求数据 */
+        )>;
+    void set_request_callback(RequestContextCallback callback);
+
+    /**
+     * @brief 数据流回调函数.
+     * 
+     * @details 同一个数据流的事件按顺序在线程池中依次调用(不会并发)，回调函数返回后才确认该数据块，
+     *          处理较慢时客户端的发送会被阻塞(流量控制)，不需要缓存整个数据流.
+     * @details 数据流不经过准入控制和公平排队.
+     */
+    using StreamCallback = std::function<void(
+            BaseServer*           base_server,  /* 当前服务器指针 */
+            const RequestContext& context,      /* 数据流上下文，request_id为数据流ID */
+            StreamEvent           event,        /* 事件 */
+            const std::string&    chunk         /* 数据块，仅Data事件有效 */
+        )>;
+    void set_stream_callback(StreamCallback callback);
+
+    /**
+     * @brief 请求分类回调函数.
+     * 
+     * @details 在接收线程上调用(请求进入线程池之前)，可以根据请求内容修改其调度信息.
+     * @details 应当尽可能快，不要在这里解析完整的请求.
+     * @details 设置 info.inline_execution 后请求不进入线程池，直接在接收线程上调用请求回调函数，
+     *          省去入队、唤醒工作线程的开销；期间不接收其他数据，只用于健康检查、读取内存中的计数等很快的请求.
+     *          这样的请求不经过准入控制和公平排队，也不能被取消；压缩的请求仍进入线程池.
+     */
+    using ClassifyCallback = std::function<void(
+            const sockaddr_un& client_addr,  /* 来源客户端地址 */
+            const std::string& data,         /* 请求数据 */
+            DispatchInfo&      info          /* 调度信息 */
+        )>;
+    void set_classify_callback(ClassifyCallback callback);
+
+    /**
+     * @brief 设置优先级老化间隔(毫秒)，默认100毫秒.
+     * 
+     * @details 请求在队列中每等待一个间隔，优先级提升一级，为0时按严格优先级调度.
+     */
+    void set_priority_aging_ms(uint32_t aging_ms);
+
+    /**
+     * @brief 启用/禁用按客户端公平排队，默认禁用，需在Start之前调用.
+     * 
+     * @details 启用后每个客户端一个队列，按请求字节数加权轮询处理，
+     *          单个客户端大量发送请求不会影响其他客户端的延迟.
+     * 
+     * @param enabled 是否启用
+     * @param quantum_bytes 每轮每个客户端可处理的字节数
+     */
+    void set_fair_queuing(bool enabled, size_t quantum_bytes = 8192);
+
+    /**
+     * @brief 每个客户端排队中(未开始处理)的请求数量.
+     * 
+     * @details 仅启用公平排队时有效，键为客户端地址.
+     */
+    std::map<std::string, size_t> GetClientQueueDepths() const;
+
+    /**
+     * @brief 设置准入限制，默认不限制.
+     * 
+     * @details 超出限制的请求不进入队列，直接返回过载响应(携带建议的重试间隔).
+     */
+    void set_admission_limits(const AdmissionLimits& limits);
+
+    /**
+     * @brief 因过载被拒绝的请求数量.
+     */
+    uint64_t rejected_requests_count() const;
+
+    /**
+     * @brief 因超过客户端截止时间而未处理的请求数量.
+     */
+    uint64_t expired_requests_count() const;
+
+    /**
+     * @brief 被客户端取消且尚未开始处理的请求数量.
+     */
+    uint64_t cancelled_requests_count() const;
+
+    /**
+     * @brief 启用/禁用响应数据压缩.
+     * 
+     * @details 数据长度不小于阈值时使用LZ4压缩后发送，压缩在调用SendResponse的线程中进行.
+     *          压缩的请求在工作线程中解压后再调用回调函数(分类回调函数收到的是压缩后的数据，
+     *          路由通过 DispatchInfo::route_hint 读取，客户端未携带时无法按路由分类).
+     * @details 压缩的请求不在接收线程上执行(DispatchInfo::inline_execution 无效).
+     * 
+     * @param  enabled 是否启用，默认禁用
+     * @param  threshold_bytes 压缩阈值
+     */
+    void set_compression(bool enabled, size_t threshold_bytes = 4096);
+
+    /**
+     * @brief 启用/禁用响应数据的CRC32C校验.
+     * 
+     * @details 请求携带的校验值总会被校验，校验失败的请求不会被处理，客户端收到 BaseErrc::ChecksumMismatch.
+     */
+    void set_checksum(bool enabled);
+
+    /**
+     * @brief 校验失败(分包或者完整消息)的请求数量.
+     */
+    uint64_t checksum_errors_count() const;
+
     /**
      * @brief 服务器是否已停止.
      */
@@ -22,6 +22,9 @@ struct BaseErrcCategory : std::error_category {
             case BaseErrc::SendFailed:         return "Send data failed";
             case BaseErrc::RecvFailed:         return "Receive data failed";
             case BaseErrc::Timeout:            return "Receive data timeout";
+            case BaseErrc::Overloaded:         return "Server overloaded";
+            case BaseErrc::Cancelled:          return "Request cancelled";
+            case BaseErrc::ChecksumMismatch:   return "Checksum mismatch";
             default:                           return "(unrecognized error)";
         }
     }
@@ -24,6 +24,9 @@ enum class BaseErrc {
     SendFailed,
     RecvFailed,
     Timeout,
+    Overloaded,
+    Cancelled,
+    ChecksumMismatch,
 }; // enum class BaseErrc
 
 std::error_code make_error_code(BaseErrc ec);
@@ -0,0 +1,96 @@
+#include "admission_controller.h"
+#include <algorithm>
+
+namespace ic {
+namespace uds {
+
+void AdmissionController::set_limits(const AdmissionLimits& limits) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    limits_ = limits;
+    enabled_ = limits.max_queue_length > 0 || limits.max_queued_bytes > 0 || limits.target_delay_ms > 0;
+    if (limits_.interval_ms == 0) {
+        limits_.interval_ms = 100;
+    }
+    overloaded_ = false;
+    first_above_time_ = {};
+}
+
+/**
+ * @brief 请求进入队列之前调用.
+ */
+bool AdmissionController::Admit(size_t bytes, bool exempt_from_delay, uint32_t* retry_after_ms) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    if (enabled_) {
+        bool reject = false;
+        if (limits_.max_queue_length > 0 && queued_count_ >= limits_.max_queue_length) {
+            reject = true;
+        }
+        else if (limits_.max_queued_bytes > 0 && queued_count_ > 0 && queued_bytes_ + bytes > limits_.max_queued_bytes) {
+            reject = true;  /* 队列为空时总是接受，否则超过上限的单个请求永远无法处理 */
+        }
+        else if (overloaded_ && !exempt_from_delay) {
+            if (queued_count_ == 0) {
+                overloaded_ = false;  /* 队列已排空 */
+                first_above_time_ = {};
+            }
+            else {
+                reject = true;
+            }
+        }
+        if (reject) {
+            rejected_count_++;
+            *retry_after_ms = RetryAfterMs();
+            return false;
+        }
+    }
+    queued_count_ += 1;
+    queued_bytes_ += bytes;
+    return true;
+}
+
+/**
+ * @brief 由于其他原因(如单个客户端超出限制)拒绝请求时调用.
+ */
+uint32_t AdmissionController::Reject() {
+    std::lock_guard<std::mutex> lck(mutex_);
+    rejected_count_++;
+    return RetryAfterMs();
+}
+
+/**
+ * @brief 请求出队(开始处理)时调用.
+ */
+void AdmissionController::OnDequeue(size_t bytes, clock::duration sojourn) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    queued_count_ -= 1;
+    queued_bytes_ -= bytes;
+
+    int64_t sojourn_us = std::chrono::duration_cast<std::chrono::microseconds>(sojourn).count();
+    sojourn_ewma_us_ += (sojourn_us - sojourn_ewma_us_) / 8;
+
+    if (limits_.target_delay_ms == 0) {
+        return;
+    }
+    auto now = clock::now();
+    if (sojourn < std::chrono::milliseconds(limits_.target_delay_ms)) {
+        first_above_time_ = {};
+        overloaded_ = false;
+    }
+    else if (first_above_time_ == clock::time_point{}) {
+        first_above_time_ = now + std::chrono::milliseconds(limits_.interval_ms);
+    }
+    else if (now >= first_above_time_) {
+        overloaded_ = true;
+    }
+}
+
+/**
+ * @brief 建议的重试间隔：不小于配置值，也不小于当前的平均排队时间.
+ */
+uint32_t AdmissionController::RetryAfterMs() const {
+    uint32_t estimated_ms = static_cast<uint32_t>(sojourn_ewma_us_ / 1000);
+    return std::max(limits_.retry_after_ms, estimated_ms);
+}
+
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,88 @@
+/**
+ * @file admission_controller.h
+ * @brief 准入控制(过载保护).
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-10
+ * 
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_BASE_IMPL_DISPATCH_ADMISSION_CONTROLLER_H_
+#define IC_UDS_BASE_IMPL_DISPATCH_ADMISSION_CONTROLLER_H_
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "../../base_server.h"
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief 准入控制.
+ * 
+ * @details 请求进入队列之前判断是否接受，超出限制时立即拒绝，避免队列无限增长.
+ * @details 排队时间按CoDel的方式判断：出队时的排队时间连续interval都高于target，则认为过载，
+ *          直到某个请求的排队时间低于target.
+ */
+class AdmissionController {
+public:
+    using clock = std::chrono::steady_clock;
+
+    void set_limits(const AdmissionLimits& limits);
+
+    /**
+     * @brief 请求进入队列之前调用.
+     * 
+     * @param bytes 请求的字节数
+     * @param exempt_from_delay 是否不受排队时间的限制(高优先级的请求)
+     * @param retry_after_ms [out] 拒绝时，建议客户端的重试间隔
+     * @retval true 接受，之后必须调用OnDequeue
+     * @retval false 拒绝
+     */
+    bool Admit(size_t bytes, bool exempt_from_delay, uint32_t* retry_after_ms);
+
+    /**
+     * @brief 由于其他原因(如单个客户端超出限制)拒绝请求时调用.
+     * 
+     * @return 建议客户端的重试间隔
+     */
+    uint32_t Reject();
+
+    /**
+     * @brief 请求出队(开始处理)时调用.
+     * 
+     * @param bytes 请求的字节数
+     * @param sojourn 请求的排队时间
+     */
+    void OnDequeue(size_t bytes, clock::duration sojourn);
+
+    /**
+     * @brief 被拒绝的请求数量.
+     */
+    uint64_t rejected_count() const { return rejected_count_; }
+
+private:
+    uint32_t RetryAfterMs() const;
+
+private:
+    std::mutex mutex_;
+    AdmissionLimits limits_;
+    bool enabled_{false};
+
+    size_t queued_count_{0};
+    size_t queued_bytes_{0};
+
+    /* CoDel状态 */
+    clock::time_point first_above_time_{};
+    bool overloaded_{false};
+
+    /* 排队时间的指数加权移动平均(微秒)，用于估算重试间隔 */
+    int64_t sojourn_ewma_us_{0};
+
+    std::atomic_uint64_t rejected_count_{0};
+};
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_BASE_IMPL_DISPATCH_ADMISSION_CONTROLLER_H_
@@ -0,0 +1,120 @@
+#include "fair_queue.h"
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief 添加任务.
+ */
+void FairQueue::Push(const std::string& client, size_t cost, task_type task) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    auto iter = flows_.find(client);
+    if (iter == flows_.end()) {
+        iter = flows_.emplace(client, Flow()).first;
+        iter->second.client = client;
+    }
+    Flow* flow = &iter->second;
+    if (flow->items.empty()) {
+        active_flows_.push_back(flow);
+    }
+    flow->items.push_back({ cost, std::move(task) });
+    ++size_;
+}
+
+/**
+ * @brief 按差额轮询取出一个任务.
+ */
+bool FairQueue::Pop(task_type* task) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    if (active_flows_.empty()) {
+        return false;
+    }
+    size_t misses = 0;
+    while (true) {
+        Flow* flow = active_flows_.front();
+        if (!flow->credited) {
+            flow->deficit += quantum_;
+            flow->credited = true;
+        }
+        Item& item = flow->items.front();
+        if (item.cost > flow->deficit) {
+            /* 额度不足，轮到下一个客户端 */
+            flow->credited = false;
+            active_flows_.pop_front();
+            active_flows_.push_back(flow);
+            if (++misses == active_flows_.size()) {
+                /* 一整轮都没有客户端的额度足够(请求很大)，直接跳过这些空转的轮次 */
+                SkipRounds();
+                misses = 0;
+            }
+            continue;
+        }
+        flow->deficit -= item.cost;
+        *task = std::move(item.task);
+        flow->items.pop_front();
+        --size_;
+        if (flow->items.empty()) {
+            /* 队列空了，不保留额度 */
+            active_flows_.pop_front();
+            flows_.erase(flows_.find(flow->client));
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief 跳过所有客户端额度都不足的轮次.
+ * 
+ * @details 下一轮还会再增加一次quantum，所以这里少加一轮.
+ */
+void FairQueue::SkipRounds() {
+    size_t rounds = 0;
+    for (const Flow* flow : active_flows_) {
+        size_t need = flow->items.front().cost - flow->deficit;
+        size_t flow_rounds = (need + quantum_ - 1) / quantum_;
+        if (rounds == 0 || flow_rounds < rounds) {
+            rounds = flow_rounds;
+        }
+    }
+    if (rounds <= 1) {
+        return;
+    }
+    for (Flow* flow : active_flows_) {
+        flow->deficit += (rounds - 1) * quantum_;
+    }
+}
+
+/**
+ * @brief 排队中的任务数量.
+ */
+size_t FairQueue::size() const {
+    std::lock_guard<std::mutex> lck(mutex_);
+    return size_;
+}
+
+/**
+ * @brief 指定客户端排队中的任务数量.
+ */
+size_t FairQueue::depth(const std::string& client) const {
+    std::lock_guard<std::mutex> lck(mutex_);
+    auto iter = flows_.find(client);
+    return iter != flows_.end() ? iter->second.items.size() : 0;
+}
+
+/**
+ * @brief 每个客户端排队中的任务数量.
+ */
+void FairQueue::GetDepths(std::map<std::string, size_t>* depths) const {
+    std::lock_guard<std::mutex> lck(mutex_);
+    for (const auto& pair : flows_) {
+        (*depths)[pair.first] += pair.second.items.size();
+    }
+}
+
+void FairQueue::set_quantum(size_t quantum) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    quantum_ = quantum > 0 ? quantum : 1;
+}
+
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,99 @@
+/**
+ * @file fair_queue.h
+ * @brief 按客户端公平排队.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-09
+ * 
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_BASE_IMPL_DISPATCH_FAIR_QUEUE_H_
+#define IC_UDS_BASE_IMPL_DISPATCH_FAIR_QUEUE_H_
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief 按客户端公平排队.
+ * 
+ * @details 每个客户端一个队列，按差额轮询(Deficit Round Robin)出队：
+ *          每轮给每个客户端增加quantum字节的额度，额度足够时才能取出该客户端的队首任务，
+ *          因此每个客户端获得的处理量(按请求字节数计)大致相同，与其发送速度无关.
+ */
+class FairQueue {
+public:
+    using task_type = std::function<void()>;
+
+    explicit FairQueue(size_t quantum = 8192) : quantum_(quantum) {}
+
+    /**
+     * @brief 添加任务.
+     * 
+     * @param client 客户端标识
+     * @param cost 任务的代价(请求字节数)
+     */
+    void Push(const std::string& client, size_t cost, task_type task);
+
+    /**
+     * @brief 按差额轮询取出一个任务.
+     * 
+     * @retval false 队列为空
+     */
+    bool Pop(task_type* task);
+
+    /**
+     * @brief 排队中的任务数量.
+     */
+    size_t size() const;
+
+    /**
+     * @brief 指定客户端排队中的任务数量.
+     */
+    size_t depth(const std::string& client) const;
+
+    /**
+     * @brief 每个客户端排队中的任务数量(仅包含有任务排队的客户端).
+     */
+    void GetDepths(std::map<std::string, size_t>* depths) const;
+
+    void set_quantum(size_t quantum);
+
+private:
+    /**
+     * @brief 跳过所有客户端额度都不足的轮次.
+     */
+    void SkipRounds();
+
+private:
+    struct Item {
+        size_t cost;
+        task_type task;
+    };
+    struct Flow {
+        std::string client;
+        std::deque<Item> items;
+        size_t deficit{0};
+        bool credited{false};  /* 本轮是否已增加额度 */
+    };
+
+    mutable std::mutex mutex_;
+    size_t quantum_;
+    size_t size_{0};
+
+    /* 所有客户端的队列 */
+    std::map<std::string, Flow> flows_;
+
+    /* 有任务排队的客户端，按轮询顺序排列 */
+    std::list<Flow*> active_flows_;
+};
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_BASE_IMPL_DISPATCH_FAIR_QUEUE_H_
@@ -3,6 +3,7 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include "util/compress.h"
 #include "util/uds_util.h"
 #include "../error_code.h"
 
@@ -96,7 +97,12 @@ void ImplBaseClient::Init(const std::string& server_socket_file, const std::stri
                 packet = new Packet();
             }
             if (util::recv_data(fd_, &read_fds, packet, NULL, NULL)) {
-                ProcessResponsePacket(packet);
+                if (packet->meta.type == PacketType::Publish || packet->meta.type == PacketType::Unsubscribe) {
+                    ProcessPublishPacket(packet);
+                }
+                else {
+                    ProcessResponsePacket(packet);
+                }
             }
         }
         if (packet) {
@@ -119,13 +125,33 @@ void ImplBaseClient::Init(const std::string& server_socket_file, const std::stri
  * @note 通过 ec 判断是否成功
  */
 int64_t ImplBaseClient::Send(const std::string& data, std::error_code& ec) {
+    return Send(data, Priority::Normal, ec);
+}
+
+/**
+ * @brief 仅发送数据，不等待服务器返回响应.
+ * 
+ * @param  data 待发送的数据
+ * @param  priority 优先级
+ * @param  ec 错误代码
+ * @return 当前请求的ID
+ * @note 通过 ec 判断是否成功
+ */
+int64_t ImplBaseClient::Send(const std::string& data, Priority priority, std::error_code& ec) {
     int64_t request_id = curr_request_id_.fetch_add(1);
     if (!inited_) {
         ec = make_error_code(BaseErrc::NotInitialized);
         return request_id;
     }
 
-    if (!util::send_data(fd_, server_addr_, request_id, data)) {
+    PacketMeta meta;
+    meta.priority = static_cast<uint8_t>(priority);
+    if (checksum_) {
+        meta.flags |= PacketFlags::Checksum;
+    }
+    std::string compressed;
+    const std::string& payload = util::compress_if_needed(data, compression_threshold_, &compressed, &meta);
+    if (!util::send_data(fd_, server_addr_, request_id, payload, meta)) {
         ec = make_error_code(BaseErrc::SendFailed);
         return request_id;
     }
@@ -145,7 +171,70 @@ int64_t ImplBaseClient::Send(const std::string& data, std::error_code& ec) {
  * @note 通过 ec 判断是否成功
  */
 int64_t ImplBaseClient::SendRequest(const std::string& data, std::string* response, uint32_t timeout_ms, std::error_code& ec) {
-    int64_t request_id = curr_request_id_.fetch_add(1);
+    return SendRequest(data, response, timeout_ms, Priority::Normal, ec);
+}
+
+/**
+ * @brief 发送数据，等待服务器返回响应.
+ * 
+ * @param  data 待发送的数据
+ * @param  response 服务器响应数据
+ * @param  timeout_ms 超时时间，单位：毫秒
+ * @param  priority 优先级
+ * @param  ec 错误代码
+ * @return 当前请求的ID
+ * @note 通过 ec 判断是否成功
+ */
+int64_t ImplBaseClient::SendRequest(const std::string& data, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec) {
+    return SendRequest(NewRequestId(), data, response, timeout_ms, priority, ec);
+}
+
+/**
+ * @brief 使用指定的请求ID发送数据，等待服务器返回响应.
+ * 
+ * @param  request_id 请求ID(通过 NewRequestId() 获取)
+ * @param  data 待发送的数据
+ * @param  response 服务器响应数据
+ * @param  timeout_ms 超时时间，单位：毫秒
+ * @param  priority 优先级
+ * @param  ec 错误代码
+ * @return 当前请求的ID
+ * @note 通过 ec 判断是否成功
+ */
+int64_t ImplBaseClient::SendRequest(int64_t request_id, const std::string& data, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec) {
+    std::string_view buffer(data);
+    return SendRequest(request_id, &buffer, 1, std::string_view(), nullptr, response, timeout_ms, priority, ec);
+}
+
+/**
+ * @brief 使用指定的请求ID发送多个片段(按顺序组成一个请求)，等待服务器返回响应.
+ */
+int64_t ImplBaseClient::SendRequest(int64_t request_id, const std::vector<std::string_view>& buffers, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec) {
+    return SendRequest(request_id, buffers.data(), buffers.size(), std::string_view(), nullptr, response, timeout_ms, priority, ec);
+}
+
+/**
+ * @brief 同上，内容被压缩时头部携带路由(route_hint)，服务端解压前据此分类.
+ */
+int64_t ImplBaseClient::SendRequest(int64_t request_id, const std::vector<std::string_view>& buffers, std::string_view route_hint,
+    std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec)
+{
+    return SendRequest(request_id, buffers.data(), buffers.size(), route_hint, nullptr, response, timeout_ms, priority, ec);
+}
+
+/**
+ * @brief 发送数据，服务端以数据流返回响应时按顺序将数据块交给回调函数，返回普通响应时写入response.
+ */
+int64_t ImplBaseClient::SendRequest(int64_t request_id, const std::string& data, const ResponseChunkCallback& on_chunk,
+    std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec)
+{
+    std::string_view buffer(data);
+    return SendRequest(request_id, &buffer, 1, std::string_view(), &on_chunk, response, timeout_ms, priority, ec);
+}
+
+int64_t ImplBaseClient::SendRequest(int64_t request_id, const std::string_view* buffers, size_t buffers_count, std::string_view route_hint,
+    const ResponseChunkCallback* on_chunk, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec)
+{
     if (!inited_) {
         ec = make_error_code(BaseErrc::NotInitialized);
         return request_id;
@@ -154,45 +243,418 @@ int64_t ImplBaseClient::SendRequest(const std::string& data, std::string* respon
     {
         std::lock_guard<std::mutex> lck(mutex_);
         recv_response_ids_.emplace(request_id, std::chrono::steady_clock::now());
+        if (on_chunk) {
+            response_streams_.emplace(request_id, ResponseStreamBuffer());
+        }
     }
 
     do {
-        /* 发送请求 */
-        if (!util::send_data(fd_, server_addr_, request_id, data)) {
+        /* 发送请求，携带截止时间，服务端不再处理已超时的请求 */
+        PacketMeta meta;
+        meta.priority = static_cast<uint8_t>(priority);
+        if (checksum_) {
+            meta.flags |= PacketFlags::Checksum;
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        meta.deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+        std::string compressed;
+        bool is_compressed = util::compress_if_needed(buffers, buffers_count, compression_threshold_, &compressed, &meta);
+        /* 压缩后服务端无法在解压前读取路由 */
+        if (is_compressed && !route_hint.empty() && route_hint.length() <= util::MAX_ROUTE_HINT_SIZE) {
+            util::append_extension(&meta.extensions, PacketExtension::RouteHint, route_hint.data(), static_cast<uint8_t>(route_hint.length()));
+        }
+        bool sent = is_compressed
+            ? util::send_data(fd_, server_addr_, request_id, compressed, meta)
+            : util::send_data(fd_, server_addr_, request_id, buffers, buffers_count, meta);
+        if (!sent) {
             ec = make_error_code(BaseErrc::SendFailed);
             break;
         }
 
+        if (on_chunk) {
+            WaitResponseStream(request_id, *on_chunk, response, timeout_ms, ec);
+        }
+        else {
+            WaitResponse(request_id, response, timeout_ms, ec);
+        }
+    } while (false);
+
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        recv_response_ids_.erase(request_id);
+        response_streams_.erase(request_id);
+    }
+
+    return request_id;
+}
+
+/**
+ * @brief 等待服务器返回响应(已登记需要接收响应).
+ */
+void ImplBaseClient::WaitResponse(int64_t request_id, std::string* response, uint32_t timeout_ms, std::error_code& ec) {
+    auto timeout_tp = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout_ms);
+    auto predicate = [this, request_id]{
+        return this->prepared_buffers_.find(request_id) != this->prepared_buffers_.end();
+    };
+
+    /* 接收响应 */
+    uint16_t flags = 0;
+    std::unique_lock<std::mutex> lck(mutex_);
+    if (cv_.wait_until(lck, timeout_tp, predicate)) {
+        auto iter = prepared_buffers_.find(request_id);
+        if (iter != prepared_buffers_.end()) {
+            response->swap(iter->second.data);
+            flags = iter->second.flags;
+            if (iter->second.type == PacketType::Overloaded) {
+                ec = make_error_code(BaseErrc::Overloaded);
+            }
+            else if (iter->second.type == PacketType::Cancel) {
+                ec = make_error_code(BaseErrc::Cancelled);
+            }
+            else if (iter->second.type == PacketType::ChecksumError) {
+                ec = make_error_code(BaseErrc::ChecksumMismatch);
+            }
+            else {
+                ec.clear();
+            }
+            prepared_buffers_.erase(iter);
+        }
+        else {
+            // won't get here
+            ec = make_error_code(BaseErrc::RecvFailed);
+        }
+    }
+    else {
+        ec = make_error_code(BaseErrc::Timeout);
+    }
+    lck.unlock();
+
+    /* 在调用线程中解压，不占用接收线程 */
+    if (!ec && (flags & PacketFlags::Compressed)) {
+        std::string decompressed;
+        if (util::decompress(*response, &decompressed)) {
+            response->swap(decompressed);
+        }
+        else {
+            ec = make_error_code(BaseErrc::RecvFailed);
+        }
+    }
+}
+
+/**
+ * @brief 接收响应数据流，每个数据块交给回调函数处理后确认.
+ * 
+ * @details 服务端返回普通响应(或者过载、取消)时，与 WaitResponse 相同.
+ */
+void ImplBaseClient::WaitResponseStream(int64_t request_id, const ResponseChunkCallback& on_chunk, std::string* response,
+    uint32_t timeout_ms, std::error_code& ec)
+{
+    uint32_t consumed = 0;
+    while (true) {
+        std::string chunk;
+        {
+            auto timeout_tp = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout_ms);
+            std::unique_lock<std::mutex> lck(mutex_);
+            ResponseStreamBuffer& stream = response_streams_[request_id];
+            auto predicate = [this, request_id, &stream]{
+                return !stream.ready.empty() || stream.ended || stream.corrupted
+                    || this->prepared_buffers_.find(request_id) != this->prepared_buffers_.end();
+            };
+            if (!cv_.wait_until(lck, timeout_tp, predicate)) {
+                ec = make_error_code(BaseErrc::Timeout);
+            }
+            else if (prepared_buffers_.find(request_id) != prepared_buffers_.end()) {
+                break;  /* 普通响应 */
+            }
+            else if (!stream.ready.empty()) {
+                chunk.swap(stream.ready.front());
+                stream.ready.pop_front();
+            }
+            else if (stream.ended) {
+                response->clear();
+                ec.clear();
+                return;
+            }
+            else {
+                ec = make_error_code(BaseErrc::ChecksumMismatch);
+            }
+        }
+
+        /* 超时或者校验失败，通知服务端停止发送 */
+        if (ec) {
+            PacketMeta meta;
+            meta.type = PacketType::Cancel;
+            util::send_data(fd_, server_addr_, request_id, std::string(), meta);
+            return;
+        }
+
+        /* 回调函数返回后才确认，处理较慢时服务端等待 */
+        on_chunk(chunk.data(), chunk.length());
+        ++consumed;
+        PacketMeta meta;
+        meta.type = PacketType::StreamAck;
+        util::send_data(fd_, server_addr_, request_id, std::string((const char*)&consumed, 4), meta);
+    }
+
+    WaitResponse(request_id, response, 0, ec);
+}
+
+/**
+ * @brief 打开数据流.
+ * 
+ * @return 数据流的ID
+ */
+int64_t ImplBaseClient::OpenStream(std::error_code& ec) {
+    int64_t id = NewRequestId();
+    if (!inited_) {
+        ec = make_error_code(BaseErrc::NotInitialized);
+        return id;
+    }
+    std::lock_guard<std::mutex> lck(mutex_);
+    stream_acks_.emplace(id, 0);
+    ec.clear();
+    return id;
+}
+
+/**
+ * @brief 发送数据流的一个数据块，未确认的数据块达到窗口大小时等待.
+ */
+void ImplBaseClient::WriteStream(int64_t id, uint32_t seq, const char* data, size_t len, Priority priority, uint32_t timeout_ms, std::error_code& ec) {
+    {
         auto timeout_tp = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout_ms);
-        auto predicate = [this, request_id]{
-            return this->prepared_buffers_.find(request_id) != this->prepared_buffers_.end();
+        std::unique_lock<std::mutex> lck(mutex_);
+        bool closed = false;
+        auto predicate = [this, id, seq, &closed]{
+            auto iter = this->stream_acks_.find(id);
+            if (iter == this->stream_acks_.end()) {
+                closed = true;
+                return true;
+            }
+            return seq <= iter->second + this->stream_window_;
         };
+        if (!cv_.wait_until(lck, timeout_tp, predicate)) {
+            ec = make_error_code(BaseErrc::Timeout);
+            return;
+        }
+        if (closed) {
+            auto iter = prepared_buffers_.find(id);
+            if (iter != prepared_buffers_.end() && iter->second.type == PacketType::ChecksumError) {
+                ec = make_error_code(BaseErrc::ChecksumMismatch);
+            }
+            else {
+                ec = make_error_code(BaseErrc::Cancelled);
+            }
+            return;
+        }
+    }
 
-        /* 接收响应 */
-        std::unique_lock<std::mutex> lck(mutex_);
-        if (cv_.wait_until(lck, timeout_tp, predicate)) {
-            auto iter = prepared_buffers_.find(request_id);
+    PacketMeta meta;
+    meta.type = PacketType::StreamData;
+    meta.priority = static_cast<uint8_t>(priority);
+    if (checksum_) {
+        meta.flags |= PacketFlags::Checksum;
+    }
+    if (!util::send_packet(fd_, server_addr_, id, 0, seq, data, len, meta)) {
+        ec = make_error_code(BaseErrc::SendFailed);
+        return;
+    }
+    ec.clear();
+}
+
+/**
+ * @brief 结束数据流，等待服务器返回响应.
+ */
+void ImplBaseClient::FinishStream(int64_t id, uint32_t end_seq, Priority priority, std::string* response, uint32_t timeout_ms, std::error_code& ec) {
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        if (stream_acks_.find(id) == stream_acks_.end()) {
+            /* 已被取消，或者服务端校验失败 */
+            auto iter = prepared_buffers_.find(id);
             if (iter != prepared_buffers_.end()) {
-                response->swap(iter->second.first);
                 prepared_buffers_.erase(iter);
-                ec.clear();
+                ec = make_error_code(BaseErrc::ChecksumMismatch);
             }
             else {
-                // won't get here
-                ec = make_error_code(BaseErrc::RecvFailed);
+                ec = make_error_code(BaseErrc::Cancelled);
             }
+            return;
         }
-        else {
-            ec = make_error_code(BaseErrc::Timeout);
-        }
-    } while (false);
+        recv_response_ids_[id] = std::chrono::steady_clock::now();
+    }
+
+    PacketMeta meta;
+    meta.type = PacketType::StreamEnd;
+    meta.priority = static_cast<uint8_t>(priority);
+    if (!util::send_packet(fd_, server_addr_, id, 0, end_seq, nullptr, 0, meta)) {
+        ec = make_error_code(BaseErrc::SendFailed);
+    }
+    else {
+        WaitResponse(id, response, timeout_ms, ec);
+    }
+
+    CloseStream(id, false);
+}
+
+/**
+ * @brief 数据流每个数据块的最大长度.
+ */
+size_t ImplBaseClient::stream_chunk_size() const {
+    PacketMeta meta;
+    return util::max_packet_data_size(meta);
+}
+
+/**
+ * @brief 关闭数据流.
+ * 
+ * @param cancel 是否通知服务端取消
+ */
+void ImplBaseClient::CloseStream(int64_t id, bool cancel) {
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        stream_acks_.erase(id);
+        recv_response_ids_.erase(id);
+    }
+    if (cancel) {
+        std::error_code ec;
+        Cancel(id, ec);
+    }
+}
+
+/**
+ * @brief 订阅/取消订阅主题.
+ * 
+ * @details 主题以'\0'分隔，作为一个请求发送，等待服务端确认.
+ */
+void ImplBaseClient::Subscribe(const std::vector<std::string>& topics, uint32_t timeout_ms, bool subscribe, std::error_code& ec) {
+    if (!inited_) {
+        ec = make_error_code(BaseErrc::NotInitialized);
+        return;
+    }
+    std::string data;
+    for (auto& topic : topics) {
+        data.append(topic);
+        data.push_back('\0');
+    }
 
+    int64_t request_id = NewRequestId();
     {
+        std::lock_guard<std::mutex> lck(mutex_);
+        recv_response_ids_.emplace(request_id, std::chrono::steady_clock::now());
+    }
+    PacketMeta meta;
+    meta.type = subscribe ? PacketType::Subscribe : PacketType::Unsubscribe;
+    meta.priority = static_cast<uint8_t>(Priority::High);
+    if (!util::send_data(fd_, server_addr_, request_id, data, meta)) {
         std::lock_guard<std::mutex> lck(mutex_);
         recv_response_ids_.erase(request_id);
+        ec = make_error_code(BaseErrc::SendFailed);
+        return;
     }
+    std::string response;
+    WaitResponse(request_id, &response, timeout_ms, ec);
+    if (ec) {
+        std::lock_guard<std::mutex> lck(mutex_);
+        recv_response_ids_.erase(request_id);
+    }
+}
 
-    return request_id;
+/**
+ * @brief 处理服务端发布的消息，在接收线程上调用回调函数(不持有锁).
+ */
+void ImplBaseClient::ProcessPublishPacket(Packet*& packet) {
+    if (packet->meta.type == PacketType::Unsubscribe) {
+        if (evicted_callback_) {
+            evicted_callback_();
+        }
+        return;
+    }
+    if (packet->corrupted) {
+        std::lock_guard<std::mutex> lck(mutex_);
+        publish_buffers_.erase(packet->id);
+        return;
+    }
+
+    std::string message;
+    uint16_t flags = packet->meta.flags;
+    if (packet->total <= 1) {
+        message.swap(packet->data);
+    }
+    else {
+        std::lock_guard<std::mutex> lck(mutex_);
+        auto iter = publish_buffers_.find(packet->id);
+        if (iter == publish_buffers_.end()) {
+            iter = publish_buffers_.emplace(packet->id, Packets()).first;
+        }
+        uint32_t total = packet->total;
+        iter->second.emplace_back(packet);
+        packet = nullptr;  // reset packet to nullptr !!!
+        if (iter->second.size() < total) {
+            return;
+        }
+        bool valid = iter->second.Merge(&message);
+        publish_buffers_.erase(iter);
+        if (!valid) {
+            return;
+        }
+    }
+
+    if (flags & PacketFlags::Compressed) {
+        std::string decompressed;
+        if (!util::decompress(message, &decompressed)) {
+            return;
+        }
+        message.swap(decompressed);
+    }
+
+    /* 2字节(主题长度) + 主题 + 数据 */
+    if (message.length() < 2 || !publish_callback_) {
+        return;
+    }
+    uint16_t topic_len = 0;
+    memcpy(&topic_len, message.data(), 2);
+    if (message.length() < 2u + topic_len) {
+        return;
+    }
+    std::string topic(message, 2, topic_len);
+    publish_callback_(topic, message.substr(2 + topic_len));
+}
+
+/**
+ * @brief 取消请求.
+ * 
+ * @param  request_id 请求ID
+ * @param  ec 错误代码
+ */
+void ImplBaseClient::Cancel(int64_t request_id, std::error_code& ec) {
+    if (!inited_) {
+        ec = make_error_code(BaseErrc::NotInitialized);
+        return;
+    }
+
+    /* 唤醒本地等待响应的调用 */
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        buffers_.erase(request_id);
+        if (stream_acks_.erase(request_id) > 0) {
+            cv_.notify_all();
+        }
+        auto iter = recv_response_ids_.find(request_id);
+        if (iter != recv_response_ids_.end()) {
+            recv_response_ids_.erase(iter);
+            prepared_buffers_.emplace(request_id, PreparedBuffer{ std::string(), std::chrono::steady_clock::now(), PacketType::Cancel, 0 });
+            cv_.notify_all();
+        }
+    }
+
+    /* 通知服务端 */
+    PacketMeta meta;
+    meta.type = PacketType::Cancel;
+    if (!util::send_data(fd_, server_addr_, request_id, std::string(), meta)) {
+        ec = make_error_code(BaseErrc::SendFailed);
+        return;
+    }
+
+    ec.clear();
 }
 
 /**
@@ -215,8 +677,16 @@ void ImplBaseClient::CleanupBuffers(const tp& before) {
             ++iter;
         }
     }
+    for (auto iter = publish_buffers_.begin(); iter != publish_buffers_.end();/* ++iter*/) {
+        if (iter->second.front()->arrive_time < before) {
+            iter = publish_buffers_.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
     for (auto iter = prepared_buffers_.begin(); iter != prepared_buffers_.end();/* ++iter*/) {
-        if (iter->second.second < before) {
+        if (iter->second.arrive_time < before) {
             iter = prepared_buffers_.erase(iter);
         }
         else {
@@ -251,6 +721,33 @@ void ImplBaseClient::ProcessResponsePacket(Packet*& packet) {
     uint32_t total = packet->total;
     //printf("recv %ld\n", id);
 
+    /* 数据流的确认 */
+    if (packet->meta.type == PacketType::StreamAck) {
+        auto iter = stream_acks_.find(id);
+        if (iter != stream_acks_.end() && packet->data.length() == 4) {
+            uint32_t seq = 0;
+            memcpy(&seq, packet->data.data(), 4);
+            if (seq > iter->second) {
+                iter->second = seq;
+                cv_.notify_all();
+            }
+        }
+        return;
+    }
+
+    /* 数据流发送过程中服务端校验失败 */
+    if (packet->meta.type == PacketType::ChecksumError && stream_acks_.erase(id) > 0) {
+        prepared_buffers_.emplace(id, PreparedBuffer{ std::string(), now, PacketType::ChecksumError, 0 });
+        cv_.notify_all();
+        return;
+    }
+
+    /* 响应数据流 */
+    if (packet->meta.type == PacketType::StreamData || packet->meta.type == PacketType::StreamEnd) {
+        ProcessResponseStreamPacket(packet);
+        return;
+    }
+
     /* 是否需要接收响应内容 */
     auto recv_iter = recv_response_ids_.find(id);
     bool need_recv = (recv_iter != recv_response_ids_.end());
@@ -258,9 +755,18 @@ void ImplBaseClient::ProcessResponsePacket(Packet*& packet) {
         return;  /* 丢弃响应内容 */
     }
 
+    /* 分包校验失败 */
+    if (packet->corrupted) {
+        recv_response_ids_.erase(recv_iter);
+        buffers_.erase(id);
+        prepared_buffers_.emplace(id, PreparedBuffer{ std::string(), now, PacketType::ChecksumError, 0 });
+        cv_.notify_all();
+        return;
+    }
+
     if (total <= 1) {
         recv_response_ids_.erase(recv_iter);
-        prepared_buffers_.emplace(id, std::make_pair(packet->data, now));
+        prepared_buffers_.emplace(id, PreparedBuffer{ std::move(packet->data), now, packet->meta.type, packet->meta.flags });
         cv_.notify_all();
     }
     else {
@@ -274,13 +780,78 @@ void ImplBaseClient::ProcessResponsePacket(Packet*& packet) {
         /* 所有包已到达 */
         if (iter->second.size() >= total) {
             recv_response_ids_.erase(recv_iter);
-            prepared_buffers_.emplace(id, std::make_pair(iter->second.Merge(), now));
+            const PacketMeta& meta = iter->second.front()->meta;
+            PacketType type = meta.type;
+            uint16_t flags = meta.flags;
+            std::string data;
+            if (!iter->second.Merge(&data)) {
+                /* 没有校验值时不报告校验失败，丢弃响应(与丢包相同，等待超时) */
+                if (!(flags & PacketFlags::Checksum)) {
+                    buffers_.erase(iter);
+                    return;
+                }
+                type = PacketType::ChecksumError;
+            }
+            prepared_buffers_.emplace(id, PreparedBuffer{ std::move(data), now, type, flags });
             buffers_.erase(iter);
             cv_.notify_all();
         }
     }
 }
 
+/**
+ * @brief 处理响应数据流的数据包(已持有mutex_).
+ * 
+ * @details 数据块按序列号重新排序后交给等待中的 SendRequest.
+ */
+void ImplBaseClient::ProcessResponseStreamPacket(Packet*& packet) {
+    auto iter = response_streams_.find(packet->id);
+    if (iter == response_streams_.end()) {
+        /* 没有以数据流接收该请求的响应(或者已经返回)，通知服务端停止发送 */
+        if (packet->meta.type == PacketType::StreamData) {
+            PacketMeta meta;
+            meta.type = PacketType::Cancel;
+            util::send_data(fd_, server_addr_, packet->id, std::string(), meta);
+        }
+        return;
+    }
+    ResponseStreamBuffer& stream = iter->second;
+    if (packet->corrupted) {
+        stream.corrupted = true;
+        cv_.notify_all();
+        return;
+    }
+
+    uint32_t seq = packet->seq;
+    if (seq < stream.next_seq) {
+        return;  /* 重复的数据块 */
+    }
+    if (seq > stream.next_seq) {
+        stream.pending.emplace(seq, std::make_pair(packet->meta.type, std::move(packet->data)));
+        return;
+    }
+
+    PacketType type = packet->meta.type;
+    std::string chunk = std::move(packet->data);
+    while (true) {
+        stream.next_seq++;
+        if (type == PacketType::StreamEnd) {
+            stream.ended = true;
+            break;
+        }
+        stream.ready.emplace_back(std::move(chunk));
+
+        auto pending_iter = stream.pending.find(stream.next_seq);
+        if (pending_iter == stream.pending.end()) {
+            break;
+        }
+        type = pending_iter->second.first;
+        chunk = std::move(pending_iter->second.second);
+        stream.pending.erase(pending_iter);
+    }
+    cv_.notify_all();
+}
+
 } // namespace _detail
 } // namespace uds
 } // namespace ic
@@ -12,12 +12,17 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <system_error>
+#include <vector>
 #include <sys/un.h>
 #include "uds_packet.h"
+#include "../priority.h"
 
 namespace ic {
 namespace uds {
@@ -48,6 +53,17 @@ public:
      */
     int64_t Send(const std::string& data, std::error_code& ec);
 
+    /**
+     * @brief 仅发送数据，不等待服务器返回响应.
+     * 
+     * @param  data 待发送的数据
+     * @param  priority 优先级
+     * @param  ec 错误代码
+     * @return 当前请求的ID
+     * @note 通过 ec 判断是否成功
+     */
+    int64_t Send(const std::string& data, Priority priority, std::error_code& ec);
+
     /**
      * @brief 发送数据，等待服务器返回响应.
      * 
@@ -60,12 +76,104 @@ public:
      */
     int64_t SendRequest(const std::string& data, std::string* response, uint32_t timeout_ms, std::error_code& ec);
 
+    /**
+     * @brief 发送数据，等待服务器返回响应.
+     * 
+     * @param  data 待发送的数据
+     * @param  response 服务器响应数据
+     * @param  timeout_ms 超时时间，单位：毫秒
+     * @param  priority 优先级
+     * @param  ec 错误代码
+     * @return 当前请求的ID
+     * @note 通过 ec 判断是否成功
+     * @note 服务端过载时 ec 为 BaseErrc::Overloaded，response 为服务端建议的重试间隔(毫秒)
+     */
+    int64_t SendRequest(const std::string& data, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 使用指定的请求ID发送数据，等待服务器返回响应.
+     */
+    int64_t SendRequest(int64_t request_id, const std::string& data, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 使用指定的请求ID发送多个片段(按顺序组成一个请求)，等待服务器返回响应.
+     */
+    int64_t SendRequest(int64_t request_id, const std::vector<std::string_view>& buffers, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 同上，内容被压缩时头部携带路由(route_hint)，服务端解压前据此分类.
+     */
+    int64_t SendRequest(int64_t request_id, const std::vector<std::string_view>& buffers, std::string_view route_hint,
+        std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 发送数据，服务端以数据流返回响应时按顺序将数据块交给回调函数.
+     */
+    using ResponseChunkCallback = std::function<void(const char* data, size_t len)>;
+    int64_t SendRequest(int64_t request_id, const std::string& data, const ResponseChunkCallback& on_chunk,
+        std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
+
+    /**
+     * @brief 分配一个新的请求ID.
+     */
+    int64_t NewRequestId() { return curr_request_id_.fetch_add(1); }
+
+    /**
+     * @brief 取消请求.
+     */
+    void Cancel(int64_t request_id, std::error_code& ec);
+
+    /**
+     * @brief 数据流.
+     */
+    int64_t OpenStream(std::error_code& ec);
+    void WriteStream(int64_t id, uint32_t seq, const char* data, size_t len, Priority priority, uint32_t timeout_ms, std::error_code& ec);
+    void FinishStream(int64_t id, uint32_t end_seq, Priority priority, std::string* response, uint32_t timeout_ms, std::error_code& ec);
+    void CloseStream(int64_t id, bool cancel);
+    size_t stream_chunk_size() const;
+    void set_stream_window(uint32_t packets) { stream_window_ = packets > 0 ? packets : 1; }
+
+    /**
+     * @brief 订阅/取消订阅主题.
+     */
+    void Subscribe(const std::vector<std::string>& topics, uint32_t timeout_ms, bool subscribe, std::error_code& ec);
+
+    /**
+     * @brief 收到服务端发布的消息后的回调函数.
+     */
+    using PublishCallback = std::function<void(const std::string& topic, const std::string& data)>;
+    void set_publish_callback(PublishCallback callback) { publish_callback_ = callback; }
+
+    /**
+     * @brief 被服务端移除全部订阅后的回调函数.
+     */
+    using EvictedCallback = std::function<void()>;
+    void set_evicted_callback(EvictedCallback callback) { evicted_callback_ = callback; }
+
+    /**
+     * @brief 启用/禁用请求数据压缩.
+     */
+    void set_compression(bool enabled, size_t threshold_bytes) {
+        compression_threshold_ = enabled ? (threshold_bytes > 0 ? threshold_bytes : 1) : 0;
+    }
+
+    /**
+     * @brief 启用/禁用请求数据的CRC32C校验.
+     */
+    void set_checksum(bool enabled) { checksum_ = enabled; }
+
     const std::string& server_socket_file() const { return server_socket_file_; }
     const std::string& client_socket_file() const { return client_socket_file_; }
 
 private:
     void CleanupBuffers(const tp& before);
     void ProcessResponsePacket(Packet*& packet);
+    void ProcessPublishPacket(Packet*& packet);
+    void ProcessResponseStreamPacket(Packet*& packet);
+    void WaitResponse(int64_t request_id, std::string* response, uint32_t timeout_ms, std::error_code& ec);
+    void WaitResponseStream(int64_t request_id, const ResponseChunkCallback& on_chunk, std::string* response, uint32_t timeout_ms, std::error_code& ec);
+    int64_t SendRequest(int64_t request_id, const std::string_view* buffers, size_t buffers_count, std::string_view route_hint,
+        const ResponseChunkCallback* on_chunk, std::string* response, uint32_t timeout_ms, Priority priority, std::error_code& ec);
 
 private:
     bool inited_ = false;
@@ -77,6 +185,12 @@ private:
     std::string client_socket_file_;
 
     std::atomic_int64_t curr_request_id_;
+
+    /* 请求数据的压缩阈值，0表示不压缩 */
+    size_t compression_threshold_ = 0;
+
+    /* 请求数据是否携带校验值 */
+    bool checksum_ = false;
     sockaddr_un server_addr_;
 
     std::mutex mutex_;
@@ -89,10 +203,35 @@ private:
     std::map<int64_t, Packets> buffers_;
 
     /* 接收完成的缓冲区(已接收完成并组包) */
-    std::map<int64_t, std::pair<std::string, tp>> prepared_buffers_;
+    struct PreparedBuffer {
+        std::string data;
+        tp arrive_time;
+        PacketType type;
+        uint16_t flags;
+    };
+    std::map<int64_t, PreparedBuffer> prepared_buffers_;
 
     /* 需要接收响应内容的ID */
     std::map<int64_t, tp> recv_response_ids_;
+
+    /* 打开中的数据流，值为服务端已确认的数据块序号 */
+    std::map<int64_t, uint32_t> stream_acks_;
+    uint32_t stream_window_ = 32;
+
+    /* 接收中的响应数据流 */
+    struct ResponseStreamBuffer {
+        uint32_t next_seq = 1;                                           /* 下一个应交付的序列号 */
+        std::map<uint32_t, std::pair<PacketType, std::string>> pending;  /* 乱序到达的数据块 */
+        std::deque<std::string> ready;                                   /* 等待回调函数处理的数据块 */
+        bool ended = false;
+        bool corrupted = false;
+    };
+    std::map<int64_t, ResponseStreamBuffer> response_streams_;
+
+    /* 服务端发布的消息 */
+    PublishCallback publish_callback_;
+    EvictedCallback evicted_callback_;
+    std::map<int64_t, Packets> publish_buffers_;  /* 分包中的消息，键为服务端的消息ID */
 };
 
 } // namespace _detail
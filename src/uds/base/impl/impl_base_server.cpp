@@ -1,9 +1,17 @@
 #include "impl_base_server.h"
+#include <deque>
+#include <errno.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include "dispatch/admission_controller.h"
+#include "dispatch/fair_queue.h"
+#include "pubsub/subscription_table.h"
 #include "thread/static_thread_pool.h"
+#include "util/compress.h"
 #include "util/uds_util.h"
 #include "../base_server.h"
 #include "../error_code.h"
@@ -12,9 +20,60 @@ namespace ic {
 namespace uds {
 namespace _detail {
 
+/**
+ * @brief 公平排队时，每个请求除数据长度外的固定代价(字节).
+ */
+static const size_t FAIR_QUEUE_REQUEST_OVERHEAD = 256;
+
+/**
+ * @brief 通知被移除的订阅者时的重试次数和间隔.
+ */
+static const int EVICTION_NOTICE_RETRIES = 20;
+static const int EVICTION_NOTICE_RETRY_INTERVAL_MS = 50;
+
+/**
+ * @brief 数据流中乱序到达、等待前序数据块的数据块数量上限，超出后中止数据流.
+ */
+static const size_t STREAM_MAX_PENDING_CHUNKS = 1024;
+
+/**
+ * @brief 创建取消标志，从内存池分配(包括shared_ptr的控制块).
+ *
+ * @details 取消标志在接收线程上创建、在工作线程上释放，使用线程安全的内存池；
+ *          RequestContext的副本可能在服务端销毁之后才释放，内存池在进程内一直存在.
+ */
+static std::shared_ptr<std::atomic_bool> make_cancel_flag() {
+    static auto* pool = new std::pmr::synchronized_pool_resource();
+    return std::allocate_shared<std::atomic_bool>(std::pmr::polymorphic_allocator<std::atomic_bool>(pool), false);
+}
+
+/**
+ * @brief 接收中的数据流.
+ */
+struct ServerStream {
+    RequestContext context;
+
+    /* 以下仅在接收线程中访问 */
+    uint32_t next_seq = 1;                                       /* 下一个应交付的序列号 */
+    std::map<uint32_t, std::pair<PacketType, std::string>> pending;  /* 乱序到达的数据块 */
+    tp last_active;
+
+    /* 以下由mutex保护，交付给线程池按顺序处理 */
+    std::mutex mutex;
+    std::deque<std::pair<StreamEvent, std::string>> ready;
+    bool scheduled = false;
+    bool closed = false;
+
+    /* 已处理的数据块数量，仅在线程池中访问 */
+    uint32_t consumed = 0;
+};
+
 ImplBaseServer::ImplBaseServer(BaseServer* base_server)
     : base_server_(base_server), last_cleanup_time_(std::chrono::steady_clock::now())
 {
+    fair_queues_ = new FairQueue[kPriorityCount];
+    admission_ = new AdmissionController();
+    subscriptions_ = new SubscriptionTable();
 }
 
 ImplBaseServer::~ImplBaseServer() {
@@ -31,6 +90,12 @@ ImplBaseServer::~ImplBaseServer() {
         delete thread_pool_;
         thread_pool_ = nullptr;
     }
+    delete[] fair_queues_;
+    fair_queues_ = nullptr;
+    delete admission_;
+    admission_ = nullptr;
+    delete subscriptions_;
+    subscriptions_ = nullptr;
     if (fd_ >= 0) {
         ::close(fd_);
         fd_ = -1;
@@ -87,7 +152,8 @@ void ImplBaseServer::Init(const std::string& socket_file, size_t thread_pool_siz
     }
 
     /* 创建线程池 */
-    thread_pool_ = new StaticThreadPool(thread_pool_size);
+    thread_pool_ = new StaticThreadPool(thread_pool_size, kPriorityCount);
+    thread_pool_->set_aging_interval(std::chrono::milliseconds(priority_aging_ms_));
 
     socket_file_ = socket_file;
     thread_pool_size_ = thread_pool_size;
@@ -143,13 +209,190 @@ void ImplBaseServer::Stop() {
  * @param data 响应内容
  */
 bool ImplBaseServer::SendResponse(const sockaddr_un& client_addr, int64_t request_id, const std::string& data) {
-    return util::send_data(fd_, client_addr, request_id, data);
+    PacketMeta meta;
+    if (IsV1Request(client_addr, request_id, true)) {
+        meta.version = PACKET_VERSION_1;
+    }
+    if (checksum_) {
+        meta.flags |= PacketFlags::Checksum;
+    }
+    std::string compressed;
+    const std::string& payload = util::compress_if_needed(data, compression_threshold_, &compressed, &meta);
+    return util::send_data(fd_, client_addr, request_id, payload, meta);
+}
+
+/**
+ * @brief 返回给客户端响应数据(多个片段按顺序组成一个响应).
+ * 
+ * @details 不压缩时各片段不合并，分包时直接引用.
+ */
+bool ImplBaseServer::SendResponse(const sockaddr_un& client_addr, int64_t request_id, const std::vector<std::string_view>& buffers) {
+    PacketMeta meta;
+    if (IsV1Request(client_addr, request_id, true)) {
+        meta.version = PACKET_VERSION_1;
+    }
+    if (checksum_) {
+        meta.flags |= PacketFlags::Checksum;
+    }
+    std::string compressed;
+    if (util::compress_if_needed(buffers.data(), buffers.size(), compression_threshold_, &compressed, &meta)) {
+        return util::send_data(fd_, client_addr, request_id, compressed, meta);
+    }
+    return util::send_data(fd_, client_addr, request_id, buffers.data(), buffers.size(), meta);
+}
+
+/**
+ * @brief 发布消息给主题的所有订阅者.
+ * 
+ * @details 消息只序列化(分包、压缩、校验)一次，所有订阅者共用同一组数据报，通过sendmmsg批量、非阻塞发送.
+ * @details 订阅者接收缓冲区已满时不等待(该订阅者丢失本条消息)，过慢的订阅者被移除，并收到移除通知.
+ */
+size_t ImplBaseServer::Publish(const std::string& topic, const std::string& data) {
+    if (!inited_ || topic.length() > UINT16_MAX) {
+        return 0;
+    }
+    auto subscribers = subscriptions_->GetSubscribers(topic);
+    if (!subscribers || subscribers->empty()) {
+        return 0;
+    }
+
+    /* 2字节(主题长度) + 主题 + 数据 */
+    uint16_t topic_len = static_cast<uint16_t>(topic.length());
+    std::string message;
+    message.reserve(2 + topic.length() + data.length());
+    message.append((const char*)&topic_len, 2);
+    message.append(topic);
+    message.append(data);
+
+    PacketMeta meta;
+    meta.type = PacketType::Publish;
+    if (checksum_) {
+        meta.flags |= PacketFlags::Checksum;
+    }
+    std::string compressed;
+    const std::string& payload = util::compress_if_needed(message, compression_threshold_, &compressed, &meta);
+    std::vector<std::string> datagrams;
+    if (!util::make_datagrams(publish_id_.fetch_add(1), payload, meta, &datagrams)) {
+        return 0;
+    }
+
+    std::vector<int> errors;
+    util::send_datagrams(fd_, datagrams, *subscribers, &errors);
+    std::vector<sockaddr_un> evicted;
+    size_t delivered = subscriptions_->OnPublished(*subscribers, errors, &evicted);
+
+    /* 通知被移除的订阅者：其接收缓冲区此时通常是满的，在线程池中重试一段时间(尽力而为) */
+    if (!evicted.empty()) {
+        thread_pool_->EnqueueWithPriority(static_cast<size_t>(Priority::Low), [this, evicted]{
+            PacketMeta notice_meta;
+            notice_meta.type = PacketType::Unsubscribe;
+            std::vector<std::string> notice;
+            if (!util::make_datagrams(0, std::string(), notice_meta, &notice)) {
+                return;
+            }
+            std::vector<sockaddr_un> targets = evicted;
+            std::vector<int> errors;
+            for (int retry = 0; retry < EVICTION_NOTICE_RETRIES && !targets.empty(); ++retry) {
+                if (retry > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(EVICTION_NOTICE_RETRY_INTERVAL_MS));
+                }
+                util::send_datagrams(this->fd_, notice, targets, &errors);
+                std::vector<sockaddr_un> remaining;
+                for (size_t i = 0; i < targets.size(); ++i) {
+                    if (errors[i] == EAGAIN || errors[i] == EWOULDBLOCK) {
+                        remaining.push_back(targets[i]);
+                    }
+                }
+                targets.swap(remaining);
+            }
+        });
+    }
+    return delivered;
+}
+
+void ImplBaseServer::set_subscriber_timeout_ms(uint32_t timeout_ms) {
+    subscriptions_->set_timeout_ms(timeout_ms);
+}
+
+size_t ImplBaseServer::subscribers_count(const std::string& topic) const {
+    return subscriptions_->subscribers_count(topic);
+}
+
+uint64_t ImplBaseServer::evicted_subscribers_count() const {
+    return subscriptions_->evicted_count();
+}
+
+/**
+ * @brief 设置优先级老化间隔(毫秒)，为0时按严格优先级调度.
+ */
+void ImplBaseServer::set_priority_aging_ms(uint32_t aging_ms) {
+    priority_aging_ms_ = aging_ms;
+    if (thread_pool_) {
+        thread_pool_->set_aging_interval(std::chrono::milliseconds(aging_ms));
+    }
+}
+
+/**
+ * @brief 启用/禁用按客户端公平排队，需在Start之前调用.
+ */
+void ImplBaseServer::set_fair_queuing(bool enabled, size_t quantum_bytes) {
+    fair_queuing_ = enabled;
+    for (size_t i = 0; i < kPriorityCount; ++i) {
+        fair_queues_[i].set_quantum(quantum_bytes);
+    }
+}
+
+/**
+ * @brief 每个客户端排队中的请求数量.
+ */
+std::map<std::string, size_t> ImplBaseServer::GetClientQueueDepths() const {
+    std::map<std::string, size_t> depths;
+    for (size_t i = 0; i < kPriorityCount; ++i) {
+        fair_queues_[i].GetDepths(&depths);
+    }
+    return depths;
+}
+
+/**
+ * @brief 设置准入限制.
+ */
+void ImplBaseServer::set_admission_limits(const AdmissionLimits& limits) {
+    admission_->set_limits(limits);
+    max_client_queue_length_ = limits.max_client_queue_length;
+}
+
+/**
+ * @brief 因过载被拒绝的请求数量.
+ */
+uint64_t ImplBaseServer::rejected_requests_count() const {
+    return admission_->rejected_count();
 }
 
 /**
  * @brief 清理缓存中过期的数据包.
  */
 void ImplBaseServer::CleanupBuffers(const tp& before) {
+    if (v1_requests_count_ > 0) {
+        std::lock_guard<std::mutex> lck(v1_requests_mutex_);
+        for (auto iter = v1_requests_.begin(); iter != v1_requests_.end();/* ++iter*/) {
+            if (iter->second < before) {
+                iter = v1_requests_.erase(iter);
+            }
+            else {
+                ++iter;
+            }
+        }
+        v1_requests_count_ = v1_requests_.size();
+    }
+    for (auto iter = streams_.begin(); iter != streams_.end();/* ++iter*/) {
+        if (iter->second->last_active < before) {
+            AbortStream(iter->second);
+            iter = streams_.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
     for (auto iter = buffers_.begin(); iter != buffers_.end();/* ++iter*/) {
         for (auto iter2 = iter->second.begin(); iter2 != iter->second.end();/* ++iter2*/) {
             if ((*iter2)->arrive_time < before) {
@@ -186,16 +429,43 @@ void ImplBaseServer::ProcessRequestPacket(const sockaddr_un& client_addr, Packet
     //count_++;
     //printf("%d %ld\n", count_, id);
 
+    UpdateV1Requests(client_addr, id, packet->meta.version);
+
+    if (packet->meta.type == PacketType::Cancel) {
+        ProcessCancel(client_addr, id);
+        return;
+    }
+
+    if (packet->meta.type == PacketType::StreamAck) {
+        ProcessStreamAck(client_addr, id, packet->data);
+        return;
+    }
+
+    /* 分包校验失败，丢弃整个请求 */
+    if (packet->corrupted) {
+        checksum_errors_count_++;
+        RequestKey key(client_addr.sun_path, id);
+        buffers_.erase(key);
+        auto stream_iter = streams_.find(key);
+        if (stream_iter != streams_.end()) {
+            AbortStream(stream_iter->second);
+            streams_.erase(stream_iter);
+        }
+        SendChecksumError(client_addr, id, packet->meta.version);
+        return;
+    }
+
+    if (packet->meta.type == PacketType::StreamData || packet->meta.type == PacketType::StreamEnd) {
+        ProcessStreamPacket(client_addr, packet);
+        return;
+    }
+
     if (total <= 1) {
-        thread_pool_->Enqueue([this, client_addr, id, data = packet->data]{
-            if (this->request_callback_) {
-                this->request_callback_(this->base_server_, client_addr, id, data);
-            }
-        });
+        Dispatch(client_addr, id, packet->meta, std::move(packet->data));
     }
     else {
         /* 写入缓冲区 */
-        auto key = std::make_pair<std::string, uint32_t>(client_addr.sun_path, id);
+        RequestKey key(client_addr.sun_path, id);
         auto iter = buffers_.find(key);
         if (iter == buffers_.end()) {
             iter = buffers_.emplace(key, Packets()).first;
@@ -204,14 +474,556 @@ void ImplBaseServer::ProcessRequestPacket(const sockaddr_un& client_addr, Packet
         packet = nullptr;  // reset packet to nullptr !!!
         /* 所有包已到达 */
         if (iter->second.size() >= total) {
-            thread_pool_->Enqueue([this, client_addr, id, data = iter->second.Merge()]{
-                if (this->request_callback_) {
-                    this->request_callback_(this->base_server_, client_addr, id, data);
-                }
-            });
+            PacketMeta meta = iter->second.front()->meta;
+            std::string data;
+            bool valid = iter->second.Merge(&data);
             buffers_.erase(iter);
+            if (valid) {
+                Dispatch(client_addr, id, meta, std::move(data));
+            }
+            /* 序列号缺失或重复时，只有携带校验值的请求按校验失败处理，否则直接丢弃 */
+            else if (meta.flags & PacketFlags::Checksum) {
+                checksum_errors_count_++;
+                SendChecksumError(client_addr, id, meta.version);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 将完整的请求放入线程池.
+ */
+void ImplBaseServer::Dispatch(const sockaddr_un& client_addr, int64_t id, const PacketMeta& meta, std::string&& data) {
+    if (meta.type == PacketType::Subscribe || meta.type == PacketType::Unsubscribe) {
+        ProcessSubscribe(client_addr, id, meta, data);
+        return;
+    }
+    if (meta.type != PacketType::Data) {
+        return;
+    }
+    RequestContext context;
+    context.client_addr = client_addr;
+    context.request_id = id;
+    if (meta.deadline != 0) {
+        context.deadline = RequestContext::tp(std::chrono::nanoseconds(meta.deadline));
+        if (context.expired()) {
+            expired_requests_count_++;
+            return;
+        }
+    }
+
+    DispatchInfo info;
+    if (meta.priority < kPriorityCount) {
+        info.priority = static_cast<Priority>(meta.priority);
+    }
+    bool compressed = (meta.flags & PacketFlags::Compressed);
+    if (classify_callback_) {
+        /* 压缩的请求在解压前无法读取路由，使用客户端在头部携带的路由 */
+        if (compressed) {
+            util::find_extension(meta.extensions, PacketExtension::RouteHint, &info.route_hint);
+        }
+        classify_callback_(client_addr, data, info);
+    }
+    context.priority = info.priority;
+
+    /* 在接收线程上直接处理，不入队 */
+    if (info.inline_execution && !compressed && request_callback_) {
+        context.inline_execution = true;
+        context.receive_time = std::chrono::steady_clock::now();
+        /* 与线程池中一样忽略回调函数抛出的异常，不能中止接收线程 */
+        try {
+            request_callback_(base_server_, context, data);
+        }
+        catch (...) {
+            fprintf(stderr, "Inline request callback threw. client=%s, id=%ld\n", client_addr.sun_path, id);
+        }
+        return;
+    }
+
+    /* 准入控制 */
+    size_t bytes = data.length();
+    uint32_t retry_after_ms = 0;
+    if (!AdmitClient(client_addr)) {
+        SendOverloaded(client_addr, id, meta.version, admission_->Reject());
+        return;
+    }
+    if (!admission_->Admit(bytes, info.priority == Priority::High, &retry_after_ms)) {
+        SendOverloaded(client_addr, id, meta.version, retry_after_ms);
+        return;
+    }
+
+    /* 记录请求，收到取消时置位 */
+    context.cancel_flag = make_cancel_flag();
+    AddInflight(client_addr, id, context.cancel_flag);
+
+    context.receive_time = std::chrono::steady_clock::now();
+    auto enqueue_time = context.receive_time;
+    auto task = [this, context, bytes, enqueue_time, compressed, data = std::move(data)]{
+        /* 回调函数抛出异常时(线程池忽略异常)同样移除 */
+        struct InflightGuard {
+            ~InflightGuard() { server->RemoveInflight(context.client_addr, context.request_id, context.cancel_flag); }
+            ImplBaseServer* server;
+            const RequestContext& context;
+        } inflight_guard{ this, context };
+        this->admission_->OnDequeue(bytes, std::chrono::steady_clock::now() - enqueue_time);
+        /* 客户端已取消请求，或者不再等待响应 */
+        if (context.cancelled()) {
+            this->cancelled_requests_count_++;
+        }
+        else if (context.expired()) {
+            this->expired_requests_count_++;
+        }
+        else if (this->request_callback_) {
+            /* 在工作线程中解压，不占用接收线程 */
+            if (!compressed) {
+                this->request_callback_(this->base_server_, context, data);
+            }
+            else {
+                std::string decompressed;
+                if (util::decompress(data, &decompressed)) {
+                    this->request_callback_(this->base_server_, context, decompressed);
+                }
+                else {
+                    fprintf(stderr, "Decompress request failed. client=%s, id=%ld", context.client_addr.sun_path, context.request_id);
+                }
+            }
+        }
+    };
+    size_t priority_index = static_cast<size_t>(info.priority);
+    if (!fair_queuing_) {
+        thread_pool_->EnqueueWithPriority(priority_index, std::move(task));
+        return;
+    }
+
+    /* 公平排队：请求放入客户端的队列，线程池中的任务从队列中按差额轮询取出请求 */
+    FairQueue& fair_queue = fair_queues_[priority_index];
+    fair_queue.Push(client_addr.sun_path, bytes + FAIR_QUEUE_REQUEST_OVERHEAD, std::move(task));
+    thread_pool_->EnqueueWithPriority(priority_index, [&fair_queue]{
+        FairQueue::task_type task;
+        if (fair_queue.Pop(&task)) {
+            task();
+        }
+    });
+}
+
+/**
+ * @brief 处理客户端的取消请求.
+ * 
+ * @details 丢弃尚未组包完成的分包；已进入队列的请求置位取消标志：
+ *          尚未开始处理的请求出队时直接跳过，正在处理中的请求由回调函数自行检查.
+ */
+void ImplBaseServer::ProcessCancel(const sockaddr_un& client_addr, int64_t id) {
+    RequestKey key(client_addr.sun_path, id);
+    buffers_.erase(key);
+
+    auto stream_iter = streams_.find(key);
+    if (stream_iter != streams_.end()) {
+        AbortStream(stream_iter->second);
+        streams_.erase(stream_iter);
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(response_streams_mutex_);
+        if (response_streams_.erase(key) > 0) {
+            response_streams_cv_.notify_all();
+        }
+    }
+
+    std::lock_guard<std::mutex> lck(inflight_mutex_);
+    auto range = inflight_.equal_range(std::string_view(client_addr.sun_path));
+    for (auto iter = range.first; iter != range.second; ++iter) {
+        if (iter->second.request_id == id) {
+            iter->second.cancel_flag->store(true, std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief 处理客户端的订阅/取消订阅，由接收线程直接处理并返回空响应.
+ */
+void ImplBaseServer::ProcessSubscribe(const sockaddr_un& client_addr, int64_t id, const PacketMeta& meta, const std::string& data) {
+    std::vector<std::string> topics;
+    size_t pos = 0;
+    while (pos < data.length()) {
+        size_t end = data.find('\0', pos);
+        if (end == std::string::npos) {
+            end = data.length();
+        }
+        if (end > pos) {
+            topics.emplace_back(data, pos, end - pos);
+        }
+        pos = end + 1;
+    }
+    if (meta.type == PacketType::Subscribe) {
+        subscriptions_->Subscribe(client_addr, topics);
+    }
+    else {
+        subscriptions_->Unsubscribe(client_addr, topics);
+    }
+    util::send_data(fd_, client_addr, id, std::string());
+}
+
+/**
+ * @brief 处理数据流的数据包.
+ * 
+ * @details 数据块按序列号重新排序后交付，每个数据流同一时间最多一个线程池任务在处理.
+ */
+void ImplBaseServer::ProcessStreamPacket(const sockaddr_un& client_addr, Packet*& packet) {
+    RequestKey key(client_addr.sun_path, packet->id);
+    auto iter = streams_.find(key);
+    if (iter == streams_.end()) {
+        auto stream = std::make_shared<ServerStream>();
+        stream->context.client_addr = client_addr;
+        stream->context.request_id = packet->id;
+        if (packet->meta.priority < kPriorityCount) {
+            stream->context.priority = static_cast<Priority>(packet->meta.priority);
+        }
+        stream->context.cancel_flag = make_cancel_flag();
+        AddInflight(client_addr, packet->id, stream->context.cancel_flag);
+        iter = streams_.emplace(key, stream).first;
+    }
+    std::shared_ptr<ServerStream> stream = iter->second;
+    stream->last_active = std::chrono::steady_clock::now();
+
+    uint32_t seq = packet->seq;
+    if (seq < stream->next_seq) {
+        return;  /* 重复的数据块 */
+    }
+    if (seq > stream->next_seq) {
+        if (stream->pending.size() >= STREAM_MAX_PENDING_CHUNKS) {
+            AbortStream(stream);
+            streams_.erase(iter);
+            return;
+        }
+        stream->pending.emplace(seq, std::make_pair(packet->meta.type, std::move(packet->data)));
+        return;
+    }
+
+    PacketType type = packet->meta.type;
+    std::string chunk = std::move(packet->data);
+    while (true) {
+        stream->next_seq++;
+        if (type == PacketType::StreamEnd) {
+            DeliverStreamEvent(stream, StreamEvent::End, std::string());
+            streams_.erase(iter);
+            return;
+        }
+        DeliverStreamEvent(stream, StreamEvent::Data, std::move(chunk));
+
+        auto pending_iter = stream->pending.find(stream->next_seq);
+        if (pending_iter == stream->pending.end()) {
+            break;
+        }
+        type = pending_iter->second.first;
+        chunk = std::move(pending_iter->second.second);
+        stream->pending.erase(pending_iter);
+    }
+}
+
+/**
+ * @brief 中止数据流(调用方负责从streams_中移除).
+ */
+void ImplBaseServer::AbortStream(const std::shared_ptr<ServerStream>& stream) {
+    stream->context.cancel_flag->store(true, std::memory_order_relaxed);
+    DeliverStreamEvent(stream, StreamEvent::Abort, std::string());
+}
+
+/**
+ * @brief 将数据流事件交给线程池.
+ */
+void ImplBaseServer::DeliverStreamEvent(const std::shared_ptr<ServerStream>& stream, StreamEvent event, std::string&& chunk) {
+    {
+        std::lock_guard<std::mutex> lck(stream->mutex);
+        if (stream->closed) {
+            return;
+        }
+        if (event != StreamEvent::Data) {
+            stream->closed = true;
+        }
+        stream->ready.emplace_back(event, std::move(chunk));
+        if (stream->scheduled) {
+            return;
+        }
+        stream->scheduled = true;
+    }
+    size_t priority_index = static_cast<size_t>(stream->context.priority);
+    thread_pool_->EnqueueWithPriority(priority_index, [this, stream]{
+        this->RunStream(stream);
+    });
+}
+
+/**
+ * @brief 在线程池中按顺序处理数据流的事件，每处理一个数据块返回一次确认.
+ */
+void ImplBaseServer::RunStream(const std::shared_ptr<ServerStream>& stream) {
+    const RequestContext& context = stream->context;
+    while (true) {
+        std::pair<StreamEvent, std::string> item;
+        {
+            std::lock_guard<std::mutex> lck(stream->mutex);
+            if (stream->ready.empty()) {
+                stream->scheduled = false;
+                return;
+            }
+            item = std::move(stream->ready.front());
+            stream->ready.pop_front();
+        }
+
+        StreamEvent event = item.first;
+        if (event == StreamEvent::Data && context.cancelled()) {
+            continue;
+        }
+        /* 回调函数抛出异常时仍然确认、结束数据流，否则该数据流不再被调度 */
+        if (stream_callback_) {
+            try {
+                stream_callback_(base_server_, context, event, item.second);
+            }
+            catch (...) {
+                fprintf(stderr, "Stream callback threw. client=%s, id=%ld\n", context.client_addr.sun_path, context.request_id);
+            }
+        }
+
+        if (event == StreamEvent::Data) {
+            uint32_t consumed = ++stream->consumed;
+            PacketMeta meta;
+            meta.type = PacketType::StreamAck;
+            util::send_data(fd_, context.client_addr, context.request_id, std::string((const char*)&consumed, 4), meta);
+        }
+        else {
+            RemoveInflight(context.client_addr, context.request_id, context.cancel_flag);
+        }
+    }
+}
+
+/**
+ * @brief 客户端对响应数据流的确认.
+ */
+void ImplBaseServer::ProcessStreamAck(const sockaddr_un& client_addr, int64_t id, const std::string& data) {
+    if (data.length() != 4) {
+        return;
+    }
+    uint32_t seq = 0;
+    memcpy(&seq, data.data(), 4);
+    std::lock_guard<std::mutex> lck(response_streams_mutex_);
+    auto iter = response_streams_.find(RequestKey(client_addr.sun_path, id));
+    if (iter != response_streams_.end() && seq > iter->second) {
+        iter->second = seq;
+        response_streams_cv_.notify_all();
+    }
+}
+
+/**
+ * @brief 打开响应数据流.
+ */
+void ImplBaseServer::OpenResponseStream(const sockaddr_un& client_addr, int64_t id, std::error_code& ec) {
+    if (!inited_) {
+        ec = make_error_code(BaseErrc::NotInitialized);
+        return;
+    }
+    /* v1客户端不能识别数据流的数据包 */
+    if (IsV1Request(client_addr, id, false)) {
+        ec = make_error_code(BaseErrc::SendFailed);
+        return;
+    }
+    std::lock_guard<std::mutex> lck(response_streams_mutex_);
+    response_streams_[RequestKey(client_addr.sun_path, id)] = 0;
+    ec.clear();
+}
+
+/**
+ * @brief 发送响应数据流的一个数据块，未确认的数据块达到窗口大小时等待.
+ */
+void ImplBaseServer::WriteResponseStream(const sockaddr_un& client_addr, int64_t id, uint32_t seq, const char* data, size_t len,
+    uint32_t timeout_ms, std::error_code& ec)
+{
+    {
+        RequestKey key(client_addr.sun_path, id);
+        auto timeout_tp = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout_ms);
+        std::unique_lock<std::mutex> lck(response_streams_mutex_);
+        bool closed = false;
+        auto predicate = [this, &key, seq, &closed]{
+            auto iter = this->response_streams_.find(key);
+            if (iter == this->response_streams_.end()) {
+                closed = true;
+                return true;
+            }
+            return seq <= iter->second + this->stream_window_;
+        };
+        if (!response_streams_cv_.wait_until(lck, timeout_tp, predicate)) {
+            ec = make_error_code(BaseErrc::Timeout);
+            return;
+        }
+        if (closed) {
+            ec = make_error_code(BaseErrc::Cancelled);
+            return;
+        }
+    }
+
+    PacketMeta meta;
+    meta.type = PacketType::StreamData;
+    if (checksum_) {
+        meta.flags |= PacketFlags::Checksum;
+    }
+    if (!util::send_packet(fd_, client_addr, id, 0, seq, data, len, meta)) {
+        ec = make_error_code(BaseErrc::SendFailed);
+        return;
+    }
+    ec.clear();
+}
+
+/**
+ * @brief 结束响应数据流.
+ */
+void ImplBaseServer::FinishResponseStream(const sockaddr_un& client_addr, int64_t id, uint32_t end_seq, std::error_code& ec) {
+    {
+        std::lock_guard<std::mutex> lck(response_streams_mutex_);
+        if (response_streams_.erase(RequestKey(client_addr.sun_path, id)) == 0) {
+            ec = make_error_code(BaseErrc::Cancelled);
+            return;
+        }
+    }
+    PacketMeta meta;
+    meta.type = PacketType::StreamEnd;
+    if (!util::send_packet(fd_, client_addr, id, 0, end_seq, nullptr, 0, meta)) {
+        ec = make_error_code(BaseErrc::SendFailed);
+        return;
+    }
+    ec.clear();
+}
+
+/**
+ * @brief 响应数据流每个数据块的最大长度.
+ */
+size_t ImplBaseServer::stream_chunk_size() const {
+    PacketMeta meta;
+    return util::max_packet_data_size(meta);
+}
+
+/**
+ * @brief 关闭响应数据流.
+ * 
+ * @param abort 是否通知客户端中止(客户端收到 BaseErrc::Cancelled)
+ */
+void ImplBaseServer::CloseResponseStream(const sockaddr_un& client_addr, int64_t id, bool abort) {
+    {
+        std::lock_guard<std::mutex> lck(response_streams_mutex_);
+        if (response_streams_.erase(RequestKey(client_addr.sun_path, id)) == 0) {
+            return;  /* 客户端已取消 */
+        }
+    }
+    if (abort) {
+        PacketMeta meta;
+        meta.type = PacketType::Cancel;
+        util::send_data(fd_, client_addr, id, std::string(), meta);
+    }
+}
+
+/**
+ * @brief 请求处理完成(或被跳过).
+ */
+void ImplBaseServer::AddInflight(const sockaddr_un& client_addr, int64_t id, const std::shared_ptr<std::atomic_bool>& cancel_flag) {
+    std::lock_guard<std::mutex> lck(inflight_mutex_);
+    inflight_.emplace(client_addr.sun_path, InflightRequest{ id, cancel_flag });
+}
+
+/**
+ * @brief 只移除取消标志相同的条目(客户端重复使用请求ID时不影响其他请求).
+ */
+void ImplBaseServer::RemoveInflight(const sockaddr_un& client_addr, int64_t id, const std::shared_ptr<std::atomic_bool>& cancel_flag) {
+    std::lock_guard<std::mutex> lck(inflight_mutex_);
+    auto range = inflight_.equal_range(std::string_view(client_addr.sun_path));
+    for (auto iter = range.first; iter != range.second; ++iter) {
+        if (iter->second.request_id == id && iter->second.cancel_flag == cancel_flag) {
+            inflight_.erase(iter);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 单个客户端排队中的请求数量是否超出限制(仅公平排队时有效).
+ */
+bool ImplBaseServer::AdmitClient(const sockaddr_un& client_addr) const {
+    if (!fair_queuing_ || max_client_queue_length_ == 0) {
+        return true;
+    }
+    size_t depth = 0;
+    for (size_t i = 0; i < kPriorityCount; ++i) {
+        depth += fair_queues_[i].depth(client_addr.sun_path);
+    }
+    return depth < max_client_queue_length_;
+}
+
+/**
+ * @brief 返回过载响应.
+ * 
+ * @details 内容为建议的重试间隔(毫秒)，由接收线程直接发送，不进入线程池.
+ */
+void ImplBaseServer::SendOverloaded(const sockaddr_un& client_addr, int64_t request_id, uint8_t version, uint32_t retry_after_ms) {
+    /* v1协议没有数据包类型，无法区分过载响应与正常响应，不返回 */
+    if (version == PACKET_VERSION_1) {
+        IsV1Request(client_addr, request_id, true);
+        return;
+    }
+    PacketMeta meta;
+    meta.type = PacketType::Overloaded;
+    util::send_data(fd_, client_addr, request_id, std::to_string(retry_after_ms), meta);
+}
+
+/**
+ * @brief 返回校验失败响应，由接收线程直接发送.
+ */
+void ImplBaseServer::SendChecksumError(const sockaddr_un& client_addr, int64_t request_id, uint8_t version) {
+    if (version == PACKET_VERSION_1) {
+        IsV1Request(client_addr, request_id, true);
+        return;
+    }
+    PacketMeta meta;
+    meta.type = PacketType::ChecksumError;
+    util::send_data(fd_, client_addr, request_id, std::string(), meta);
+}
+
+/**
+ * @brief 记录v1协议的请求；收到v2数据包时移除该地址之前的记录(同一地址上的客户端已升级或者重启).
+ */
+void ImplBaseServer::UpdateV1Requests(const sockaddr_un& client_addr, int64_t id, uint8_t version) {
+    if (version != PACKET_VERSION_1 && v1_requests_count_ == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lck(v1_requests_mutex_);
+    if (version == PACKET_VERSION_1) {
+        v1_requests_.emplace(RequestKey(client_addr.sun_path, id), std::chrono::steady_clock::now());
+    }
+    else {
+        auto first = v1_requests_.lower_bound(RequestKey(client_addr.sun_path, INT64_MIN));
+        auto last = first;
+        while (last != v1_requests_.end() && last->first.first == client_addr.sun_path) {
+            ++last;
         }
+        v1_requests_.erase(first, last);
+    }
+    v1_requests_count_ = v1_requests_.size();
+}
+
+/**
+ * @brief 请求是否使用v1协议(响应使用与请求相同的协议版本).
+ * 
+ * @param remove 是否移除记录(发送响应时)
+ */
+bool ImplBaseServer::IsV1Request(const sockaddr_un& client_addr, int64_t id, bool remove) {
+    if (v1_requests_count_ == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lck(v1_requests_mutex_);
+    auto iter = v1_requests_.find(RequestKey(client_addr.sun_path, id));
+    if (iter == v1_requests_.end()) {
+        return false;
+    }
+    if (remove) {
+        v1_requests_.erase(iter);
+        v1_requests_count_ = v1_requests_.size();
     }
+    return true;
 }
 
 } // namespace _detail
@@ -9,21 +9,38 @@
  */
 #ifndef IC_UDS_IMPL_BASE_SERVER_H_
 #define IC_UDS_IMPL_BASE_SERVER_H_
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <system_error>
+#include <vector>
 #include <sys/un.h>
 #include "uds_packet.h"
+#include "../priority.h"
 
 namespace ic {
 namespace uds {
 
+class AdmissionController;
 class BaseServer;
+class FairQueue;
 class StaticThreadPool;
+class SubscriptionTable;
+struct AdmissionLimits;
+struct DispatchInfo;
+struct RequestContext;
+enum class StreamEvent;
 
 namespace _detail {
 
+struct ServerStream;
+
 using tp = std::chrono::steady_clock::time_point;
 
 /**
@@ -62,21 +79,125 @@ public:
      */
     bool SendResponse(const sockaddr_un& client_addr, int64_t request_id, const std::string& data);
 
+    /**
+     * @brief 返回给客户端响应数据(多个片段按顺序组成一个响应).
+     */
+    bool SendResponse(const sockaddr_un& client_addr, int64_t request_id, const std::vector<std::string_view>& buffers);
+
+    /**
+     * @brief 响应数据流.
+     */
+    void OpenResponseStream(const sockaddr_un& client_addr, int64_t id, std::error_code& ec);
+    void WriteResponseStream(const sockaddr_un& client_addr, int64_t id, uint32_t seq, const char* data, size_t len, uint32_t timeout_ms, std::error_code& ec);
+    void FinishResponseStream(const sockaddr_un& client_addr, int64_t id, uint32_t end_seq, std::error_code& ec);
+    void CloseResponseStream(const sockaddr_un& client_addr, int64_t id, bool abort);
+    size_t stream_chunk_size() const;
+    void set_stream_window(uint32_t packets) { stream_window_ = packets > 0 ? packets : 1; }
+
+    /**
+     * @brief 发布消息给主题的所有订阅者.
+     * 
+     * @return 发送成功的订阅者数量
+     */
+    size_t Publish(const std::string& topic, const std::string& data);
+
+    /**
+     * @brief 判断订阅者是否过慢的观察窗口(毫秒).
+     */
+    void set_subscriber_timeout_ms(uint32_t timeout_ms);
+
+    /**
+     * @brief 主题的订阅者数量.
+     */
+    size_t subscribers_count(const std::string& topic) const;
+
+    /**
+     * @brief 被移除的订阅者数量.
+     */
+    uint64_t evicted_subscribers_count() const;
+
     /**
      * @brief 收到请求后的回调函数.
      * 
      * @details 如果需要发送响应给客户端，可以调用`server->SendResponse()`方法.
      * 
      * @param server 当前服务器指针
-     * @param client_addr 请求方地址
-     * @param request_id 请求ID(客户端指定)
+     * @param context 请求上下文(请求方地址、请求ID、截止时间等)
      * @param data 请求内容
      */
     using RequestCallback = std::function<void(
-        BaseServer* server, const sockaddr_un& client_addr, int64_t request_id, const std::string& data
+        BaseServer* server, const RequestContext& context, const std::string& data
     )>;
     void set_request_callback(RequestCallback callback) { request_callback_ = callback; }
 
+    /**
+     * @brief 数据流回调函数，同一个数据流的事件按顺序调用.
+     */
+    using StreamCallback = std::function<void(
+        BaseServer* server, const RequestContext& context, StreamEvent event, const std::string& chunk
+    )>;
+    void set_stream_callback(StreamCallback callback) { stream_callback_ = callback; }
+
+    /**
+     * @brief 请求分类回调函数，在接收线程上调用，可以修改请求的调度信息.
+     */
+    using ClassifyCallback = std::function<void(
+        const sockaddr_un& client_addr, const std::string& data, DispatchInfo& info
+    )>;
+    void set_classify_callback(ClassifyCallback callback) { classify_callback_ = callback; }
+
+    /**
+     * @brief 设置优先级老化间隔(毫秒)，为0时按严格优先级调度.
+     */
+    void set_priority_aging_ms(uint32_t aging_ms);
+
+    /**
+     * @brief 启用/禁用按客户端公平排队，需在Start之前调用.
+     */
+    void set_fair_queuing(bool enabled, size_t quantum_bytes);
+
+    /**
+     * @brief 每个客户端排队中的请求数量.
+     */
+    std::map<std::string, size_t> GetClientQueueDepths() const;
+
+    /**
+     * @brief 设置准入限制.
+     */
+    void set_admission_limits(const AdmissionLimits& limits);
+
+    /**
+     * @brief 因过载被拒绝的请求数量.
+     */
+    uint64_t rejected_requests_count() const;
+
+    /**
+     * @brief 因超过客户端截止时间而未处理的请求数量.
+     */
+    uint64_t expired_requests_count() const { return expired_requests_count_; }
+
+    /**
+     * @brief 被客户端取消且尚未开始处理的请求数量.
+     */
+    uint64_t cancelled_requests_count() const { return cancelled_requests_count_; }
+
+    /**
+     * @brief 启用/禁用响应数据压缩.
+     */
+    void set_compression(bool enabled, size_t threshold_bytes) {
+        compression_threshold_ = enabled ? (threshold_bytes > 0 ? threshold_bytes : 1) : 0;
+    }
+
+    /**
+     * @brief 启用/禁用响应数据的CRC32C校验.
+     */
+    void set_checksum(bool enabled) { checksum_ = enabled; }
+
+    /**
+     * @brief 校验失败的请求数量.
+     */
+    uint64_t checksum_errors_count() const { return checksum_errors_count_; }
+
     const std::string& socket_file() const { return socket_file_; }
     size_t thread_pool_size() const { return thread_pool_size_; }
 
@@ -85,6 +206,21 @@ public:
 private:
     void CleanupBuffers(const tp& before);
     void ProcessRequestPacket(const sockaddr_un& client_addr, Packet*& packet);
+    void Dispatch(const sockaddr_un& client_addr, int64_t id, const PacketMeta& meta, std::string&& data);
+    void ProcessCancel(const sockaddr_un& client_addr, int64_t id);
+    void ProcessSubscribe(const sockaddr_un& client_addr, int64_t id, const PacketMeta& meta, const std::string& data);
+    void ProcessStreamPacket(const sockaddr_un& client_addr, Packet*& packet);
+    void AbortStream(const std::shared_ptr<ServerStream>& stream);
+    void DeliverStreamEvent(const std::shared_ptr<ServerStream>& stream, StreamEvent event, std::string&& chunk);
+    void RunStream(const std::shared_ptr<ServerStream>& stream);
+    void ProcessStreamAck(const sockaddr_un& client_addr, int64_t id, const std::string& data);
+    void AddInflight(const sockaddr_un& client_addr, int64_t id, const std::shared_ptr<std::atomic_bool>& cancel_flag);
+    void RemoveInflight(const sockaddr_un& client_addr, int64_t id, const std::shared_ptr<std::atomic_bool>& cancel_flag);
+    void UpdateV1Requests(const sockaddr_un& client_addr, int64_t id, uint8_t version);
+    bool IsV1Request(const sockaddr_un& client_addr, int64_t id, bool remove);
+    bool AdmitClient(const sockaddr_un& client_addr) const;
+    void SendOverloaded(const sockaddr_un& client_addr, int64_t request_id, uint8_t version, uint32_t retry_after_ms);
+    void SendChecksumError(const sockaddr_un& client_addr, int64_t request_id, uint8_t version);
 
 private:
     bool inited_ = false;
@@ -98,14 +234,74 @@ private:
     BaseServer* base_server_;
     StaticThreadPool* thread_pool_ = nullptr;
 
+    /* 按客户端公平排队，每个优先级一个 */
+    bool fair_queuing_ = false;
+    FairQueue* fair_queues_ = nullptr;
+
+    /* 准入控制 */
+    AdmissionController* admission_ = nullptr;
+    size_t max_client_queue_length_ = 0;
+
+    /* 因超过截止时间而未处理的请求数量 */
+    std::atomic_uint64_t expired_requests_count_{0};
+
+    using RequestKey = std::pair<std::string, int64_t>;
+
+    /* 已进入队列、尚未处理完成的请求，按客户端地址索引，用于取消请求
+     * 客户端重复使用请求ID时可能有多个条目，按取消标志区分，移除时不影响其他请求
+     * 节点和客户端地址从内存池分配(由 inflight_mutex_ 保护)，每个请求不再调用malloc */
+    struct InflightRequest {
+        int64_t request_id;
+        std::shared_ptr<std::atomic_bool> cancel_flag;
+    };
+    std::mutex inflight_mutex_;
+    std::pmr::unsynchronized_pool_resource inflight_pool_;
+    std::pmr::multimap<std::pmr::string, InflightRequest, std::less<>> inflight_{ &inflight_pool_ };
+    std::atomic_uint64_t cancelled_requests_count_{0};
+
+    /* 发布/订阅 */
+    SubscriptionTable* subscriptions_ = nullptr;
+    std::atomic_int64_t publish_id_{1};
+
+    /* 响应数据的压缩阈值，0表示不压缩 */
+    size_t compression_threshold_ = 0;
+
+    /* 响应数据是否携带校验值 */
+    bool checksum_ = false;
+    std::atomic_uint64_t checksum_errors_count_{0};
+
     /* 接收到请求后的回调函数 */
     RequestCallback request_callback_;
 
+    /* 数据流回调函数 */
+    StreamCallback stream_callback_;
+
+    /* 请求分类回调函数 */
+    ClassifyCallback classify_callback_;
+
+    /* 优先级老化间隔(毫秒) */
+    uint32_t priority_aging_ms_ = 100;
+
     /* 上次清理缓存的时间 */
     tp last_cleanup_time_;
 
+    /* 使用v1协议的请求(尚未响应)及其到达时间，响应也使用v1协议
+     * 按请求记录，同一地址之后的v2客户端不受影响；发送响应后移除，超过60s未响应的由CleanupBuffers移除 */
+    std::mutex v1_requests_mutex_;
+    std::map<RequestKey, tp> v1_requests_;
+    std::atomic_size_t v1_requests_count_{0};
+
     /* 数据包缓存 */
-    std::map<std::pair<std::string, uint32_t>, Packets> buffers_;
+    std::map<RequestKey, Packets> buffers_;
+
+    /* 接收中的数据流，仅在接收线程中访问 */
+    std::map<RequestKey, std::shared_ptr<ServerStream>> streams_;
+
+    /* 发送中的响应数据流，值为客户端已确认的数据块序号 */
+    std::mutex response_streams_mutex_;
+    std::condition_variable response_streams_cv_;
+    std::map<RequestKey, uint32_t> response_streams_;
+    std::atomic_uint32_t stream_window_{32};
 
     int count_ = 0;
 };
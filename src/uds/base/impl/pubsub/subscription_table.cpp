@@ -0,0 +1,149 @@
+#include "subscription_table.h"
+#include <errno.h>
+
+namespace ic {
+namespace uds {
+
+void SubscriptionTable::Subscribe(const sockaddr_un& addr, const std::vector<std::string>& topics) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    std::string path(addr.sun_path);
+    Subscriber& subscriber = subscribers_[path];
+    subscriber.addr = addr;
+    for (auto& topic : topics) {
+        if (subscriber.topics.insert(topic).second) {
+            topics_[topic].paths.insert(path);
+            RebuildTopic(topic);
+        }
+    }
+}
+
+/**
+ * @brief 取消订阅.
+ */
+void SubscriptionTable::Unsubscribe(const sockaddr_un& addr, const std::vector<std::string>& topics) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    std::string path(addr.sun_path);
+    auto iter = subscribers_.find(path);
+    if (iter == subscribers_.end()) {
+        return;
+    }
+    if (topics.empty()) {
+        RemoveSubscriber(path);
+        return;
+    }
+    for (auto& topic : topics) {
+        if (iter->second.topics.erase(topic) > 0) {
+            topics_[topic].paths.erase(path);
+            RebuildTopic(topic);
+        }
+    }
+    if (iter->second.topics.empty()) {
+        subscribers_.erase(iter);
+    }
+}
+
+/**
+ * @brief 主题的所有订阅者.
+ */
+std::shared_ptr<const SubscriptionTable::Subscribers> SubscriptionTable::GetSubscribers(const std::string& topic) const {
+    std::lock_guard<std::mutex> lck(mutex_);
+    auto iter = topics_.find(topic);
+    if (iter == topics_.end()) {
+        return nullptr;
+    }
+    return iter->second.snapshot;
+}
+
+/**
+ * @brief 发布完成后调用，更新订阅者的发送失败状态.
+ * 
+ * @details 订阅者已不存在(进程退出)时立即移除；
+ *          接收缓冲区已满时记为丢失一条消息，观察窗口结束时丢失超过一半则移除.
+ */
+size_t SubscriptionTable::OnPublished(const Subscribers& subscribers, const std::vector<int>& errors, Subscribers* evicted) {
+    size_t delivered = 0;
+    auto now = clock::now();
+    auto timeout = std::chrono::milliseconds(timeout_ms_.load());
+    std::lock_guard<std::mutex> lck(mutex_);
+    for (size_t i = 0; i < subscribers.size(); ++i) {
+        auto iter = subscribers_.find(subscribers[i].sun_path);
+        if (iter == subscribers_.end()) {
+            continue;  /* 发布过程中已取消订阅 */
+        }
+        int err = errors[i];
+        Subscriber& subscriber = iter->second;
+        if (subscriber.published == 0) {
+            subscriber.window_start = now;
+        }
+        subscriber.published++;
+        if (err == 0) {
+            ++delivered;
+        }
+        else {
+            subscriber.dropped++;
+        }
+
+        bool dead = (err == ECONNREFUSED || err == ENOENT || err == ENOTCONN);
+        bool slow = false;
+        if (now - subscriber.window_start >= timeout) {
+            slow = (subscriber.dropped * 2 > subscriber.published);
+            subscriber.published = 0;
+            subscriber.dropped = 0;
+        }
+        if (dead || slow) {
+            if (!dead) {
+                evicted->push_back(subscriber.addr);
+            }
+            std::string path = iter->first;
+            RemoveSubscriber(path);
+            evicted_count_++;
+        }
+    }
+    return delivered;
+}
+
+size_t SubscriptionTable::subscribers_count(const std::string& topic) const {
+    std::lock_guard<std::mutex> lck(mutex_);
+    auto iter = topics_.find(topic);
+    return (iter == topics_.end()) ? 0 : iter->second.paths.size();
+}
+
+/**
+ * @brief 移除订阅者(需持有锁).
+ */
+void SubscriptionTable::RemoveSubscriber(const std::string& path) {
+    auto iter = subscribers_.find(path);
+    if (iter == subscribers_.end()) {
+        return;
+    }
+    std::set<std::string> topics;
+    topics.swap(iter->second.topics);
+    subscribers_.erase(iter);
+    for (auto& topic : topics) {
+        topics_[topic].paths.erase(path);
+        RebuildTopic(topic);
+    }
+}
+
+/**
+ * @brief 重新生成主题的订阅者列表(需持有锁).
+ */
+void SubscriptionTable::RebuildTopic(const std::string& topic) {
+    auto iter = topics_.find(topic);
+    if (iter == topics_.end()) {
+        return;
+    }
+    if (iter->second.paths.empty()) {
+        topics_.erase(iter);
+        return;
+    }
+    auto snapshot = std::make_shared<Subscribers>();
+    snapshot->reserve(iter->second.paths.size());
+    for (auto& path : iter->second.paths) {
+        snapshot->push_back(subscribers_[path].addr);
+    }
+    iter->second.snapshot = std::move(snapshot);
+}
+
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,98 @@
+/**
+ * @file subscription_table.h
+ * @brief 主题订阅表.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-22
+ * 
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_BASE_IMPL_PUBSUB_SUBSCRIPTION_TABLE_H_
+#define IC_UDS_BASE_IMPL_PUBSUB_SUBSCRIPTION_TABLE_H_
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/un.h>
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief 主题订阅表.
+ * 
+ * @details 每个主题缓存一份订阅者地址列表(写时复制)，发布时只需取得该列表的引用，不复制、不长时间持有锁.
+ * @details 订阅者以客户端地址区分，已不存在的订阅者立即移除；
+ *          每个观察窗口内超过一半的消息发送失败(接收缓冲区已满)的订阅者被认为过慢，也被移除.
+ *          不按连续失败次数判断：突发发布时正常的订阅者也可能短暂地接收不过来(单个套接字排队的数据报数量有限).
+ */
+class SubscriptionTable {
+public:
+    using Subscribers = std::vector<sockaddr_un>;
+    using clock = std::chrono::steady_clock;
+
+    void Subscribe(const sockaddr_un& addr, const std::vector<std::string>& topics);
+
+    /**
+     * @brief 取消订阅.
+     * 
+     * @param topics 为空表示取消全部
+     */
+    void Unsubscribe(const sockaddr_un& addr, const std::vector<std::string>& topics);
+
+    /**
+     * @brief 主题的所有订阅者，没有订阅者时返回nullptr.
+     */
+    std::shared_ptr<const Subscribers> GetSubscribers(const std::string& topic) const;
+
+    /**
+     * @brief 发布完成后调用，更新订阅者的发送失败状态.
+     * 
+     * @param subscribers 本次发布的订阅者
+     * @param errors 每个订阅者的错误码(errno)，0表示成功
+     * @param evicted [out] 被移除的订阅者
+     * @return 发送成功的订阅者数量
+     */
+    size_t OnPublished(const Subscribers& subscribers, const std::vector<int>& errors, Subscribers* evicted);
+
+    /**
+     * @brief 判断订阅者是否过慢的观察窗口(毫秒)，默认1000毫秒.
+     */
+    void set_timeout_ms(uint32_t timeout_ms) { timeout_ms_ = timeout_ms; }
+
+    size_t subscribers_count(const std::string& topic) const;
+    uint64_t evicted_count() const { return evicted_count_; }
+
+private:
+    void RemoveSubscriber(const std::string& path);
+    void RebuildTopic(const std::string& topic);
+
+private:
+    struct Subscriber {
+        sockaddr_un addr;
+        std::set<std::string> topics;
+        clock::time_point window_start{};  /* 当前观察窗口的开始时间 */
+        uint32_t published{0};             /* 当前观察窗口内发布的消息数量 */
+        uint32_t dropped{0};               /* 其中发送失败的数量 */
+    };
+    struct Topic {
+        std::set<std::string> paths;
+        std::shared_ptr<const Subscribers> snapshot;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Subscriber> subscribers_;  /* 键为客户端地址 */
+    std::map<std::string, Topic> topics_;
+
+    std::atomic_uint32_t timeout_ms_{1000};
+    std::atomic_uint64_t evicted_count_{0};
+};
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_BASE_IMPL_PUBSUB_SUBSCRIPTION_TABLE_H_
@@ -9,10 +9,12 @@ namespace uds {
  * @brief 构造函数.
  * 
  * @param size 线程池大小
+ * @param priority_levels 优先级的数量
  */
-StaticThreadPool::StaticThreadPool(size_t size)
-    : shared_src_(std::make_shared<pool_src>()), size_(size)
+StaticThreadPool::StaticThreadPool(size_t size, size_t priority_levels/* = 1*/)
+    : size_(size), shared_src_(std::make_shared<pool_src>())
 {
+    shared_src_->queues.resize(std::max<size_t>(priority_levels, 1));
     for (size_t i = 0; i < size_; ++i) {
         std::thread t([this]{
             auto src = this->shared_src_;
@@ -21,13 +23,15 @@ StaticThreadPool::StaticThreadPool(size_t size)
                 {
                     std::unique_lock<std::mutex> lck(src->queue_mutex);
                     src->cv.wait(lck, [&]{
-                        return src->shutdown || !src->queue.empty();
+                        return src->shutdown || src->queued_tasks_count > 0;
                     });
-                    if (src->shutdown && src->queue.empty()) {
+                    if (src->shutdown && src->queued_tasks_count == 0) {
                         return;
                     }
-                    task = std::move(src->queue.front());
-                    src->queue.pop();
+                    auto& queue = src->queues[PickQueue(src.get())];
+                    task = std::move(queue.front().task);
+                    queue.pop_front();
+                    src->queued_tasks_count--;
                 }
                 task();
                 if (src->running_tasks_count.fetch_sub(1) == 1) {
@@ -50,6 +54,41 @@ StaticThreadPool::~StaticThreadPool() {
     std::this_thread::sleep_for(std::chrono::milliseconds(10));
 }
 
+/**
+ * @brief 设置老化间隔，为0时不老化.
+ */
+void StaticThreadPool::set_aging_interval(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lck(shared_src_->queue_mutex);
+    shared_src_->aging_interval = interval;
+}
+
+/**
+ * @brief 选择下一个要执行的任务所在的队列(需持有queue_mutex).
+ * 
+ * @details 有效优先级 = 队列优先级 + 队首任务已等待的老化间隔数，取最大者；相同时取原优先级高的.
+ */
+size_t StaticThreadPool::PickQueue(pool_src* src) {
+    const auto& queues = src->queues;
+    size_t best = queues.size();
+    if (src->aging_interval.count() <= 0) {
+        while (best-- > 0 && queues[best].empty()) {}
+        return best;
+    }
+    auto now = clock::now();
+    size_t best_score = 0;
+    for (size_t i = queues.size(); i-- > 0;) {
+        if (queues[i].empty()) {
+            continue;
+        }
+        size_t score = i + static_cast<size_t>((now - queues[i].front().enqueue_time) / src->aging_interval);
+        if (best == queues.size() || score > best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
 /**
  * @brief 等待所有任务完成.
  */
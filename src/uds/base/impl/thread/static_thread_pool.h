@@ -10,28 +10,50 @@
 #ifndef IC_UDS_BASE_IMPL_THREAD_STATIC_THREAD_POOL_
 #define IC_UDS_BASE_IMPL_THREAD_STATIC_THREAD_POOL_
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <vector>
+#include "../../priority.h"
 
 namespace ic {
 namespace uds {
 
+/**
+ * @brief 静态线程池.
+ *
+ * @details 每个优先级一个队列，总是先执行优先级最高的任务(严格优先级).
+ * @details 设置了老化间隔时，任务每等待一个间隔，优先级提升一级，避免低优先级任务饿死.
+ */
 class StaticThreadPool {
 public:
-    explicit StaticThreadPool(size_t size = std::thread::hardware_concurrency() + 2);
+    explicit StaticThreadPool(size_t size = std::thread::hardware_concurrency() + 2, size_t priority_levels = 1);
     ~StaticThreadPool();
 
     /**
-     * @brief 添加任务到队列.
+     * @brief 添加任务到队列(Priority::Normal，只有一个优先级时即为该队列).
      */
     template<typename Func, typename... Args>
     auto Enqueue(Func&& f, Args &&... args) -> std::future<typename std::result_of<Func(Args...)>::type>;
 
+    /**
+     * @brief 添加任务到指定优先级的队列.
+     *
+     * @param priority 优先级，数值越大越优先，超出范围时按最高优先级处理
+     */
+    template<typename Func, typename... Args>
+    auto EnqueueWithPriority(size_t priority, Func&& f, Args &&... args) -> std::future<typename std::result_of<Func(Args...)>::type>;
+
+    /**
+     * @brief 设置老化间隔，为0时不老化.
+     */
+    void set_aging_interval(std::chrono::milliseconds interval);
+
     /**
      * @brief 等待所有任务完成.
      */
@@ -47,21 +69,39 @@ public:
      */
     size_t running_tasks_count() const { return shared_src_->running_tasks_count; }
 
+    /**
+     * @brief 优先级的数量.
+     */
+    size_t priority_levels() const { return shared_src_->queues.size(); }
+
 private:
     template <typename Type, typename Func, typename ... Args>
     inline void TryAllocate(Type& task, Func&& f, Args&& ... args);
 
 private:
+    using clock = std::chrono::steady_clock;
     using task_type = std::function<void()>;
+    struct task_entry {
+        task_type task;
+        clock::time_point enqueue_time;
+    };
     struct pool_src {
         bool shutdown{false};
         std::mutex queue_mutex;
         std::mutex wait_mutex;
         std::condition_variable cv;
         std::condition_variable wait_cv;
-        std::queue<task_type> queue;
+        std::vector<std::deque<task_entry>> queues;  /* 下标即优先级 */
+        size_t queued_tasks_count{0};
+        clock::duration aging_interval{0};
         std::atomic_size_t running_tasks_count{0};
     };
+
+    /**
+     * @brief 选择下一个要执行的任务所在的队列(需持有queue_mutex).
+     */
+    static size_t PickQueue(pool_src* src);
+
     const size_t size_;
     std::shared_ptr<pool_src> shared_src_;
 };
@@ -83,11 +123,21 @@ inline void StaticThreadPool::TryAllocate(Type& task, Func&& f, Args&& ... args)
 }
 
 /**
- * @brief 添加任务到队列.
+ * @brief 添加任务到队列(Priority::Normal).
  */
 template<typename Func, typename... Args>
 auto StaticThreadPool::Enqueue(Func&& f, Args &&... args)
     -> std::future<typename std::result_of<Func(Args...)>::type>
+{
+    return EnqueueWithPriority(static_cast<size_t>(Priority::Normal), std::forward<Func>(f), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief 添加任务到指定优先级的队列.
+ */
+template<typename Func, typename... Args>
+auto StaticThreadPool::EnqueueWithPriority(size_t priority, Func&& f, Args &&... args)
+    -> std::future<typename std::result_of<Func(Args...)>::type>
 {
     using return_type = typename std::result_of<Func(Args...)>::type;
     std::packaged_task<return_type()>* task = nullptr;
@@ -95,10 +145,18 @@ auto StaticThreadPool::Enqueue(Func&& f, Args &&... args)
     auto result = task->get_future();
     {
         std::lock_guard<std::mutex> lck(shared_src_->queue_mutex);
-        shared_src_->queue.push([task]{
-            (*task)();
-            delete task;
+        auto& queues = shared_src_->queues;
+        if (priority >= queues.size()) {
+            priority = queues.size() - 1;
+        }
+        queues[priority].push_back({
+            [task]{
+                (*task)();
+                delete task;
+            },
+            clock::now()
         });
+        shared_src_->queued_tasks_count++;
     }
     shared_src_->running_tasks_count.fetch_add(1);
     shared_src_->cv.notify_one();
@@ -1,5 +1,6 @@
 #include "uds_packet.h"
 #include <algorithm>
+#include "util/crc32c.h"
 
 namespace ic {
 namespace uds {
@@ -15,9 +16,10 @@ Packets::~Packets() {
 /**
  * @brief 组包，只能调用1次，调用后所有分包被清空.
  */
-std::string Packets::Merge() {
+bool Packets::Merge(std::string* data) {
+    data->clear();
     if (this->empty()) {
-        return {};
+        return true;
     }
 
     /* 排序 */
@@ -25,6 +27,27 @@ std::string Packets::Merge() {
         return p1->seq < p2->seq;
     });
 
+    /* 序列号必须为 1..total，且没有重复 */
+    bool valid = true;
+    uint32_t total = this->front()->total;
+    if (this->size() != total) {
+        valid = false;
+    }
+    for (size_t i = 0; valid && i < this->size(); ++i) {
+        if ((*this)[i]->seq != i + 1 || (*this)[i]->total != total) {
+            valid = false;
+        }
+    }
+
+    /* 完整消息的校验值由各分包内容的校验值合并得到，不需要再遍历一次数据 */
+    if (valid && (this->front()->meta.flags & PacketFlags::Checksum)) {
+        uint32_t crc = 0;
+        for (const auto& packet : *this) {
+            crc = util::crc32c_combine(crc, packet->data_crc, packet->data.size());
+        }
+        valid = (crc == this->back()->message_crc);
+    }
+
     /* 总数据量大小 */
     size_t total_size = 0;
     for (const auto& packet : *this) {
@@ -32,15 +55,18 @@ std::string Packets::Merge() {
     }
 
     /* 合并 */
-    std::string result;
-    result.reserve(total_size);
+    if (valid) {
+        data->reserve(total_size);
+    }
     for (auto& packet : *this) {
-        result.append(packet->data);
+        if (valid) {
+            data->append(packet->data);
+        }
         delete packet;
         packet = nullptr;
     }
     this->clear();
-    return result;
+    return valid;
 }
 
 } // namespace uds
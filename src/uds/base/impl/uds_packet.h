@@ -16,6 +16,67 @@
 namespace ic {
 namespace uds {
 
+/**
+ * @brief 数据包类型.
+ */
+enum class PacketType : uint8_t {
+    Data = 0,        /* 请求或响应数据 */
+    Overloaded = 1,  /* 服务端过载，拒绝处理请求(内容为建议的重试间隔，单位毫秒) */
+    Cancel = 2,      /* 客户端取消请求(没有内容) */
+    ChecksumError = 3,  /* 服务端收到的请求校验失败(没有内容) */
+    StreamData = 4,  /* 数据流(请求或响应)的数据块，seq为数据块序号(从1开始)，total为0 */
+    StreamEnd = 5,   /* 数据流结束，seq为最后一个数据块序号+1(没有内容) */
+    StreamAck = 6,   /* 接收方已处理的数据块序号(4字节)，用于流量控制 */
+    Subscribe = 7,   /* 客户端订阅主题(内容为以'\0'分隔的主题列表)，服务端返回空响应 */
+    Unsubscribe = 8, /* 客户端取消订阅(内容同上，为空表示全部)；服务端发送时表示该客户端已被移除 */
+    Publish = 9,     /* 服务端发布的消息，内容为 2字节(主题长度) + 主题 + 数据 */
+};
+
+/**
+ * @brief 协议版本.
+ * 
+ * @details v1: 16字节头部(id + packets_total + packet_seq)，没有附加字段.
+ * @details v2: 以魔数开头的40字节固定头部 + TLV扩展字段，见 util::send_data.
+ */
+static constexpr uint8_t PACKET_VERSION_1 = 1;
+static constexpr uint8_t PACKET_VERSION_2 = 2;
+static constexpr uint8_t PACKET_VERSION = PACKET_VERSION_2;
+
+/**
+ * @brief 数据包头部的标志位(v2).
+ */
+struct PacketFlags {
+    static constexpr uint16_t Compressed = 0x0001;  /* 内容已压缩 */
+    static constexpr uint16_t Batched    = 0x0002;  /* 内容包含多个消息 */
+    static constexpr uint16_t FdAttached = 0x0004;  /* 附带文件描述符 */
+    static constexpr uint16_t Priority   = 0x0008;  /* 优先级字段有效 */
+    static constexpr uint16_t Deadline   = 0x0010;  /* 截止时间字段有效 */
+    static constexpr uint16_t Checksum   = 0x0020;  /* 携带CRC32C校验值 */
+};
+
+/**
+ * @brief TLV扩展字段的类型(v2)，接收方忽略不认识的类型.
+ * 
+ * @details 格式： 1字节(type) + 1字节(length) + value
+ */
+enum class PacketExtension : uint8_t {
+    Padding = 0,        /* 填充，没有内容 */
+    MessageCrc32c = 1,  /* 完整消息的CRC32C(4字节)，仅最后一个分包携带有效值 */
+    RouteHint = 2,      /* 请求的路由(如JSON请求的路径)，内容被压缩时携带，服务端解压前据此分类 */
+};
+
+/**
+ * @brief 数据包头部的附加字段，每个分包都携带.
+ */
+struct PacketMeta {
+    uint8_t version{PACKET_VERSION};  /* 协议版本，发送给v1对端时为1(不携带其余附加字段) */
+    PacketType type{PacketType::Data};
+    uint16_t flags{0};    /* PacketFlags，优先级和截止时间的标志位发送时自动设置 */
+    uint8_t priority{1};  /* 优先级(Priority) */
+    int64_t deadline{0};  /* 请求的截止时间(steady_clock，纳秒)，0表示没有 */
+    std::string extensions;  /* TLV扩展字段(原始字节) */
+};
+
 /**
  * @brief 数据包.
  */
@@ -23,8 +84,12 @@ struct Packet {
     uint32_t total;  /* 数据包总量 */
     uint32_t seq;    /* 当前数据包的序列号 */
     int64_t id;      /* 完整数据包的ID */
+    PacketMeta meta;   /* 附加字段 */
     std::chrono::steady_clock::time_point arrive_time;  /* 当前数据包到达时间 */
     std::string data;  /* 数据包内容 */
+    uint32_t data_crc{0};     /* 数据包内容的CRC32C(接收时计算，仅携带校验值时有效) */
+    uint32_t message_crc{0};  /* 完整消息的CRC32C(发送方填写) */
+    bool corrupted{false};    /* 分包校验失败 */
 };
 
 /**
@@ -34,8 +99,10 @@ struct Packets : std::vector<Packet*> {
     ~Packets();
     /**
      * @brief 组包，只能调用1次，调用后所有分包被清空.
+     * 
+     * @retval false 分包序列号不完整，或者完整消息的校验失败
      */
-    std::string Merge();
+    bool Merge(std::string* data);
 };
 
 } // namespace uds
@@ -0,0 +1,94 @@
+#include "compress.h"
+#include <lz4/lz4_block.h>
+#include "uds_util.h"
+
+namespace ic {
+namespace uds {
+namespace util {
+
+/**
+ * @brief 原始长度字段的长度.
+ */
+static const size_t COMPRESS_HEADER_SIZE = 4;
+
+/**
+ * @brief LZ4的最大压缩比约为255，用于在分配内存前检查原始长度是否合理.
+ */
+static const size_t MAX_COMPRESS_RATIO = 255;
+
+/**
+ * @brief 压缩数据(LZ4块格式).
+ */
+bool compress(std::string_view data, std::string* out) {
+    size_t len = data.length();
+    if (len > UINT32_MAX) {
+        return false;
+    }
+    uint32_t original_size = static_cast<uint32_t>(len);
+    out->resize(COMPRESS_HEADER_SIZE + lz4_block::compress_bound(len));
+    memcpy(&(*out)[0], &original_size, COMPRESS_HEADER_SIZE);
+    size_t n = lz4_block::compress(data.data(), len, &(*out)[COMPRESS_HEADER_SIZE], out->length() - COMPRESS_HEADER_SIZE);
+    if (n == 0 || COMPRESS_HEADER_SIZE + n >= len) {
+        return false;
+    }
+    out->resize(COMPRESS_HEADER_SIZE + n);
+    return true;
+}
+
+/**
+ * @brief 解压数据.
+ */
+bool decompress(const std::string& data, std::string* out) {
+    if (data.length() < COMPRESS_HEADER_SIZE) {
+        return false;
+    }
+    uint32_t original_size = 0;
+    memcpy(&original_size, data.data(), COMPRESS_HEADER_SIZE);
+    size_t compressed_size = data.length() - COMPRESS_HEADER_SIZE;
+    if (original_size > compressed_size * MAX_COMPRESS_RATIO + 16) {
+        return false;
+    }
+    out->resize(original_size);
+    long n = lz4_block::decompress(data.data() + COMPRESS_HEADER_SIZE, compressed_size, &(*out)[0], original_size);
+    return n == static_cast<long>(original_size);
+}
+
+/**
+ * @brief 数据长度不小于阈值时尝试压缩，压缩成功时设置meta的Compressed标志.
+ */
+const std::string& compress_if_needed(const std::string& data, size_t threshold, std::string* buffer, PacketMeta* meta) {
+    if (threshold == 0 || data.length() < threshold || meta->version == PACKET_VERSION_1) {
+        return data;
+    }
+    if (!compress(data, buffer)) {
+        return data;
+    }
+    meta->flags |= PacketFlags::Compressed;
+    return *buffer;
+}
+
+/**
+ * @brief 多个片段的总长度不小于阈值时，合并后尝试压缩.
+ */
+bool compress_if_needed(const std::string_view* buffers, size_t buffers_count, size_t threshold, std::string* buffer, PacketMeta* meta) {
+    if (threshold == 0 || meta->version == PACKET_VERSION_1) {
+        return false;
+    }
+    size_t len = 0;
+    for (size_t i = 0; i < buffers_count; ++i) {
+        len += buffers[i].length();
+    }
+    if (len < threshold) {
+        return false;
+    }
+    bool compressed = (buffers_count == 1) ? compress(buffers[0], buffer) : compress(join_buffers(buffers, buffers_count), buffer);
+    if (!compressed) {
+        return false;
+    }
+    meta->flags |= PacketFlags::Compressed;
+    return true;
+}
+
+} // namespace util
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,55 @@
+/**
+ * @file compress.h
+ * @brief 数据压缩.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-12
+ * 
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_BASE_IMPL_UTIL_COMPRESS_H_
+#define IC_UDS_BASE_IMPL_UTIL_COMPRESS_H_
+#include <string>
+#include <string_view>
+#include "../uds_packet.h"
+
+namespace ic {
+namespace uds {
+namespace util {
+
+/**
+ * @brief 压缩数据(LZ4块格式).
+ * 
+ * @details 格式： 4字节(原始长度) + LZ4块
+ * @retval false 压缩后没有变小，应发送原始数据
+ */
+bool compress(std::string_view data, std::string* out);
+
+/**
+ * @brief 解压数据.
+ * 
+ * @retval false 数据格式错误
+ */
+bool decompress(const std::string& data, std::string* out);
+
+/**
+ * @brief 数据长度不小于阈值时尝试压缩，压缩成功时设置meta的Compressed标志.
+ * 
+ * @param threshold 阈值，为0时不压缩
+ * @param buffer 存放压缩后的数据
+ * @return 待发送的数据(data或者*buffer)
+ */
+const std::string& compress_if_needed(const std::string& data, size_t threshold, std::string* buffer, PacketMeta* meta);
+
+/**
+ * @brief 多个片段的总长度不小于阈值时，合并后尝试压缩.
+ * 
+ * @return 是否压缩成功(压缩后的数据存放在buffer中，并设置meta的Compressed标志)
+ */
+bool compress_if_needed(const std::string_view* buffers, size_t buffers_count, size_t threshold, std::string* buffer, PacketMeta* meta);
+
+} // namespace util
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_BASE_IMPL_UTIL_COMPRESS_H_
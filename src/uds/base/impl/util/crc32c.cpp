@@ -0,0 +1,238 @@
+#include "crc32c.h"
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define IC_UDS_CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define IC_UDS_CRC32C_ARM 1
+#endif
+
+namespace ic {
+namespace uds {
+namespace util {
+
+/**
+ * @brief CRC32C多项式(反射).
+ */
+static const uint32_t CRC32C_POLY = 0x82F63B78;
+
+/**
+ * @brief 查表法(slicing-by-8)使用的表.
+ */
+struct Crc32cTable {
+    uint32_t t[8][256];
+
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; ++k) {
+                crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : (crc >> 1);
+            }
+            t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+            }
+        }
+    }
+};
+
+static const Crc32cTable& table() {
+    static const Crc32cTable s_table;
+    return s_table;
+}
+
+/**
+ * @brief 查表法，dst不为空时同时复制数据.
+ */
+static uint32_t crc32c_sw(uint32_t crc, uint8_t* dst, const uint8_t* src, size_t len) {
+    const Crc32cTable& tb = table();
+    crc = ~crc;
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, src, 8);
+        if (dst) {
+            memcpy(dst, &v, 8);
+            dst += 8;
+        }
+        v ^= crc;
+        crc = tb.t[7][v & 0xff] ^ tb.t[6][(v >> 8) & 0xff] ^ tb.t[5][(v >> 16) & 0xff] ^ tb.t[4][(v >> 24) & 0xff]
+            ^ tb.t[3][(v >> 32) & 0xff] ^ tb.t[2][(v >> 40) & 0xff] ^ tb.t[1][(v >> 48) & 0xff] ^ tb.t[0][v >> 56];
+        src += 8;
+        len -= 8;
+    }
+    while (len--) {
+        uint8_t b = *src++;
+        if (dst) {
+            *dst++ = b;
+        }
+        crc = (crc >> 8) ^ tb.t[0][(crc ^ b) & 0xff];
+    }
+    return ~crc;
+}
+
+#if defined(IC_UDS_CRC32C_X86)
+/**
+ * @brief SSE4.2指令，dst不为空时同时复制数据.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, uint8_t* dst, const uint8_t* src, size_t len) {
+    uint64_t c = ~crc;
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, src, 8);
+        if (dst) {
+            memcpy(dst, &v, 8);
+            dst += 8;
+        }
+        c = _mm_crc32_u64(c, v);
+        src += 8;
+        len -= 8;
+    }
+    uint32_t c32 = static_cast<uint32_t>(c);
+    while (len--) {
+        uint8_t b = *src++;
+        if (dst) {
+            *dst++ = b;
+        }
+        c32 = _mm_crc32_u8(c32, b);
+    }
+    return ~c32;
+}
+
+static bool hw_supported() {
+    static const bool s_supported = __builtin_cpu_supports("sse4.2");
+    return s_supported;
+}
+#elif defined(IC_UDS_CRC32C_ARM)
+/**
+ * @brief ARMv8 CRC指令，dst不为空时同时复制数据.
+ */
+static uint32_t crc32c_hw(uint32_t crc, uint8_t* dst, const uint8_t* src, size_t len) {
+    crc = ~crc;
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, src, 8);
+        if (dst) {
+            memcpy(dst, &v, 8);
+            dst += 8;
+        }
+        crc = __crc32cd(crc, v);
+        src += 8;
+        len -= 8;
+    }
+    while (len--) {
+        uint8_t b = *src++;
+        if (dst) {
+            *dst++ = b;
+        }
+        crc = __crc32cb(crc, b);
+    }
+    return ~crc;
+}
+
+static bool hw_supported() {
+    return true;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t len) {
+#if defined(IC_UDS_CRC32C_X86) || defined(IC_UDS_CRC32C_ARM)
+    if (hw_supported()) {
+        return crc32c_hw(crc, nullptr, static_cast<const uint8_t*>(data), len);
+    }
+#endif
+    return crc32c_sw(crc, nullptr, static_cast<const uint8_t*>(data), len);
+}
+
+uint32_t crc32c_copy(uint32_t crc, void* dst, const void* src, size_t len) {
+#if defined(IC_UDS_CRC32C_X86) || defined(IC_UDS_CRC32C_ARM)
+    if (hw_supported()) {
+        return crc32c_hw(crc, static_cast<uint8_t*>(dst), static_cast<const uint8_t*>(src), len);
+    }
+#endif
+    return crc32c_sw(crc, static_cast<uint8_t*>(dst), static_cast<const uint8_t*>(src), len);
+}
+
+/**
+ * @brief GF(2)上的32x32矩阵运算，用于合并校验值.
+ */
+static uint32_t gf2_matrix_times(const uint32_t* mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        ++mat;
+    }
+    return sum;
+}
+
+static void gf2_matrix_multiply(uint32_t* result, const uint32_t* a, const uint32_t* b) {
+    for (int n = 0; n < 32; ++n) {
+        result[n] = gf2_matrix_times(a, b[n]);
+    }
+}
+
+/**
+ * @brief 在校验值后追加len个0字节对应的变换矩阵.
+ */
+static void zeros_operator(uint32_t* op, size_t len) {
+    uint32_t odd[32], even[32], tmp[32];
+    /* 1个0比特 */
+    odd[0] = CRC32C_POLY;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; ++n) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    gf2_matrix_multiply(even, odd, odd);  /* 2个0比特 */
+    gf2_matrix_multiply(odd, even, even); /* 4个0比特 */
+
+    /* 单位矩阵 */
+    for (int n = 0; n < 32; ++n) {
+        op[n] = 1U << n;
+    }
+    do {
+        gf2_matrix_multiply(even, odd, odd);
+        if (len & 1) {
+            gf2_matrix_multiply(tmp, even, op);
+            memcpy(op, tmp, sizeof(tmp));
+        }
+        len >>= 1;
+        if (len == 0) {
+            break;
+        }
+        gf2_matrix_multiply(odd, even, even);
+        if (len & 1) {
+            gf2_matrix_multiply(tmp, odd, op);
+            memcpy(op, tmp, sizeof(tmp));
+        }
+        len >>= 1;
+    } while (len);
+}
+
+/**
+ * @brief 合并两段数据的校验值.
+ * 
+ * @details 分包长度大多相同，缓存最近一次长度对应的变换矩阵，合并只需一次矩阵乘向量.
+ */
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2) {
+    if (len2 == 0) {
+        return crc1;
+    }
+    thread_local size_t cached_len = 0;
+    thread_local uint32_t cached_op[32];
+    if (cached_len != len2) {
+        zeros_operator(cached_op, len2);
+        cached_len = len2;
+    }
+    return gf2_matrix_times(cached_op, crc1) ^ crc2;
+}
+
+} // namespace util
+} // namespace uds
+} // namespace ic
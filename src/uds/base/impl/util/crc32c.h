@@ -0,0 +1,45 @@
+/**
+ * @file crc32c.h
+ * @brief CRC32C(Castagnoli)校验.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-13
+ * 
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_BASE_IMPL_UTIL_CRC32C_H_
+#define IC_UDS_BASE_IMPL_UTIL_CRC32C_H_
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ic {
+namespace uds {
+namespace util {
+
+/**
+ * @brief 计算CRC32C，crc为之前数据的校验值(初始为0).
+ * 
+ * @details 支持时使用SSE4.2或者ARMv8的CRC指令，否则查表.
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t len);
+
+/**
+ * @brief 复制数据的同时计算CRC32C，不需要再遍历一次数据.
+ */
+uint32_t crc32c_copy(uint32_t crc, void* dst, const void* src, size_t len);
+
+/**
+ * @brief 合并两段数据的校验值.
+ * 
+ * @param crc1 第一段数据的校验值
+ * @param crc2 第二段数据的校验值
+ * @param len2 第二段数据的长度
+ * @return 两段数据拼接后的校验值
+ */
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+} // namespace util
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_BASE_IMPL_UTIL_CRC32C_H_
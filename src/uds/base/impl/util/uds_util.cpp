@@ -1,19 +1,35 @@
 #include "uds_util.h"
 #include <chrono>
+#include <algorithm>
+#include <errno.h>
 #include <thread>
+#include <sys/uio.h>
+#include "crc32c.h"
 
 namespace ic {
 namespace uds {
 namespace util {
 
 /**
- * @brief 最大发送缓冲区，单次发送包的有效数据的最大长度.
+ * @brief 单个数据报的最大长度.
  * 
- * @details IP首部(20) + UDP首部(8) + 自定义头部(16) + 65491 = 65535(64KB)
+ * @details IP首部(20) + UDP首部(8) + 65507 = 65535(64KB)，其中包括自定义头部.
  */
-static const size_t PACKET_CUSTOM_HEADER_SIZE = 16;
-static const size_t MAX_SEND_PACKET_DATA_SIZE = 65491;
-static const size_t MAX_SEND_BUFFER_SIZE = PACKET_CUSTOM_HEADER_SIZE + MAX_SEND_PACKET_DATA_SIZE;
+static const size_t MAX_DATAGRAM_SIZE = 65507;
+
+/**
+ * @brief 自定义头部的长度.
+ * 
+ * @details v2头部的长度字段只有1字节，TLV扩展字段最多 255-40 字节.
+ */
+static const size_t PACKET_V1_HEADER_SIZE = 16;
+static const size_t PACKET_V2_HEADER_SIZE = 40;
+static const size_t PACKET_MAX_HEADER_SIZE = 255;
+
+/**
+ * @brief v2头部的魔数("UDS2")，v1头部以请求ID开头，据此区分版本.
+ */
+static const uint32_t PACKET_V2_MAGIC = 0x32534455;
 
 /**
  * @brief 最大接收缓冲区，一般为64KB，这里设的大一些.
@@ -21,63 +37,397 @@ static const size_t MAX_SEND_BUFFER_SIZE = PACKET_CUSTOM_HEADER_SIZE + MAX_SEND_
 static const size_t MAX_RECV_BUFFER_SIZE = 131072; /* 128KB */
 
 /**
- * @brief 发送数据(发送一个数据报).
+ * @brief v2头部中各分包的校验值的偏移.
+ */
+static const size_t PACKET_V2_CRC_OFFSET = 28;
+
+/**
+ * @brief 完整消息的校验值(TLV扩展字段)的长度.
+ */
+static const size_t MESSAGE_CRC_EXTENSION_SIZE = 6;
+
+/**
+ * @brief 按固定偏移读取(不要求对齐).
+ */
+template <typename T>
+static inline T load(const char* p) {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief 生成头部(分包序列号除外，发送每个分包时填写).
  * 
- * @details 格式： 8字节(id) + 4字节(packets_total) + 4字节(packet_seq) + body
+ * @details v1格式： 8字节(id) + 4字节(packets_total) + 4字节(packet_seq)
+ * @details v2格式： 4字节(magic) + 1字节(version) + 1字节(header_len) + 2字节(flags)
+ *                 + 8字节(id) + 4字节(packets_total) + 4字节(packet_seq)
+ *                 + 1字节(type) + 1字节(priority) + 2字节(保留) + 4字节(crc) + 8字节(deadline)
+ *                 + TLV扩展字段(header_len - 40字节)
  * @details id: 请求ID，由客户端保证唯一.
  * @details packets_total: 分包数量.
  * @details packet_seq: 当前分包序列号.
+ * @details flags: 标志位(PacketFlags)，优先级、截止时间仅在对应标志位设置时有效.
+ * @details crc: 当前分包(头部+内容，计算时crc字段为0)的CRC32C，仅Checksum标志位设置时有效.
+ * @details deadline: 请求的截止时间(steady_clock，纳秒)，同一台机器上各进程的steady_clock一致.
+ * 
+ * @param message_crc_offset 不为空时追加完整消息校验值的扩展字段，返回其值的偏移
+ * @return 头部长度，0表示扩展字段过长
+ */
+static size_t s_make_header(char* header, int64_t request_id, uint32_t packets_total, const PacketMeta& meta, size_t* message_crc_offset) {
+    if (meta.version == PACKET_VERSION_1) {
+        memcpy(header,      &request_id,    8);
+        memcpy(header + 8,  &packets_total, 4);
+        return PACKET_V1_HEADER_SIZE;
+    }
+
+    size_t header_len = PACKET_V2_HEADER_SIZE + meta.extensions.length();
+    if (message_crc_offset) {
+        header_len += MESSAGE_CRC_EXTENSION_SIZE;
+    }
+    if (header_len > PACKET_MAX_HEADER_SIZE) {
+        return 0;
+    }
+    uint8_t version = PACKET_VERSION_2;
+    uint8_t header_len_u8 = static_cast<uint8_t>(header_len);
+    uint16_t flags = meta.flags | PacketFlags::Priority;
+    if (meta.deadline != 0) {
+        flags |= PacketFlags::Deadline;
+    }
+    memset(header, 0, PACKET_V2_HEADER_SIZE);
+    memcpy(header,      &PACKET_V2_MAGIC, 4);
+    memcpy(header + 4,  &version,         1);
+    memcpy(header + 5,  &header_len_u8,   1);
+    memcpy(header + 6,  &flags,           2);
+    memcpy(header + 8,  &request_id,      8);
+    memcpy(header + 16, &packets_total,   4);
+    memcpy(header + 24, &meta.type,       1);
+    memcpy(header + 25, &meta.priority,   1);
+    memcpy(header + 32, &meta.deadline,   8);
+    memcpy(header + PACKET_V2_HEADER_SIZE, meta.extensions.data(), meta.extensions.length());
+    if (message_crc_offset) {
+        char* ext = header + PACKET_V2_HEADER_SIZE + meta.extensions.length();
+        ext[0] = static_cast<char>(PacketExtension::MessageCrc32c);
+        ext[1] = 4;
+        memset(ext + 2, 0, 4);
+        *message_crc_offset = PACKET_V2_HEADER_SIZE + meta.extensions.length() + 2;
+    }
+    return header_len;
+}
+
+/**
+ * @brief 发送时的校验状态.
+ */
+struct ChecksumState {
+    uint32_t message_crc{0};  /* 已发送内容的校验值 */
+    size_t message_crc_offset{0};  /* 完整消息校验值在头部中的偏移，0表示不携带(只有1个分包) */
+};
+
+/**
+ * @brief 单个数据报最多引用的内容片段数量(不含头部)，片段更多时先合并.
+ */
+static const size_t MAX_PACKET_IOVS = 64;
+
+/**
+ * @brief 填写一个数据报的分包序列号和校验值.
+ * 
+ * @details 内容由 iov[1, iovcnt) 引用，不复制到发送缓冲区.
+ * 
+ * @param iov iov[0]为已写入头部的发送缓冲区
+ * @param seq_offset 头部中分包序列号的偏移
+ * @param len 内容的长度
+ * @param checksum 不为空时计算校验值
  */
-static bool s_send_data(
-    int fd,
-    const sockaddr_un& target_addr,
-    const char* data, size_t len,
-    int64_t request_id, uint32_t packets_total, uint32_t packet_seq)
+static void s_fill_packet(
+    const iovec* iov, size_t iovcnt, size_t seq_offset, size_t len,
+    uint32_t packet_seq, uint32_t packets_total, ChecksumState* checksum)
 {
-    static thread_local char send_buffer[MAX_SEND_BUFFER_SIZE + 1];
-    memset(send_buffer,      0,               sizeof(send_buffer));
-    memcpy(send_buffer,      &request_id,     8);
-    memcpy(send_buffer + 8,  &packets_total,  4);
-    memcpy(send_buffer + 12, &packet_seq,     4);
-    memcpy(send_buffer + 16, data,          len);
-    size_t buffer_len = 16 + len;
-    //printf("send %ld\n", request_id);
-    ssize_t n = ::sendto(fd, send_buffer, buffer_len, 0, (const sockaddr*)&target_addr, sizeof(sockaddr_un));
-    //printf("sent %ld\n", request_id);
+    char* header = static_cast<char*>(iov[0].iov_base);
+    size_t header_len = iov[0].iov_len;
+    memcpy(header + seq_offset, &packet_seq, 4);
+    if (!checksum) {
+        return;
+    }
+    uint32_t data_crc = 0;
+    for (size_t i = 1; i < iovcnt; ++i) {
+        data_crc = crc32c(data_crc, iov[i].iov_base, iov[i].iov_len);
+    }
+    checksum->message_crc = crc32c_combine(checksum->message_crc, data_crc, len);
+    if (packet_seq == packets_total && checksum->message_crc_offset > 0) {
+        memcpy(header + checksum->message_crc_offset, &checksum->message_crc, 4);
+    }
+    memset(header + PACKET_V2_CRC_OFFSET, 0, 4);
+    uint32_t crc = crc32c_combine(crc32c(0, header, header_len), data_crc, len);
+    memcpy(header + PACKET_V2_CRC_OFFSET, &crc, 4);
+}
+
+/**
+ * @brief 发送一个数据报(头部和内容不连续).
+ */
+static bool s_sendmsg(int fd, const sockaddr_un& target_addr, const iovec* iov, size_t iovcnt, size_t buffer_len) {
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = const_cast<sockaddr_un*>(&target_addr);
+    msg.msg_namelen = sizeof(sockaddr_un);
+    msg.msg_iov = const_cast<iovec*>(iov);
+    msg.msg_iovlen = iovcnt;
+    ssize_t n = ::sendmsg(fd, &msg, 0);
     if (n < 0) {
         return false;
     }
     else if (static_cast<size_t>(n) != buffer_len) {
-        fprintf(stderr, "sendto() failed, incomplete. %ld/%ld bytes", n, buffer_len);
+        fprintf(stderr, "sendmsg() failed, incomplete. %ld/%ld bytes", n, buffer_len);
         return false;
     }
     return true;
 }
 
 /**
- * @brief 发送数据，如果数据太长，则进行分包发送.
+ * @brief 发送缓冲区(只存放头部，内容通过iovec引用).
+ */
+static thread_local char s_send_buffer[PACKET_MAX_HEADER_SIZE + 1];
+
+/**
+ * @brief 单个数据报可以携带的最大数据长度.
+ */
+size_t max_packet_data_size(const PacketMeta& meta) {
+    if (meta.version == PACKET_VERSION_1) {
+        return MAX_DATAGRAM_SIZE - PACKET_V1_HEADER_SIZE;
+    }
+    return MAX_DATAGRAM_SIZE - PACKET_V2_HEADER_SIZE - meta.extensions.length();
+}
+
+/**
+ * @brief 发送单个数据报，由调用方指定分包数量和序列号.
+ */
+bool send_packet(int fd, const sockaddr_un& target_addr, int64_t request_id, uint32_t packets_total, uint32_t packet_seq,
+    const char* data, size_t len, const PacketMeta& meta)
+{
+    if (len > max_packet_data_size(meta)) {
+        return false;
+    }
+    size_t header_len = s_make_header(s_send_buffer, request_id, packets_total, meta, nullptr);
+    if (header_len == 0) {
+        return false;
+    }
+    iovec iov[2];
+    iov[0].iov_base = s_send_buffer;
+    iov[0].iov_len = header_len;
+    iov[1].iov_base = const_cast<char*>(data);
+    iov[1].iov_len = len;
+    size_t seq_offset = (meta.version == PACKET_VERSION_1) ? 12 : 20;
+    ChecksumState checksum_state;
+    bool checksum = (meta.version != PACKET_VERSION_1) && (meta.flags & PacketFlags::Checksum);
+    s_fill_packet(iov, 2, seq_offset, len, packet_seq, packets_total, checksum ? &checksum_state : nullptr);
+    return s_sendmsg(fd, target_addr, iov, 2, header_len + len);
+}
+
+/**
+ * @brief 将数据(多个不连续的片段)分包，依次生成每个数据报.
+ * 
+ * @details 头部写入发送缓冲区，内容通过iovec引用各个片段，不复制.
+ * 
+ * @param on_packet 每生成一个数据报调用一次，参数为(iovec数组, 数量, 数据报长度)，返回false时停止
  */
-bool send_data(int fd, const sockaddr_un& target_addr, int64_t request_id, const std::string& data) {
-    size_t len = data.length();
-    if (len <= MAX_SEND_PACKET_DATA_SIZE) {
-        if (!s_send_data(fd, target_addr, data.data(), len, request_id, 1, 1)) {
+template <typename OnPacket>
+static bool s_make_packets(int64_t request_id, const std::string_view* buffers, size_t buffers_count, const PacketMeta& meta, OnPacket&& on_packet) {
+    char* send_buffer = s_send_buffer;
+
+    bool checksum = (meta.version != PACKET_VERSION_1) && (meta.flags & PacketFlags::Checksum);
+    size_t header_len = PACKET_V2_HEADER_SIZE + meta.extensions.length();
+    if (meta.version == PACKET_VERSION_1) {
+        header_len = PACKET_V1_HEADER_SIZE;
+    }
+    size_t len = 0;
+    for (size_t i = 0; i < buffers_count; ++i) {
+        len += buffers[i].length();
+    }
+    size_t max_data_size = MAX_DATAGRAM_SIZE - header_len;
+    if (checksum && len > max_data_size) {
+        /* 分包时携带完整消息的校验值 */
+        header_len += MESSAGE_CRC_EXTENSION_SIZE;
+        max_data_size -= MESSAGE_CRC_EXTENSION_SIZE;
+    }
+    uint32_t packets_count = len / max_data_size, rem = len % max_data_size;
+    if (rem > 0 || packets_count == 0) {
+        packets_count += 1;
+    }
+
+    /* 头部只生成一次，每个分包仅修改序列号(和校验值) */
+    ChecksumState checksum_state;
+    size_t* message_crc_offset = (checksum && packets_count > 1) ? &checksum_state.message_crc_offset : nullptr;
+    if (s_make_header(send_buffer, request_id, packets_count, meta, message_crc_offset) == 0) {
+        fprintf(stderr, "send_data() failed, header extensions too long. %ld bytes", meta.extensions.length());
+        return false;
+    }
+    size_t seq_offset = (meta.version == PACKET_VERSION_1) ? 12 : 20;
+    ChecksumState* state = checksum ? &checksum_state : nullptr;
+
+    iovec iov[MAX_PACKET_IOVS + 1];
+    iov[0].iov_base = send_buffer;
+    iov[0].iov_len = header_len;
+    size_t index = 0, offset = 0;  /* 当前片段及其中的偏移 */
+    for (uint32_t seq = 1; seq <= packets_count; ++seq) {
+        /* 空消息(如取消请求)只有头部 */
+        size_t send_len = std::min(max_data_size, len - (seq - 1) * max_data_size);
+        size_t iovcnt = 1, filled = 0;
+        while (filled < send_len) {
+            while (buffers[index].length() == offset) {
+                ++index;
+                offset = 0;
+            }
+            if (iovcnt > MAX_PACKET_IOVS) {
+                return false;  /* 调用方保证片段数量不超过MAX_PACKET_IOVS */
+            }
+            size_t n = std::min(buffers[index].length() - offset, send_len - filled);
+            iov[iovcnt].iov_base = const_cast<char*>(buffers[index].data() + offset);
+            iov[iovcnt].iov_len = n;
+            ++iovcnt;
+            offset += n;
+            filled += n;
+        }
+        s_fill_packet(iov, iovcnt, seq_offset, send_len, seq, packets_count, state);
+        if (!on_packet(iov, iovcnt, header_len + send_len)) {
             return false;
         }
     }
-    else {
-        uint32_t packets_count = len / MAX_SEND_PACKET_DATA_SIZE, rem = len % MAX_SEND_PACKET_DATA_SIZE;
-        if (rem > 0) {
-            packets_count += 1;
+    return true;
+}
+
+/**
+ * @brief 发送数据，如果数据太长，则进行分包发送.
+ */
+bool send_data(int fd, const sockaddr_un& target_addr, int64_t request_id, const std::string& data, const PacketMeta& meta/* = PacketMeta()*/) {
+    std::string_view buffer(data);
+    return send_data(fd, target_addr, request_id, &buffer, 1, meta);
+}
+
+/**
+ * @brief 发送多个不连续的片段(按顺序组成一个消息)，不合并.
+ * 
+ * @details 每个数据报通过sendmsg引用各个片段，用户空间不复制数据.
+ * @details 片段数量超过 MAX_PACKET_IOVS 时(很少见)先合并为一个片段.
+ */
+bool send_data(int fd, const sockaddr_un& target_addr, int64_t request_id,
+    const std::string_view* buffers, size_t buffers_count, const PacketMeta& meta)
+{
+    if (buffers_count > MAX_PACKET_IOVS) {
+        std::string joined = join_buffers(buffers, buffers_count);
+        return send_data(fd, target_addr, request_id, joined, meta);
+    }
+    return s_make_packets(request_id, buffers, buffers_count, meta, [fd, &target_addr](const iovec* iov, size_t iovcnt, size_t buffer_len) {
+        return s_sendmsg(fd, target_addr, iov, iovcnt, buffer_len);
+    });
+}
+
+/**
+ * @brief 合并多个片段.
+ */
+std::string join_buffers(const std::string_view* buffers, size_t buffers_count) {
+    size_t len = 0;
+    for (size_t i = 0; i < buffers_count; ++i) {
+        len += buffers[i].length();
+    }
+    std::string result;
+    result.reserve(len);
+    for (size_t i = 0; i < buffers_count; ++i) {
+        result.append(buffers[i].data(), buffers[i].length());
+    }
+    return result;
+}
+
+/**
+ * @brief 生成数据的所有数据报(分包)，不发送.
+ */
+bool make_datagrams(int64_t request_id, const std::string& data, const PacketMeta& meta, std::vector<std::string>* datagrams) {
+    datagrams->clear();
+    std::string_view buffer(data);
+    return s_make_packets(request_id, &buffer, 1, meta, [datagrams](const iovec* iov, size_t iovcnt, size_t buffer_len) {
+        std::string datagram;
+        datagram.reserve(buffer_len);
+        for (size_t i = 0; i < iovcnt; ++i) {
+            datagram.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
         }
-        uint32_t seq = 1;
-        for (size_t i = 0; i < len; i += MAX_SEND_PACKET_DATA_SIZE, ++seq) {
-            size_t send_len = (seq < packets_count || rem == 0) ? MAX_SEND_PACKET_DATA_SIZE : rem;
-            if (!s_send_data(fd, target_addr, data.data() + i, send_len, request_id, packets_count, seq)) {
-                return false;
+        datagrams->push_back(std::move(datagram));
+        return true;
+    });
+}
+
+/**
+ * @brief 单次sendmmsg调用的最大数据报数量.
+ */
+static const size_t SEND_BATCH_SIZE = 64;
+
+/**
+ * @brief 将同一组数据报批量发送给多个目标.
+ * 
+ * @details 使用sendmmsg，一次系统调用发送多个数据报(可以是不同的目标)，所有目标共用同一份数据报.
+ * @details 非阻塞(MSG_DONTWAIT)：目标的接收缓冲区已满时返回EAGAIN，不等待.
+ *          某个目标的一个数据报发送失败后，跳过该目标剩余的数据报.
+ */
+void send_datagrams(int fd, const std::vector<std::string>& datagrams, const std::vector<sockaddr_un>& targets, std::vector<int>* errors) {
+    errors->assign(targets.size(), 0);
+    size_t per_target = datagrams.size();
+    if (per_target == 0 || targets.empty()) {
+        return;
+    }
+
+    struct iovec iovs[SEND_BATCH_SIZE];
+    struct mmsghdr msgs[SEND_BATCH_SIZE];
+    size_t owners[SEND_BATCH_SIZE];   /* 每个数据报所属的目标 */
+
+    size_t target = 0, seq = 0;
+    while (target < targets.size()) {
+        /* 按目标依次填充一批数据报 */
+        size_t count = 0;
+        while (count < SEND_BATCH_SIZE && target < targets.size()) {
+            if ((*errors)[target] != 0) {
+                ++target;
+                seq = 0;
+                continue;
+            }
+            const std::string& datagram = datagrams[seq];
+            iovs[count].iov_base = const_cast<char*>(datagram.data());
+            iovs[count].iov_len = datagram.length();
+            memset(&msgs[count], 0, sizeof(mmsghdr));
+            msgs[count].msg_hdr.msg_name = const_cast<sockaddr_un*>(&targets[target]);
+            msgs[count].msg_hdr.msg_namelen = sizeof(sockaddr_un);
+            msgs[count].msg_hdr.msg_iov = &iovs[count];
+            msgs[count].msg_hdr.msg_iovlen = 1;
+            owners[count] = target;
+            ++count;
+            if (++seq == per_target) {
+                ++target;
+                seq = 0;
+            }
+        }
+
+        /* 发送，出错的数据报之后的数据报重新发送(跳过出错目标的数据报) */
+        size_t sent = 0;
+        while (sent < count) {
+            if ((*errors)[owners[sent]] != 0) {
+                ++sent;
+                continue;
+            }
+            /* 连续的、目标未出错的一段 */
+            size_t end = sent + 1;
+            while (end < count && (*errors)[owners[end]] == 0) {
+                ++end;
+            }
+            int n = ::sendmmsg(fd, msgs + sent, static_cast<unsigned int>(end - sent), MSG_DONTWAIT);
+            if (n > 0) {
+                sent += static_cast<size_t>(n);
+            }
+            else {
+                int err = errno;
+                if (err == EINTR) {
+                    continue;
+                }
+                (*errors)[owners[sent]] = (err != 0) ? err : EIO;
+                ++sent;
             }
         }
     }
-    return true;
 }
 
 /**
@@ -125,10 +475,8 @@ static ssize_t s_recv_data(
 /**
  * @brief 接收数据.
  * 
- * @details 格式： 8字节(id) + 4字节(packets_total) + 4字节(packet_seq) + body
+ * @details 格式见 s_make_header，以v2魔数开头、版本和头部长度合法的是v2数据包，否则按v1解析.
  * @details id: 请求ID，由客户端保证唯一，如果分包，则用于组包。响应数据中需要带有该ID.
- * @details packets_total: 分包数量.
- * @details packet_seq: 当前分包序列号.
  */
 bool recv_data(int fd, fd_set* read_fds, Packet* packet, sockaddr_un* from_addr, socklen_t* from_addr_len) {
     thread_local char recv_buffer[MAX_RECV_BUFFER_SIZE + 1];
@@ -136,19 +484,94 @@ bool recv_data(int fd, fd_set* read_fds, Packet* packet, sockaddr_un* from_addr,
     if (n < 0) {
         return false;
     }
-    else if (n < 16) {
-        recv_buffer[n] = '\0';
-        fprintf(stderr, "Invalid data. len=%d<16", static_cast<int>(n));
-        return false;
+
+    size_t len = static_cast<size_t>(n);
+    PacketMeta& meta = packet->meta;
+    size_t header_len = PACKET_V1_HEADER_SIZE;
+    /* v1数据包的前4字节是请求ID的低32位，可能恰好等于魔数，版本和头部长度也合法时才按v2解析 */
+    bool is_v2 = false;
+    if (len >= PACKET_V2_HEADER_SIZE && load<uint32_t>(recv_buffer) == PACKET_V2_MAGIC
+        && load<uint8_t>(recv_buffer + 4) == PACKET_VERSION_2)
+    {
+        size_t v2_header_len = load<uint8_t>(recv_buffer + 5);
+        is_v2 = (v2_header_len >= PACKET_V2_HEADER_SIZE && v2_header_len <= len);
+    }
+    if (is_v2) {
+        meta.version = PACKET_VERSION_2;
+        header_len = load<uint8_t>(recv_buffer + 5);
+        meta.flags = load<uint16_t>(recv_buffer + 6);
+        packet->id = load<int64_t>(recv_buffer + 8);
+        packet->total = load<uint32_t>(recv_buffer + 16);
+        packet->seq = load<uint32_t>(recv_buffer + 20);
+        meta.type = static_cast<PacketType>(load<uint8_t>(recv_buffer + 24));
+        meta.priority = (meta.flags & PacketFlags::Priority) ? load<uint8_t>(recv_buffer + 25) : 1;
+        meta.deadline = (meta.flags & PacketFlags::Deadline) ? load<int64_t>(recv_buffer + 32) : 0;
+        meta.extensions.assign(recv_buffer + PACKET_V2_HEADER_SIZE, header_len - PACKET_V2_HEADER_SIZE);
+        if (meta.flags & PacketFlags::Checksum) {
+            /* 复制内容的同时计算校验值 */
+            static const char zeros[4] = { 0 };
+            uint32_t header_crc = crc32c(0, recv_buffer, PACKET_V2_CRC_OFFSET);
+            header_crc = crc32c(header_crc, zeros, 4);
+            header_crc = crc32c(header_crc, recv_buffer + PACKET_V2_CRC_OFFSET + 4, header_len - PACKET_V2_CRC_OFFSET - 4);
+            size_t data_len = len - header_len;
+            packet->data.resize(data_len);
+            packet->data_crc = crc32c_copy(0, &packet->data[0], recv_buffer + header_len, data_len);
+            uint32_t crc = crc32c_combine(header_crc, packet->data_crc, data_len);
+            packet->corrupted = (crc != load<uint32_t>(recv_buffer + PACKET_V2_CRC_OFFSET));
+            packet->message_crc = 0;
+            std::string_view message_crc;
+            if (find_extension(meta.extensions, PacketExtension::MessageCrc32c, &message_crc) && message_crc.length() == 4) {
+                packet->message_crc = load<uint32_t>(message_crc.data());
+            }
+            packet->arrive_time = std::chrono::steady_clock::now();
+            return true;
+        }
+    }
+    else if (len >= PACKET_V1_HEADER_SIZE) {
+        packet->id = load<int64_t>(recv_buffer);
+        packet->total = load<uint32_t>(recv_buffer + 8);
+        packet->seq = load<uint32_t>(recv_buffer + 12);
+        meta = PacketMeta();
+        meta.version = PACKET_VERSION_1;
     }
     else {
-        packet->arrive_time = std::chrono::steady_clock::now();
-        packet->id = *((int64_t*)recv_buffer);
-        packet->total = *((uint32_t*)(recv_buffer + 8));
-        packet->seq = *((uint32_t*)(recv_buffer + 12));
-        packet->data.assign(recv_buffer + 16, n - 16);
-        return true;
+        fprintf(stderr, "Invalid data. len=%d<%d", static_cast<int>(len), static_cast<int>(PACKET_V1_HEADER_SIZE));
+        return false;
     }
+
+    packet->corrupted = false;
+    packet->arrive_time = std::chrono::steady_clock::now();
+    packet->data.assign(recv_buffer + header_len, len - header_len);
+    return true;
+}
+
+/**
+ * @brief 查找TLV扩展字段.
+ */
+bool find_extension(const std::string& extensions, PacketExtension type, std::string_view* value) {
+    size_t pos = 0, len = extensions.length();
+    while (pos + 2 <= len) {
+        uint8_t ext_type = static_cast<uint8_t>(extensions[pos]);
+        size_t ext_len = static_cast<uint8_t>(extensions[pos + 1]);
+        if (pos + 2 + ext_len > len) {
+            return false;
+        }
+        if (ext_type == static_cast<uint8_t>(type)) {
+            *value = std::string_view(extensions.data() + pos + 2, ext_len);
+            return true;
+        }
+        pos += 2 + ext_len;
+    }
+    return false;
+}
+
+/**
+ * @brief 追加TLV扩展字段.
+ */
+void append_extension(std::string* extensions, PacketExtension type, const void* value, uint8_t len) {
+    extensions->push_back(static_cast<char>(type));
+    extensions->push_back(static_cast<char>(len));
+    extensions->append(static_cast<const char*>(value), len);
 }
 
 } // namespace util
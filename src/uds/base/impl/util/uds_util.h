@@ -10,6 +10,8 @@
 #ifndef IC_UDS_BASE_IMPL_UTIL_H_
 #define IC_UDS_BASE_IMPL_UTIL_H_
 #include <string>
+#include <string_view>
+#include <vector>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include "../uds_packet.h"
@@ -20,14 +22,73 @@ namespace util {
 
 /**
  * @brief 发送数据.
+ *
+ * @param meta 头部附加字段，如优先级(服务端据此调度请求)
  */
-bool send_data(int fd, const sockaddr_un& target_addr, int64_t request_id, const std::string& data);
+bool send_data(int fd, const sockaddr_un& target_addr, int64_t request_id, const std::string& data, const PacketMeta& meta = PacketMeta());
+
+/**
+ * @brief 发送多个不连续的片段(按顺序组成一个消息)，不合并.
+ *
+ * @details 分包时每个数据报引用各个片段(sendmsg)，用户空间不复制数据.
+ */
+bool send_data(int fd, const sockaddr_un& target_addr, int64_t request_id,
+    const std::string_view* buffers, size_t buffers_count, const PacketMeta& meta);
+
+/**
+ * @brief 合并多个片段.
+ */
+std::string join_buffers(const std::string_view* buffers, size_t buffers_count);
+
+/**
+ * @brief 单个数据报可以携带的最大数据长度.
+ */
+size_t max_packet_data_size(const PacketMeta& meta);
+
+/**
+ * @brief 发送单个数据报(不分包)，由调用方指定分包数量和序列号，用于数据流.
+ *
+ * @note len不能超过 max_packet_data_size(meta)
+ */
+bool send_packet(int fd, const sockaddr_un& target_addr, int64_t request_id, uint32_t packets_total, uint32_t packet_seq,
+    const char* data, size_t len, const PacketMeta& meta);
+
+/**
+ * @brief 生成数据的所有数据报(分包)，不发送，用于同一消息发送给多个目标.
+ */
+bool make_datagrams(int64_t request_id, const std::string& data, const PacketMeta& meta, std::vector<std::string>* datagrams);
+
+/**
+ * @brief 将同一组数据报批量、非阻塞地发送给多个目标.
+ *
+ * @param errors [out] 每个目标的错误码(errno)，0表示所有数据报发送成功
+ */
+void send_datagrams(int fd, const std::vector<std::string>& datagrams, const std::vector<sockaddr_un>& targets, std::vector<int>* errors);
 
 /**
  * @brief 接收数据.
  */
 bool recv_data(int fd, fd_set* read_fds, Packet* packet, sockaddr_un* from_addr, socklen_t* from_addr_len);
 
+/**
+ * @brief 查找TLV扩展字段.
+ *
+ * @param value 指向extensions内部
+ */
+bool find_extension(const std::string& extensions, PacketExtension type, std::string_view* value);
+
+/**
+ * @brief 追加TLV扩展字段.
+ */
+void append_extension(std::string* extensions, PacketExtension type, const void* value, uint8_t len);
+
+/**
+ * @brief 路由扩展字段(PacketExtension::RouteHint)的最大长度，更长的路由不携带.
+ * 
+ * @details 头部的扩展字段最多215字节，需要为完整消息的校验值留出空间.
+ */
+static constexpr size_t MAX_ROUTE_HINT_SIZE = 128;
+
 } // namespace util
 } // namespace uds
 } // namespace ic
@@ -0,0 +1,38 @@
+/**
+ * @file priority.h
+ * @brief 请求优先级.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-08
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_BASE_PRIORITY_H_
+#define IC_UDS_BASE_PRIORITY_H_
+#include <cstddef>
+#include <cstdint>
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief 请求优先级.
+ *
+ * @details 服务端线程池按优先级调度：总是优先处理高优先级的请求，
+ *          低优先级的请求等待时间过长时会逐级提升(防止饿死).
+ */
+enum class Priority : uint8_t {
+    Low = 0,     /* 批量、大数据量请求 */
+    Normal = 1,  /* 默认 */
+    High = 2,    /* 健康检查、控制类请求 */
+}; // enum class Priority
+
+/**
+ * @brief 优先级的数量.
+ */
+constexpr size_t kPriorityCount = 3;
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_BASE_PRIORITY_H_
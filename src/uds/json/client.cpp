@@ -1,4 +1,5 @@
 #include "client.h"
+#include <stdlib.h>
 #include "../base/error_code.h"
 
 namespace ic {
@@ -7,12 +8,41 @@ namespace uds {
 Response Client::SendRequest(Request& req, unsigned int timeout_ms/* = 10000*/) {
     std::error_code ec;
     std::string response_data;
-    int64_t id = BaseClient::SendRequest(req.Serialize(true), &response_data, timeout_ms, ec);
+    int64_t id = (req.id() >= 0) ? req.id() : NewRequestId();
+    if (binary_envelope_) {
+        req.set_binary(true);
+    }
+
+    /* 命中缓存时不发送请求 */
+    ResponseCache* cache = (response_cache_enabled_ && req.bodies().empty()) ? response_cache_.get() : nullptr;
+    std::string key;
+    uint64_t invalidations = 0;
+    if (cache) {
+        key = ResponseCache::MakeKey(req);
+        auto cached = cache->Get(key);
+        if (cached) {
+            Response res(id);
+            res.Deserialize(std::move(cached));
+            return res;
+        }
+        invalidations = invalidations_.load();
+    }
+
+    /* 数据体不复制，发送时直接引用 */
+    std::string head;
+    std::vector<std::string_view> buffers;
+    req.Serialize(&head, &buffers);
+    /* 请求被压缩时，服务端按头部携带的路径分类 */
+    BaseClient::SendRequest(id, buffers, req.path(), &response_data, timeout_ms, req.priority(), ec);
     Response res(id);
     if (!ec) {
-        if (!res.Deserialize(response_data)) {
+        auto data = std::make_shared<const std::string>(std::move(response_data));
+        if (!res.Deserialize(data)) {
             res.set_status(Response::Status::BadResponse);
         }
+        else if (cache && res.success() && res.max_age_ms() > 0 && invalidations_.load() == invalidations) {
+            cache->Put(key, std::move(data), std::chrono::milliseconds(res.max_age_ms()));
+        }
     }
     else if (ec == BaseErrc::SendFailed) {
         res.set_status(Response::Status::SendFailed);
@@ -26,6 +56,16 @@ Response Client::SendRequest(Request& req, unsigned int timeout_ms/* = 10000*/)
     else if (ec == BaseErrc::NotInitialized) {
         res.set_status(Response::Status::NotInitialized);
     }
+    else if (ec == BaseErrc::Overloaded) {
+        res.set_status(Response::Status::Overloaded);
+        res.retry_after_ms_ = static_cast<uint32_t>(strtoul(response_data.c_str(), nullptr, 10));
+    }
+    else if (ec == BaseErrc::Cancelled) {
+        res.set_status(Response::Status::Cancelled);
+    }
+    else if (ec == BaseErrc::ChecksumMismatch) {
+        res.set_status(Response::Status::ChecksumMismatch);
+    }
     else {
         // wont' get here
         res.set_status(Response::Status::UnknownError);
@@ -33,5 +73,68 @@ Response Client::SendRequest(Request& req, unsigned int timeout_ms/* = 10000*/)
     return res;
 }
 
+/**
+ * @brief 启用响应缓存.
+ * 
+ * @details 缓存在订阅之前创建，之后不再替换，接收线程可以直接访问.
+ */
+void Client::EnableResponseCache(size_t max_entries, uint32_t timeout_ms, std::error_code& ec) {
+    if (!response_cache_) {
+        /* 有效期由每个响应指定 */
+        response_cache_ = std::make_shared<ResponseCache>(0, max_entries);
+    }
+    InstallCallbacks();
+    Subscribe({ ResponseCache::kInvalidationTopic }, timeout_ms, ec);
+    response_cache_enabled_ = !ec;
+}
+
+void Client::ClearResponseCache() {
+    invalidations_++;
+    if (response_cache_) {
+        response_cache_->Clear();
+    }
+}
+
+void Client::set_publish_callback(PublishCallback callback) {
+    publish_callback_ = callback;
+    InstallCallbacks();
+}
+
+void Client::set_evicted_callback(EvictedCallback callback) {
+    evicted_callback_ = callback;
+    InstallCallbacks();
+}
+
+/**
+ * @brief 接收线程先处理缓存失效通知，其他消息交给用户的回调函数.
+ */
+void Client::InstallCallbacks() {
+    BaseClient::set_publish_callback([this](const std::string& topic, const std::string& data){
+        OnPublish(topic, data);
+    });
+    BaseClient::set_evicted_callback([this]{
+        OnEvicted();
+    });
+}
+
+void Client::OnPublish(const std::string& topic, const std::string& data) {
+    if (topic == ResponseCache::kInvalidationTopic) {
+        invalidations_++;
+        if (response_cache_) {
+            response_cache_->RemovePrefix(data);
+        }
+    }
+    else if (publish_callback_) {
+        publish_callback_(topic, data);
+    }
+}
+
+void Client::OnEvicted() {
+    ClearResponseCache();
+    if (evicted_callback_) {
+        evicted_callback_();
+    }
+}
+
 } // namespace uds
 } // namespace ic
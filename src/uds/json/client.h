@@ -1,7 +1,10 @@
 #ifndef IC_UDS_JSON_CLIENT_H_
 #define IC_UDS_JSON_CLIENT_H_
+#include <atomic>
+#include <memory>
 #include "request.h"
 #include "response.h"
+#include "response_cache.h"
 #include "../base/base_client.h"
 
 namespace ic {
@@ -9,7 +12,75 @@ namespace uds {
 
 class Client : public BaseClient {
 public:
+    /**
+     * @brief 发送请求，等待服务器返回响应.
+     * 
+     * @details 如需在其他线程取消请求，先通过 req.set_id(NewRequestId()) 指定请求ID，再调用 Cancel(req.id(), ec).
+     */
     Response SendRequest(Request& req, unsigned int timeout_ms = 10000);
+
+    /**
+     * @brief 请求的JSON部分使用二进制编码(MessagePack)，默认关闭.
+     * 
+     * @details 服务端按请求的编码返回响应，处理函数看到的 param() 不变.
+     * @details 旧版本的服务端不能识别，会返回 BadRequest.
+     */
+    void set_binary_envelope(bool enable) { binary_envelope_ = enable; }
+    bool binary_envelope() const { return binary_envelope_; }
+
+    /**
+     * @brief 启用响应缓存，在发送请求之前调用.
+     * 
+     * @details 服务端通过 res.set_max_age_ms() 标记可缓存的响应，有效期内相同的请求(路径、参数相同)
+     *          直接返回缓存的响应，不发送请求. 携带数据体的请求不使用缓存.
+     * @details 同时订阅服务端的缓存失效通知(Server::InvalidateCache)，收到后移除相应路径的响应；
+     *          被服务端移除订阅时(可能丢失了通知)清空缓存.
+     * 
+     * @param  max_entries 最大条目数
+     * @param  timeout_ms 等待服务端确认订阅的超时时间，单位：毫秒
+     * @param  ec 错误代码，订阅失败时不启用缓存
+     */
+    void EnableResponseCache(size_t max_entries, uint32_t timeout_ms, std::error_code& ec);
+
+    /**
+     * @brief 清空缓存的响应.
+     */
+    void ClearResponseCache();
+
+    /**
+     * @brief 命中、未命中响应缓存的次数.
+     */
+    uint64_t cache_hits_count() const { return response_cache_ ? response_cache_->hits() : 0; }
+    uint64_t cache_misses_count() const { return response_cache_ ? response_cache_->misses() : 0; }
+
+    /**
+     * @brief 收到服务端发布的消息后的回调函数，不包括缓存失效通知.
+     */
+    void set_publish_callback(PublishCallback callback);
+
+    /**
+     * @brief 被服务端移除全部订阅后的回调函数.
+     */
+    void set_evicted_callback(EvictedCallback callback);
+
+private:
+    void InstallCallbacks();
+    void OnPublish(const std::string& topic, const std::string& data);
+    void OnEvicted();
+
+private:
+    bool binary_envelope_{false};
+
+    std::shared_ptr<ResponseCache> response_cache_;
+    std::atomic_bool response_cache_enabled_{false};
+
+    /**
+     * @brief 收到失效通知的次数，请求期间收到通知时不缓存其响应.
+     */
+    std::atomic<uint64_t> invalidations_{0};
+
+    PublishCallback publish_callback_;
+    EvictedCallback evicted_callback_;
 };
 
 } // namespace uds
@@ -0,0 +1,193 @@
+#include "deferred_response.h"
+#include <vector>
+#include "request.h"
+#include "response_cache.h"
+#include "router.h"
+#include "server.h"
+#include "single_flight.h"
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief 在本文件中实现，只使用客户端的程序不链接服务端.
+ */
+std::shared_ptr<DeferredResponse> Request::Defer(uint32_t timeout_ms/* = 0*/) {
+    if (!deferred_) {
+        if (!svr_ || !client_addr_ || (route_ && route_->typed_handler)) {
+            return nullptr;
+        }
+        deferred_ = svr_->Defer(*this, timeout_ms);
+    }
+    return deferred_;
+}
+
+/**
+ * @brief 未完成就被释放时返回UnknownError.
+ */
+DeferredResponse::~DeferredResponse() {
+    if (!completed_.load()) {
+        Finish(Response::Status::UnknownError, false);
+    }
+}
+
+bool DeferredResponse::Complete() {
+    return Finish(Response::Status::Success, true);
+}
+
+bool DeferredResponse::Complete(Response::Status status) {
+    return Finish(status, false);
+}
+
+/**
+ * @brief 完成延迟响应(只有第一次有效).
+ * 
+ * @details 序列化一次，发送给客户端和合并到本请求的其他请求；成功的响应按路由的设置加入缓存.
+ */
+bool DeferredResponse::Finish(Response::Status status, bool with_content) {
+    if (completed_.exchange(true)) {
+        return false;
+    }
+    timer_->Remove(this);
+
+    Response status_only;
+    Response& res = with_content ? res_ : status_only;
+    res.set_status(status);
+    res.set_binary(res_.binary());
+    auto serialized = std::make_shared<const std::string>(res.Serialize());
+
+    /* 先加入缓存再结束进行中的请求，与 Router::HandleRequest() 一致 */
+    if (cache_ && status == Response::Status::Success && res.cacheable() && res.bodies().empty()) {
+        cache_->Put(key_, serialized);
+    }
+    if (single_flight_) {
+        for (auto& waiter : single_flight_->Leave(key_, serialized)) {
+            timer_->Send(waiter.client_addr, waiter.request_id, *serialized);
+        }
+    }
+    timer_->Send(client_addr_, request_id_, *serialized);
+    return true;
+}
+
+DeferredResponseTimer::~DeferredResponseTimer() {
+    Shutdown();
+}
+
+/**
+ * @brief 添加延迟响应，第一次添加时启动线程.
+ */
+void DeferredResponseTimer::Add(const std::shared_ptr<DeferredResponse>& deferred) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    if (stop_) {
+        return;
+    }
+    auto iter = timers_.emplace(deferred->deadline(), Entry{ deferred.get(), deferred, nullptr });
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&DeferredResponseTimer::Run, this);
+    }
+    else if (iter == timers_.begin()) {
+        cv_.notify_one();
+    }
+}
+
+/**
+ * @brief 添加定时任务，第一次添加时启动线程.
+ */
+bool DeferredResponseTimer::Schedule(clock::time_point when, std::function<void()> task) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    if (stop_) {
+        return false;
+    }
+    auto iter = timers_.emplace(when, Entry{ nullptr, std::weak_ptr<DeferredResponse>(), std::move(task) });
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&DeferredResponseTimer::Run, this);
+    }
+    else if (iter == timers_.begin()) {
+        cv_.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief 移除已完成的延迟响应.
+ */
+void DeferredResponseTimer::Remove(DeferredResponse* deferred) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    auto range = timers_.equal_range(deferred->deadline());
+    for (auto iter = range.first; iter != range.second; ++iter) {
+        if (iter->second.ptr == deferred) {
+            timers_.erase(iter);
+            return;
+        }
+    }
+}
+
+bool DeferredResponseTimer::Send(const sockaddr_un& client_addr, int64_t request_id, const std::string& data) {
+    std::shared_lock<std::shared_mutex> lck(server_mutex_);
+    if (!server_) {
+        return false;
+    }
+    return server_->SendResponse(client_addr, request_id, data);
+}
+
+void DeferredResponseTimer::Shutdown() {
+    {
+        std::unique_lock<std::shared_mutex> lck(server_mutex_);
+        server_ = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/**
+ * @brief 等待最早的截止时间，超时的延迟响应返回Timeout，到期的定时任务被调用.
+ * 
+ * @details 在锁外完成(发送)，并且在锁外释放引用：最后一个引用释放时析构函数会调用 Remove().
+ * @details 定时任务同样在锁外调用.
+ */
+void DeferredResponseTimer::Run() {
+    std::vector<std::shared_ptr<DeferredResponse>> expired;
+    std::vector<std::function<void()>> tasks;
+    std::unique_lock<std::mutex> lck(mutex_);
+    while (!stop_) {
+        if (timers_.empty()) {
+            cv_.wait(lck);
+            continue;
+        }
+        auto now = clock::now();
+        auto first = timers_.begin()->first;
+        if (first > now) {
+            cv_.wait_until(lck, first);
+            continue;
+        }
+        while (!timers_.empty() && timers_.begin()->first <= now) {
+            Entry& entry = timers_.begin()->second;
+            if (entry.task) {
+                tasks.push_back(std::move(entry.task));
+            }
+            else if (auto deferred = entry.ref.lock()) {
+                expired.push_back(std::move(deferred));
+            }
+            timers_.erase(timers_.begin());
+        }
+        lck.unlock();
+        for (auto& deferred : expired) {
+            deferred->Finish(Response::Status::Timeout, false);
+        }
+        expired.clear();
+        for (auto& task : tasks) {
+            task();
+        }
+        tasks.clear();
+        lck.lock();
+    }
+}
+
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,160 @@
+/**
+ * @file deferred_response.h
+ * @brief 延迟响应.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-29
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_JSON_DEFERRED_RESPONSE_H_
+#define IC_UDS_JSON_DEFERRED_RESPONSE_H_
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <sys/un.h>
+#include "response.h"
+
+namespace ic {
+namespace uds {
+
+class Server;
+class RequestBatcher;
+class ResponseCache;
+class SingleFlight;
+class DeferredResponseTimer;
+
+/**
+ * @brief 延迟响应，由处理函数通过 Request::Defer() 取得.
+ *
+ * @details 处理函数返回后不发送响应，工作线程立即处理其他请求；之后可以在任意线程填写 response() 并调用 Complete().
+ * @details 超过截止时间仍未完成时，服务器返回Timeout；未完成就被释放(最后一个引用被释放)时返回UnknownError.
+ * @details 只有第一次完成有效(包括超时)，之后的 Complete() 返回false.
+ */
+class DeferredResponse {
+public:
+    using clock = std::chrono::steady_clock;
+
+    ~DeferredResponse();
+
+    /**
+     * @brief 要返回的响应，调用 Complete() 之前填写.
+     *
+     * @details 不要在多个线程中同时修改.
+     */
+    Response& response() { return res_; }
+
+    /**
+     * @brief 发送 response().
+     *
+     * @retval false 已经完成(或者已超时)，本次没有发送
+     */
+    bool Complete();
+
+    /**
+     * @brief 发送只有状态码的响应(忽略 response() 的内容)，如BadRequest.
+     */
+    bool Complete(Response::Status status);
+
+    bool completed() const { return completed_.load(); }
+
+    /**
+     * @brief 截止时间，超过后返回Timeout.
+     */
+    const clock::time_point& deadline() const { return deadline_; }
+
+private:
+    friend class Server;
+    friend class DeferredResponseTimer;
+    friend class RequestBatcher;
+
+    DeferredResponse() = default;
+    bool Finish(Response::Status status, bool with_content);
+
+private:
+    std::shared_ptr<DeferredResponseTimer> timer_;
+    sockaddr_un client_addr_;
+    int64_t request_id_{-1};
+    clock::time_point deadline_;
+    Response res_;
+    std::atomic_bool completed_{false};
+
+    /**
+     * @brief 路由启用了响应缓存或者合并请求时，完成后加入缓存、发送给合并到本请求的其他请求.
+     */
+    std::shared_ptr<ResponseCache> cache_;
+    std::shared_ptr<SingleFlight> single_flight_;
+    std::string key_;
+};
+
+/**
+ * @brief 延迟响应的计时器，超过截止时间的延迟响应返回Timeout.
+ *
+ * @details 也可以添加定时任务(如批处理路由提交等待超时的批次)，在计时器线程上调用.
+ * @details 由Server持有，第一次添加时才启动线程. 服务器释放后延迟响应仍可能持有它，此时不再发送.
+ */
+class DeferredResponseTimer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit DeferredResponseTimer(Server* server) : server_(server) {}
+    ~DeferredResponseTimer();
+
+    void Add(const std::shared_ptr<DeferredResponse>& deferred);
+    void Remove(DeferredResponse* deferred);
+
+    /**
+     * @brief 在指定时间调用task(在计时器线程上，task应尽快返回).
+     *
+     * @retval false 已经停止，task不会被调用
+     */
+    bool Schedule(clock::time_point when, std::function<void()> task);
+
+    /**
+     * @brief 发送响应，服务器已释放时返回false.
+     */
+    bool Send(const sockaddr_un& client_addr, int64_t request_id, const std::string& data);
+
+    /**
+     * @brief 服务器释放之前调用：停止线程，之后不再发送.
+     */
+    void Shutdown();
+
+private:
+    void Run();
+
+private:
+    std::shared_mutex server_mutex_;
+    Server* server_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    /**
+     * @brief 按截止时间排序的延迟响应和定时任务.
+     * 
+     * @details 同时记录指针，延迟响应释放时(弱引用已失效)仍可以按指针移除.
+     * @details 定时任务的ptr为空.
+     */
+    struct Entry {
+        DeferredResponse* ptr;
+        std::weak_ptr<DeferredResponse> ref;
+        std::function<void()> task;
+    };
+    std::multimap<clock::time_point, Entry> timers_;
+    std::thread thread_;
+    bool stop_{false};
+};
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_JSON_DEFERRED_RESPONSE_H_
@@ -0,0 +1,752 @@
+#include "json_codec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <jsoncpp/json/writer.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ic {
+namespace uds {
+namespace json {
+
+/**
+ * @brief 与Json::Reader一致的最大嵌套深度.
+ */
+static const int MAX_DEPTH = 1000;
+
+/**
+ * @brief 查找第一个可能需要特殊处理的字节.
+ *
+ * @details 解析时查找引号和反斜杠；序列化时还需要查找控制字符(<=0x0D的字节为候选，由调用方再精确判断).
+ *          每次比较16字节，剩余不足16字节时逐字节比较.
+ */
+template <bool kWithControl>
+static inline const char* s_find_special(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x0D);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i mask = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        if (kWithControl) {
+            /* 无符号比较 chunk <= 0x0D */
+            mask = _mm_or_si128(mask, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+        }
+        int bits = _mm_movemask_epi8(mask);
+        if (bits != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(bits));
+        }
+        p += 16;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x0D);
+    while (end - p >= 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t mask = vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash));
+        if (kWithControl) {
+            mask = vorrq_u8(mask, vcleq_u8(chunk, control));
+        }
+        if (vmaxvq_u8(mask) != 0) {
+            break;  /* 在这16字节中逐字节查找 */
+        }
+        p += 16;
+    }
+#endif
+    while (p < end) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\' || (kWithControl && c <= 0x0D)) {
+            return p;
+        }
+        ++p;
+    }
+    return end;
+}
+
+/**
+ * @brief 解析字符串.
+ *
+ * @details 没有转义字符时，返回的区间直接指向输入；否则解码到unescaped_中.
+ */
+bool Reader::ParseString(const char** begin, const char** end) {
+    ++p_;  /* '"' */
+    const char* start = p_;
+    const char* special = s_find_special<false>(p_, end_);
+    if (special >= end_) {
+        return false;
+    }
+    if (*special == '"') {
+        *begin = start;
+        *end = special;
+        p_ = special + 1;
+        return true;
+    }
+
+    /* 含有转义字符 */
+    unescaped_.assign(start, special);
+    p_ = special;
+    while (true) {
+        if (p_ >= end_) {
+            return false;
+        }
+        char c = *p_;
+        if (c == '"') {
+            ++p_;
+            break;
+        }
+        if (c != '\\') {
+            const char* next = s_find_special<false>(p_, end_);
+            unescaped_.append(p_, next);
+            p_ = next;
+            continue;
+        }
+        if (++p_ >= end_) {
+            return false;
+        }
+        switch (*p_++) {
+        case '"':  unescaped_.push_back('"');  break;
+        case '\\': unescaped_.push_back('\\'); break;
+        case '/':  unescaped_.push_back('/');  break;
+        case 'b':  unescaped_.push_back('\b'); break;
+        case 'f':  unescaped_.push_back('\f'); break;
+        case 'n':  unescaped_.push_back('\n'); break;
+        case 'r':  unescaped_.push_back('\r'); break;
+        case 't':  unescaped_.push_back('\t'); break;
+        case 'u':
+            if (!ParseUnicodeEscape()) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+    *begin = unescaped_.data();
+    *end = unescaped_.data() + unescaped_.length();
+    return true;
+}
+
+bool Reader::ParseHex4(unsigned int* code) {
+    if (end_ - p_ < 4) {
+        return false;
+    }
+    unsigned int value = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = *p_++;
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value += c - '0';
+        }
+        else if (c >= 'a' && c <= 'f') {
+            value += c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F') {
+            value += c - 'A' + 10;
+        }
+        else {
+            return false;
+        }
+    }
+    *code = value;
+    return true;
+}
+
+/**
+ * @brief 解析\uXXXX(包括代理对)，以UTF-8写入unescaped_.
+ */
+bool Reader::ParseUnicodeEscape() {
+    unsigned int code = 0;
+    if (!ParseHex4(&code)) {
+        return false;
+    }
+    if (code >= 0xD800 && code <= 0xDBFF) {
+        unsigned int low = 0;
+        if (end_ - p_ < 6 || p_[0] != '\\' || p_[1] != 'u') {
+            return false;
+        }
+        p_ += 2;
+        if (!ParseHex4(&low) || low < 0xDC00 || low > 0xDFFF) {
+            return false;
+        }
+        code = 0x10000 + ((code & 0x3FF) << 10) + (low & 0x3FF);
+    }
+    if (code < 0x80) {
+        unescaped_.push_back(static_cast<char>(code));
+    }
+    else if (code < 0x800) {
+        unescaped_.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        unescaped_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+    else if (code < 0x10000) {
+        unescaped_.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        unescaped_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        unescaped_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+    else {
+        unescaped_.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        unescaped_.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        unescaped_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        unescaped_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+    return true;
+}
+
+bool Reader::ReadNull() {
+    SkipWhitespace();
+    if (end_ - p_ >= 4 && memcmp(p_, "null", 4) == 0) {
+        p_ += 4;
+        return true;
+    }
+    return false;
+}
+
+bool Reader::ReadBool(bool* value) {
+    SkipWhitespace();
+    if (end_ - p_ >= 4 && memcmp(p_, "true", 4) == 0) {
+        p_ += 4;
+        *value = true;
+        return true;
+    }
+    if (end_ - p_ >= 5 && memcmp(p_, "false", 5) == 0) {
+        p_ += 5;
+        *value = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 读取整数的符号和绝对值，溢出或者带小数点、指数时返回false.
+ */
+bool Reader::ParseInteger(bool* negative, uint64_t* integer) {
+    SkipWhitespace();
+    *negative = (p_ < end_ && *p_ == '-');
+    if (*negative) {
+        ++p_;
+    }
+    const char* digits = p_;
+    uint64_t value = 0;
+    while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+        uint64_t digit = static_cast<uint64_t>(*p_ - '0');
+        if (value > (UINT64_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+        ++p_;
+    }
+    if (p_ == digits || (p_ < end_ && (*p_ == '.' || *p_ == 'e' || *p_ == 'E'))) {
+        return false;
+    }
+    *integer = value;
+    return true;
+}
+
+bool Reader::ReadInt(int64_t* value) {
+    bool negative = false;
+    uint64_t integer = 0;
+    if (!ParseInteger(&negative, &integer)) {
+        return false;
+    }
+    if (negative) {
+        if (integer > static_cast<uint64_t>(INT64_MAX) + 1) {
+            return false;
+        }
+        *value = static_cast<int64_t>(static_cast<uint64_t>(0) - integer);
+    }
+    else {
+        if (integer > static_cast<uint64_t>(INT64_MAX)) {
+            return false;
+        }
+        *value = static_cast<int64_t>(integer);
+    }
+    return true;
+}
+
+bool Reader::ReadUint(uint64_t* value) {
+    bool negative = false;
+    return ParseInteger(&negative, value) && (!negative || *value == 0);
+}
+
+/**
+ * @brief 读取数值，交给strtod.
+ */
+bool Reader::ReadDouble(double* value) {
+    SkipWhitespace();
+    const char* start = p_;
+    while (p_ < end_ && ((*p_ >= '0' && *p_ <= '9') || *p_ == '-' || *p_ == '+' || *p_ == '.' || *p_ == 'e' || *p_ == 'E')) {
+        ++p_;
+    }
+    size_t len = static_cast<size_t>(p_ - start);
+    char buffer[64];
+    if (len == 0 || len >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, start, len);
+    buffer[len] = '\0';
+    char* number_end = nullptr;
+    *value = strtod(buffer, &number_end);
+    return number_end == buffer + len;
+}
+
+bool Reader::ReadString(const char** begin, const char** end) {
+    SkipWhitespace();
+    if (p_ >= end_ || *p_ != '"') {
+        return false;
+    }
+    return ParseString(begin, end);
+}
+
+bool Reader::ReadString(std::string* value) {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    if (!ReadString(&begin, &end)) {
+        return false;
+    }
+    value->assign(begin, end);
+    return true;
+}
+
+bool Reader::Skip() {
+    return SkipValue(0);
+}
+
+bool Reader::SkipValue(int depth) {
+    SkipWhitespace();
+    if (p_ >= end_ || depth > MAX_DEPTH) {
+        return false;
+    }
+    switch (*p_) {
+    case '{':
+        return ReadObject([this, depth](const char*, size_t){ return SkipValue(depth + 1); });
+    case '[':
+        return ReadArray([this, depth]{ return SkipValue(depth + 1); });
+    case '"': {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        return ParseString(&begin, &end);
+    }
+    case 't':
+    case 'f': {
+        bool value = false;
+        return ReadBool(&value);
+    }
+    case 'n':
+        return ReadNull();
+    default: {
+        double value = 0;
+        return ReadDouble(&value);
+    }
+    }
+}
+
+/**
+ * @brief 消息格式中固定的键.
+ */
+static const struct {
+    const char* key;
+    size_t length;
+} kEnvelopeKeys[] = {
+    { ":body", 5 }, { ":length", 7 }, { ":max_age", 8 }, { ":name", 5 },
+    { ":offset", 7 }, { ":param", 6 }, { ":path", 5 }, { ":status", 7 }
+};
+
+Json::Value* DemandMember(Json::Value* object, const char* key_begin, const char* key_end) {
+    size_t len = static_cast<size_t>(key_end - key_begin);
+    if (len > 1 && *key_begin == ':') {
+        for (auto& item : kEnvelopeKeys) {
+            if (item.length == len && memcmp(item.key, key_begin, len) == 0) {
+                return &(*object)[Json::StaticString(item.key)];
+            }
+        }
+    }
+    return object->demand(key_begin, key_end);
+}
+
+/**
+ * @brief 解析器.
+ */
+class Parser : public Reader {
+public:
+    Parser(const char* begin, const char* end) : Reader(begin, end) {}
+
+    bool ParseRoot(Json::Value* root) {
+        SkipWhitespace();
+        if (!ParseValue(root, 0)) {
+            return false;
+        }
+        SkipWhitespace();
+        return p_ == end_;
+    }
+
+private:
+    bool ParseValue(Json::Value* value, int depth) {
+        if (p_ >= end_) {
+            return false;
+        }
+        switch (*p_) {
+        case '{':
+            return ParseObject(value, depth + 1);
+        case '[':
+            return ParseArray(value, depth + 1);
+        case '"': {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            if (!ParseString(&begin, &end)) {
+                return false;
+            }
+            *value = Json::Value(begin, end);
+            return true;
+        }
+        case 't':
+            return ParseLiteral("true", 4, Json::Value(true), value);
+        case 'f':
+            return ParseLiteral("false", 5, Json::Value(false), value);
+        case 'n':
+            return ParseLiteral("null", 4, Json::Value(), value);
+        default:
+            return ParseNumber(value);
+        }
+    }
+
+    bool ParseObject(Json::Value* value, int depth) {
+        if (depth > MAX_DEPTH) {
+            return false;
+        }
+        ++p_;  /* '{' */
+        *value = Json::Value(Json::objectValue);
+        SkipWhitespace();
+        if (p_ < end_ && *p_ == '}') {
+            ++p_;
+            return true;
+        }
+        while (true) {
+            if (p_ >= end_ || *p_ != '"') {
+                return false;
+            }
+            const char* key_begin = nullptr;
+            const char* key_end = nullptr;
+            if (!ParseString(&key_begin, &key_end)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (p_ >= end_ || *p_ != ':') {
+                return false;
+            }
+            ++p_;
+            SkipWhitespace();
+            /* 直接解析到对象的成员中，不复制 */
+            Json::Value* member = DemandMember(value, key_begin, key_end);
+            if (!ParseValue(member, depth)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (p_ >= end_) {
+                return false;
+            }
+            if (*p_ == ',') {
+                ++p_;
+                SkipWhitespace();
+                continue;
+            }
+            if (*p_ == '}') {
+                ++p_;
+                return true;
+            }
+            return false;
+        }
+    }
+
+    bool ParseArray(Json::Value* value, int depth) {
+        if (depth > MAX_DEPTH) {
+            return false;
+        }
+        ++p_;  /* '[' */
+        *value = Json::Value(Json::arrayValue);
+        SkipWhitespace();
+        if (p_ < end_ && *p_ == ']') {
+            ++p_;
+            return true;
+        }
+        while (true) {
+            Json::Value& element = value->append(Json::Value());
+            if (!ParseValue(&element, depth)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (p_ >= end_) {
+                return false;
+            }
+            if (*p_ == ',') {
+                ++p_;
+                SkipWhitespace();
+                continue;
+            }
+            if (*p_ == ']') {
+                ++p_;
+                return true;
+            }
+            return false;
+        }
+    }
+
+    bool ParseLiteral(const char* literal, size_t len, const Json::Value& literal_value, Json::Value* value) {
+        if (static_cast<size_t>(end_ - p_) < len || memcmp(p_, literal, len) != 0) {
+            return false;
+        }
+        p_ += len;
+        *value = literal_value;
+        return true;
+    }
+
+    /**
+     * @brief 解析数值，整数直接累加，其他交给strtod.
+     */
+    bool ParseNumber(Json::Value* value) {
+        const char* start = p_;
+        bool negative = false;
+        if (*p_ == '-') {
+            negative = true;
+            ++p_;
+        }
+        const char* digits = p_;
+        uint64_t integer = 0;
+        bool overflow = false;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            uint64_t digit = static_cast<uint64_t>(*p_ - '0');
+            if (integer > (UINT64_MAX - digit) / 10) {
+                overflow = true;
+            }
+            integer = integer * 10 + digit;
+            ++p_;
+        }
+        if (p_ == digits) {
+            return false;
+        }
+        bool is_real = overflow;
+        if (p_ < end_ && *p_ == '.') {
+            is_real = true;
+            ++p_;
+            while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                ++p_;
+            }
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            is_real = true;
+            ++p_;
+            if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+                ++p_;
+            }
+            while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                ++p_;
+            }
+        }
+
+        if (!is_real) {
+            /* 与Json::Reader::decodeNumber一致 */
+            const uint64_t max_int = static_cast<uint64_t>(Json::Value::maxLargestInt);
+            if (negative) {
+                if (integer > max_int + 1) {
+                    is_real = true;
+                }
+                else if (integer == max_int + 1) {
+                    *value = Json::Value(Json::Value::minLargestInt);
+                }
+                else {
+                    *value = Json::Value(-static_cast<Json::LargestInt>(integer));
+                }
+            }
+            else if (integer <= static_cast<uint64_t>(Json::Value::maxInt)) {
+                *value = Json::Value(static_cast<Json::LargestInt>(integer));
+            }
+            else {
+                *value = Json::Value(static_cast<Json::LargestUInt>(integer));
+            }
+            if (!is_real) {
+                return true;
+            }
+        }
+
+        /* strtod需要以'\0'结尾 */
+        char buffer[64];
+        size_t len = static_cast<size_t>(p_ - start);
+        std::string long_number;
+        const char* number = buffer;
+        if (len < sizeof(buffer)) {
+            memcpy(buffer, start, len);
+            buffer[len] = '\0';
+        }
+        else {
+            long_number.assign(start, len);
+            number = long_number.c_str();
+        }
+        char* number_end = nullptr;
+        double real = strtod(number, &number_end);
+        if (number_end != number + len) {
+            return false;
+        }
+        *value = Json::Value(real);
+        return true;
+    }
+
+};
+
+/**
+ * @brief 解析JSON，直接构造Json::Value.
+ */
+bool Parse(const char* begin, const char* end, Json::Value* root) {
+    Parser parser(begin, end);
+    return parser.ParseRoot(root);
+}
+
+/**
+ * @brief 写入带引号的字符串，仅转义 " \ \b \f \n \r \t (与FastWriter的emitUTF8模式一致).
+ */
+static void s_write_string(const char* p, const char* end, std::string* out) {
+    out->push_back('"');
+    while (p < end) {
+        const char* special = s_find_special<true>(p, end);
+        out->append(p, special);
+        if (special == end) {
+            break;
+        }
+        switch (*special) {
+        case '"':  out->append("\\\"", 2); break;
+        case '\\': out->append("\\\\", 2); break;
+        case '\b': out->append("\\b", 2);  break;
+        case '\f': out->append("\\f", 2);  break;
+        case '\n': out->append("\\n", 2);  break;
+        case '\r': out->append("\\r", 2);  break;
+        case '\t': out->append("\\t", 2);  break;
+        default:   out->push_back(*special); break;  /* 其他控制字符不转义 */
+        }
+        p = special + 1;
+    }
+    out->push_back('"');
+}
+
+/**
+ * @brief 写入整数.
+ */
+static void s_write_uint(uint64_t value, bool negative, std::string* out) {
+    char buffer[24];
+    char* p = buffer + sizeof(buffer);
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    if (negative) {
+        *--p = '-';
+    }
+    out->append(p, buffer + sizeof(buffer));
+}
+
+static void s_write_value(const Json::Value& value, std::string* out) {
+    switch (value.type()) {
+    case Json::nullValue:
+        out->append("null", 4);
+        break;
+    case Json::intValue: {
+        Json::LargestInt i = value.asLargestInt();
+        if (i < 0) {
+            s_write_uint(static_cast<uint64_t>(0) - static_cast<uint64_t>(i), true, out);
+        }
+        else {
+            s_write_uint(static_cast<uint64_t>(i), false, out);
+        }
+        break;
+    }
+    case Json::uintValue:
+        s_write_uint(value.asLargestUInt(), false, out);
+        break;
+    case Json::realValue:
+        out->append(Json::valueToString(value.asDouble()));
+        break;
+    case Json::stringValue: {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        if (value.getString(&begin, &end)) {
+            s_write_string(begin, end, out);
+        }
+        else {
+            out->append("\"\"", 2);
+        }
+        break;
+    }
+    case Json::booleanValue:
+        if (value.asBool()) {
+            out->append("true", 4);
+        }
+        else {
+            out->append("false", 5);
+        }
+        break;
+    case Json::arrayValue: {
+        out->push_back('[');
+        for (Json::ArrayIndex i = 0, size = value.size(); i < size; ++i) {
+            if (i > 0) {
+                out->push_back(',');
+            }
+            s_write_value(value[i], out);
+        }
+        out->push_back(']');
+        break;
+    }
+    case Json::objectValue: {
+        out->push_back('{');
+        bool first = true;
+        for (auto iter = value.begin(); iter != value.end(); ++iter) {
+            if (iter->isNull()) {
+                continue;  /* dropNullKeyValues */
+            }
+            if (!first) {
+                out->push_back(',');
+            }
+            first = false;
+            const char* name_end = nullptr;
+            const char* name = iter.memberName(&name_end);
+            s_write_string(name, name_end, out);
+            out->push_back(':');
+            s_write_value(*iter, out);
+        }
+        out->push_back('}');
+        break;
+    }
+    }
+}
+
+/**
+ * @brief 序列化为紧凑的JSON，追加到out末尾.
+ */
+void Write(const Json::Value& value, std::string* out) {
+    s_write_value(value, out);
+}
+
+void WriteString(const char* str, size_t len, std::string* out) {
+    s_write_string(str, str + len, out);
+}
+
+void WriteInt(int64_t value, std::string* out) {
+    if (value < 0) {
+        s_write_uint(static_cast<uint64_t>(0) - static_cast<uint64_t>(value), true, out);
+    }
+    else {
+        s_write_uint(static_cast<uint64_t>(value), false, out);
+    }
+}
+
+void WriteUint(uint64_t value, std::string* out) {
+    s_write_uint(value, false, out);
+}
+
+void WriteDouble(double value, std::string* out) {
+    out->append(Json::valueToString(value));
+}
+
+} // namespace json
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,200 @@
+/**
+ * @file json_codec.h
+ * @brief JSON编解码(请求、响应的JSON部分).
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-23
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_JSON_JSON_CODEC_H_
+#define IC_UDS_JSON_JSON_CODEC_H_
+#include <cstdint>
+#include <string>
+#include <jsoncpp/json/value.h>
+
+namespace ic {
+namespace uds {
+namespace json {
+
+/**
+ * @brief 解析JSON，直接构造Json::Value.
+ *
+ * @details 单遍递归下降解析，字符串内容使用SIMD(SSE2/NEON)按16字节扫描引号和转义字符，
+ *          没有转义字符的字符串和键直接从输入构造，不产生中间的std::string.
+ * @details 数值类型与Json::Reader一致：负整数和不超过Int32最大值的整数为intValue，其他整数为uintValue，
+ *          超出Int64/UInt64范围或者带小数点、指数时为realValue.
+ * @details 不支持注释等非标准语法，失败时调用方可以回退到Json::Reader.
+ *
+ * @param begin JSON串起始位置
+ * @param end JSON串结束位置
+ * @param root [out] 解析结果
+ * @return 是否解析成功(必须是完整的JSON值，末尾只能有空白)
+ */
+bool Parse(const char* begin, const char* end, Json::Value* root);
+
+/**
+ * @brief 取得对象的成员，不存在时添加(Parse、msgpack::Parse使用).
+ *
+ * @details 消息格式中固定的键(":param"、":path"、":body"等)以Json::StaticString添加，不复制键名.
+ */
+Json::Value* DemandMember(Json::Value* object, const char* key_begin, const char* key_end);
+
+/**
+ * @brief 序列化为紧凑的JSON，追加到out末尾.
+ *
+ * @details 输出与 Json::FastWriter(emitUTF8、omitEndingLineFeed、dropNullKeyValues)完全一致：
+ *          对象的键按字典序输出，值为null的键被忽略，非ASCII字符不转义.
+ * @details 直接写入out，不经过中间缓冲区；需要转义的字符使用SIMD查找.
+ */
+void Write(const Json::Value& value, std::string* out);
+
+/**
+ * @brief 写入带引号的字符串(转义规则与Write一致).
+ */
+void WriteString(const char* str, size_t len, std::string* out);
+
+/**
+ * @brief 写入整数、浮点数(格式与Write一致).
+ */
+void WriteInt(int64_t value, std::string* out);
+void WriteUint(uint64_t value, std::string* out);
+void WriteDouble(double value, std::string* out);
+
+/**
+ * @brief 按顺序读取JSON的值，不构造Json::Value.
+ *
+ * @details 用于直接解码到结构体(typed_codec.h)，也是Parse的基础.
+ * @details 各Read函数先跳过空白；类型不符时返回false，此时读取位置不确定.
+ */
+class Reader {
+public:
+    Reader(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    /**
+     * @brief 跳过空白后的当前位置.
+     */
+    const char* position() { SkipWhitespace(); return p_; }
+
+    /**
+     * @brief 下一个值为null时跳过它并返回true.
+     */
+    bool ReadNull();
+
+    bool ReadBool(bool* value);
+
+    /**
+     * @brief 读取整数，带小数点、指数或者超出范围时返回false.
+     */
+    bool ReadInt(int64_t* value);
+    bool ReadUint(uint64_t* value);
+
+    /**
+     * @brief 读取数值(整数也可以).
+     */
+    bool ReadDouble(double* value);
+
+    /**
+     * @brief 读取字符串.
+     *
+     * @details 没有转义字符时返回的区间指向输入，否则指向内部缓冲区(下次读取字符串之前有效).
+     */
+    bool ReadString(const char** begin, const char** end);
+    bool ReadString(std::string* value);
+
+    /**
+     * @brief 跳过一个值.
+     */
+    bool Skip();
+
+    /**
+     * @brief 读取对象，每个成员调用一次 on_member(key, key_length)，由它读取(或跳过)成员的值.
+     *
+     * @details key在on_member读取值之前有效.
+     */
+    template <typename F>
+    bool ReadObject(F&& on_member) {
+        if (!Consume('{')) {
+            return false;
+        }
+        if (Consume('}')) {
+            return true;
+        }
+        while (true) {
+            SkipWhitespace();
+            if (p_ >= end_ || *p_ != '"') {
+                return false;
+            }
+            const char* key = nullptr;
+            const char* key_end = nullptr;
+            if (!ParseString(&key, &key_end) || !Consume(':')) {
+                return false;
+            }
+            if (!on_member(key, static_cast<size_t>(key_end - key))) {
+                return false;
+            }
+            if (Consume(',')) {
+                continue;
+            }
+            return Consume('}');
+        }
+    }
+
+    /**
+     * @brief 读取数组，每个元素调用一次 on_element()，由它读取元素的值.
+     */
+    template <typename F>
+    bool ReadArray(F&& on_element) {
+        if (!Consume('[')) {
+            return false;
+        }
+        if (Consume(']')) {
+            return true;
+        }
+        while (true) {
+            if (!on_element()) {
+                return false;
+            }
+            if (Consume(',')) {
+                continue;
+            }
+            return Consume(']');
+        }
+    }
+
+protected:
+    void SkipWhitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            ++p_;
+        }
+    }
+
+    /**
+     * @brief 跳过空白，下一个字符为c时跳过它并返回true.
+     */
+    bool Consume(char c) {
+        SkipWhitespace();
+        if (p_ < end_ && *p_ == c) {
+            ++p_;
+            return true;
+        }
+        return false;
+    }
+
+    bool ParseString(const char** begin, const char** end);
+    bool ParseHex4(unsigned int* code);
+    bool ParseUnicodeEscape();
+    bool ParseInteger(bool* negative, uint64_t* integer);
+    bool SkipValue(int depth);
+
+protected:
+    const char* p_;
+    const char* end_;
+    std::string unescaped_;  /* 含有转义字符的字符串解码后的内容 */
+};
+
+} // namespace json
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_JSON_JSON_CODEC_H_
@@ -1,54 +1,84 @@
 #include "message.h"
 #include <jsoncpp/json/json.h>
+#include "json_codec.h"
+#include "msgpack_codec.h"
+#include "typed_codec.h"
 
 namespace ic {
 namespace uds {
 
-static std::string s_empty_string;
-
 /**
- * @brief 序列化为字符串，用于发送.
+ * @brief 序列化为多个片段，用于发送.
  * 
  * @details 格式：json串长度(4字节) + json数据(前面指定的长度) + 非json数据(剩余长度).
+ * @details 长度字段和JSON直接写入head(输出与Json::FastWriter一致)，数据体只引用不复制.
+ * @details 使用二进制编码时长度字段的最高位置1，":path"最先写入(Request::PeekPath直接读取).
  */
-std::string Message::Serialize(bool clear_body/* = false*/) {
+void Message::Serialize(std::string* head, std::vector<std::string_view>* buffers) {
+    EnsureParam();
+    EnsureBody();
     size_t body_total_length = 0;
-    if (body_.size()) {
-        Json::Value& body_info = json_[":body"];
-        for (auto iter = body_.begin(); iter != body_.end(); ++iter) {
-            Json::Value node;
-            node[":name"] = iter->first;
-            node[":offset"] = body_total_length;
-            node[":length"] = iter->second.length();
-            body_info.append(node);
-            body_total_length += iter->second.length();
+    json_.removeMember(":body");
+    if (!bodies_.empty()) {
+        /* 固定的键不复制键名，元数据直接在数组中构造 */
+        Json::Value& body_info = json_[Json::StaticString(":body")];
+        for (auto& body : bodies_) {
+            size_t length = body.view().length();
+            Json::Value& node = body_info.append(Json::Value(Json::objectValue));
+            node[Json::StaticString(":name")] = body.name();
+            node[Json::StaticString(":offset")] = body_total_length;
+            node[Json::StaticString(":length")] = length;
+            body_total_length += length;
         }
     }
-    Json::FastWriter fw;
-    fw.emitUTF8();
-    fw.omitEndingLineFeed();
-    fw.dropNullKeyValues();
-    std::string json_string = fw.write(json_);
-    unsigned int json_string_length = static_cast<unsigned int>(json_string.length());  /* 必须用unsigned int, 不能用size_t */
-
-    size_t result_length = 4 + json_string_length + body_total_length;
-    std::string result(result_length, '\0');
-    char* ptr = &(result[0]);
-    memcpy(ptr, &json_string_length, 4);
-    ptr += 4;
-    memcpy(ptr, json_string.c_str(), json_string_length);
-    ptr += json_string_length;
-    for (auto iter = body_.begin(); iter != body_.end();/* ++iter*/) {
-        memcpy(ptr, iter->second.c_str(), iter->second.length());
-        ptr += iter->second.length();
-        if (clear_body) {
-            iter = body_.erase(iter);
+    head->clear();
+    head->reserve(4 + 256);
+    head->append(4, '\0');
+    if (binary_) {
+        msgpack::Write(json_, head, ":path");
+    }
+    else {
+        json::Write(json_, head);
+    }
+    unsigned int json_string_length = static_cast<unsigned int>(head->length() - 4);  /* 必须用unsigned int, 不能用size_t */
+    if (binary_) {
+        json_string_length |= BINARY_ENVELOPE_FLAG;
+    }
+    memcpy(&(*head)[0], &json_string_length, 4);
+
+    buffers->clear();
+    buffers->reserve(1 + bodies_.size());
+    buffers->emplace_back(*head);
+    for (auto& body : bodies_) {
+        buffers->push_back(body.view());
+    }
+}
+
+/**
+ * @brief 序列化为字符串.
+ */
+std::string Message::Serialize(bool clear_body/* = false*/) {
+    std::string head;
+    std::vector<std::string_view> buffers;
+    Serialize(&head, &buffers);
+    std::string result;
+    if (bodies_.empty()) {
+        result.swap(head);
+    }
+    else {
+        size_t len = 0;
+        for (auto& buffer : buffers) {
+            len += buffer.length();
         }
-        else {
-            ++iter;
+        result.reserve(len);
+        for (auto& buffer : buffers) {
+            result.append(buffer.data(), buffer.length());
         }
     }
-
+    if (clear_body) {
+        bodies_.clear();
+        buffer_.reset();
+    }
     return result;
 }
 
@@ -56,17 +86,51 @@ std::string Message::Serialize(bool clear_body/* = false*/) {
  * @brief 反序列化，解析字符串数据.
  */
 bool Message::Deserialize(const std::string& data) {
+    buffer_.reset();
+    return DeserializeImpl(data);
+}
+
+/**
+ * @brief 反序列化，接管接收缓冲区.
+ */
+bool Message::Deserialize(std::string&& data) {
+    buffer_ = std::make_shared<const std::string>(std::move(data));
+    return DeserializeImpl(*buffer_);
+}
+
+/**
+ * @brief 反序列化，共享数据.
+ */
+bool Message::Deserialize(std::shared_ptr<const std::string> data) {
+    buffer_ = std::move(data);
+    return DeserializeImpl(*buffer_);
+}
+
+bool Message::DeserializeImpl(const std::string& data) {
+    bodies_.clear();
+    pending_data_ = nullptr;
+    pending_param_begin_ = pending_param_end_ = nullptr;
+    pending_body_begin_ = pending_body_end_ = nullptr;
     size_t len = data.length();
-    if (len < 16) {
+    if (len < 5) {
         return false;
     }
 
-    size_t json_len = static_cast<size_t>(*(unsigned int*)(data.c_str()));
+    unsigned int length_field = *(unsigned int*)(data.c_str());
+    binary_ = (length_field & BINARY_ENVELOPE_FLAG) != 0;
+    size_t json_len = static_cast<size_t>(length_field & ~BINARY_ENVELOPE_FLAG);
     if (json_len > 100000000 || json_len + 4 > len) {
         return false;
     }
-    if (!ParseJson(data, 4, 4 + json_len)) {
-        return false;
+    if (binary_) {
+        if (!ParseBinary(data, 4, 4 + json_len)) {
+            return false;
+        }
+    }
+    else {
+        if (len < 16 || !ParseJson(data, 4, 4 + json_len)) {
+            return false;
+        }
     }
     if (!ParseBody(data, 4 + json_len)) {
         return false;
@@ -76,44 +140,192 @@ bool Message::Deserialize(const std::string& data) {
 }
 
 /**
- * @brief 获取body数据.
+ * @brief ":param"的值是否为对象或者null(只检查第一个字节).
+ */
+static bool s_is_object_or_null(const char* value, bool binary) {
+    uint8_t c = static_cast<uint8_t>(*value);
+    if (binary) {
+        return (c >= 0x80 && c <= 0x8f) || c == 0xde || c == 0xdf || c == 0xc0;
+    }
+    return c == '{' || c == 'n';
+}
+
+/**
+ * @brief 延迟反序列化.
+ * 
+ * @details 请求路径等其他键由调用方读取(如 Request::PeekPath())，这里只记录":param"和":body"的位置.
  */
-const std::string& Message::GetBody(const std::string& name) const {
-    auto iter = body_.find(name);
-    if (iter != body_.end()) {
-        return iter->second;
+bool Message::DeserializeLazy(const std::string& data) {
+    typed::Envelope envelope;
+    if (!typed::ScanEnvelope(data, &envelope)) {
+        return false;
+    }
+    if (envelope.param_begin && !s_is_object_or_null(envelope.param_begin, envelope.binary)) {
+        return false;
     }
-    return s_empty_string;
+    json_ = Json::Value();
+    bodies_.clear();
+    buffer_.reset();
+    binary_ = envelope.binary;
+    pending_data_ = &data;
+    pending_param_begin_ = envelope.param_begin;
+    pending_param_end_ = envelope.param_end;
+    pending_body_begin_ = envelope.body_begin;
+    pending_body_end_ = envelope.body_end;
+    pending_body_start_ = envelope.body_start;
+    return true;
+}
+
+/**
+ * @brief 解析延迟解析的":param".
+ * 
+ * @details 访问参数的接口为const，解析结果仍然写入json_. 格式在DeserializeLazy中已检查，
+ *          解析失败(如嵌套过深)时参数为空.
+ */
+void Message::ParsePendingParam() const {
+    const char* begin = pending_param_begin_;
+    const char* end = pending_param_end_;
+    pending_param_begin_ = pending_param_end_ = nullptr;
+    Json::Value param;
+    bool ok = binary_ ? msgpack::Parse(begin, end, &param) : json::Parse(begin, end, &param);
+    if (!ok || !(param.isNull() || param.isObject())) {
+        fprintf(stderr, "Parse :param failed\n");
+        return;
+    }
+    const_cast<Message*>(this)->json_[Json::StaticString(":param")].swap(param);
+}
+
+/**
+ * @brief 解析延迟解析的":body"，记录各个数据体的位置.
+ */
+void Message::ParsePendingBody() const {
+    const char* begin = pending_body_begin_;
+    const char* end = pending_body_end_;
+    pending_body_begin_ = pending_body_end_ = nullptr;
+    Message* self = const_cast<Message*>(this);
+    Json::Value& body_info = self->json_[Json::StaticString(":body")];
+    bool ok = binary_ ? msgpack::Parse(begin, end, &body_info) : json::Parse(begin, end, &body_info);
+    if (!ok || !self->ParseBody(*pending_data_, pending_body_start_)) {
+        fprintf(stderr, "Parse :body failed\n");
+        self->bodies_.clear();
+    }
+}
+
+/**
+ * @brief 获取数据体.
+ */
+std::string_view Message::GetBody(const std::string& name) const {
+    const Body* body = FindBody(name);
+    return body ? body->view() : std::string_view();
+}
+
+/**
+ * @brief 取得数据体的所有权.
+ */
+std::string Message::TakeBody(const std::string& name) {
+    EnsureBody();
+    for (auto iter = bodies_.begin(); iter != bodies_.end(); ++iter) {
+        if (iter->name() == name) {
+            std::string data = iter->Take();
+            bodies_.erase(iter);
+            return data;
+        }
+    }
+    return std::string();
+}
+
+void Message::Detach() {
+    EnsureParam();
+    EnsureBody();
+    pending_data_ = nullptr;
+    /* 接管的接收缓冲区(buffer_)随消息一起复制，不必复制 */
+    if (!buffer_) {
+        for (auto& body : bodies_) {
+            if (!body.owned()) {
+                body = Body(body.name(), body.Take());
+            }
+        }
+    }
+}
+
+const Body* Message::FindBody(const std::string& name) const {
+    EnsureBody();
+    for (auto& body : bodies_) {
+        if (body.name() == name) {
+            return &body;
+        }
+    }
+    return nullptr;
+}
+
+void Message::SetBody(Body&& body) {
+    EnsureBody();
+    for (auto& item : bodies_) {
+        if (item.name() == body.name()) {
+            item = std::move(body);
+            return;
+        }
+    }
+    bodies_.push_back(std::move(body));
+}
+
+/**
+ * @brief 检查顶层为对象，":param"为对象或者不存在(不添加成员).
+ */
+static bool s_check_param(const Json::Value& root) {
+    if (!root.isObject()) {
+        return false;
+    }
+    const Json::Value* param = root.find(":param", ":param" + 6);
+    return !param || param->isNull() || param->isObject();
 }
 
 /**
  * @brief 解析JSON参数.
+ * 
+ * @details 优先使用json::Parse，不支持的语法(如注释)再回退到Json::Reader.
  */
 bool Message::ParseJson(const std::string& data, size_t start, size_t end) {
-    Json::Reader reader;
     const char* doc_start = data.c_str() + start;
     const char* doc_end = data.c_str() + end;
-    if (!reader.parse(doc_start, doc_end, json_, false)) {
+    if (!json::Parse(doc_start, doc_end, &json_)) {
+        Json::Reader reader;
+        if (!reader.parse(doc_start, doc_end, json_, false)) {
+            return false;
+        }
+    }
+    return s_check_param(json_);
+}
+
+/**
+ * @brief 解析二进制编码(MessagePack)的JSON参数.
+ */
+bool Message::ParseBinary(const std::string& data, size_t start, size_t end) {
+    if (!msgpack::Parse(data.c_str() + start, data.c_str() + end, &json_)) {
         return false;
     }
-    return json_.isObject() && (!json_[":param"] || json_[":param"].isObject());
+    return s_check_param(json_);
 }
 
 /**
  * @brief 解析非JSON数据体.
+ * 
+ * @details 只记录数据体在data中的位置，不复制.
  */
 bool Message::ParseBody(const std::string& data, size_t body_start) {
-    Json::Value& body_info = json_[":body"];
-    if (body_info.isNull()) {
+    const Json::Value* body_info_ptr = json_.find(":body", ":body" + 5);
+    if (!body_info_ptr || body_info_ptr->isNull()) {
         return true;
     }
+    const Json::Value& body_info = *body_info_ptr;
     if (!body_info.isArray()) {
         return false;
     }
     size_t len = data.length();
+    bodies_.reserve(body_info.size());
     for (unsigned int i = 0, count = body_info.size(); i < count; ++i) {
-        Json::Value& node = body_info[i];
-        if (node.isNull() || !node[":name"].isString() || !node[":offset"].isUInt() || !node[":length"].isUInt()) {
+        const Json::Value& node = body_info[i];
+        if (!node.isObject() || !node[":name"].isString() || !node[":offset"].isUInt() || !node[":length"].isUInt()) {
             return false;
         }
         std::string name = node[":name"].asString();
@@ -124,7 +336,7 @@ bool Message::ParseBody(const std::string& data, size_t body_start) {
         if (name.empty() || start < body_start || end > len) {
             return false;
         }
-        body_[name] = data.substr(start, length);
+        SetBody(Body(name, std::string_view(data.c_str() + start, length)));
     }
     return true;
 }
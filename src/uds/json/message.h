@@ -1,15 +1,55 @@
 #ifndef IC_UDS_JSON_MESSAGE_H_
 #define IC_UDS_JSON_MESSAGE_H_
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <jsoncpp/json/value.h>
 
 namespace ic {
 namespace uds {
 
+/**
+ * @brief 非JSON数据体.
+ * 
+ * @details 接收到的数据体只记录在接收缓冲区中的位置，不复制；发送的数据体可以持有数据，也可以只引用外部数据.
+ */
+class Body {
+public:
+    Body(const std::string& name, std::string&& data)
+        : name_(name), data_(std::move(data)), owned_(true) {}
+    Body(const std::string& name, std::string_view view)
+        : name_(name), view_(view), owned_(false) {}
+
+    const std::string& name() const { return name_; }
+    std::string_view view() const { return owned_ ? std::string_view(data_) : view_; }
+
+    /**
+     * @brief 是否持有数据(否则引用接收缓冲区或外部数据).
+     */
+    bool owned() const { return owned_; }
+
+    /**
+     * @brief 取得数据的所有权，引用的数据此时才复制.
+     */
+    std::string Take() { return owned_ ? std::move(data_) : std::string(view_); }
+
+private:
+    std::string name_;
+    std::string data_;
+    std::string_view view_;
+    bool owned_;
+};
+
 class Message {
 public:
     Message(int64_t id = -1) : id_(id) {}
 
+    /**
+     * @brief 长度字段的最高位，表示JSON部分使用二进制编码(MessagePack).
+     */
+    static const unsigned int BINARY_ENVELOPE_FLAG = 0x80000000u;
+
 public:
     /**
      * @brief 当前请求ID.
@@ -19,17 +59,53 @@ public:
     /**
      * @brief 返回json_[":param"]
      */
-    const Json::Value& param() const { return json_[":param"]; }
+    const Json::Value& param() const { EnsureParam(); return json_[":param"]; }
 
     /**
      * @brief 重载[]运算符，返回json_[":param"][name]的引用.
      */
-    Json::Value& operator[](const char* name) { return json_[":param"][name]; }
-    Json::Value& operator[](const std::string& name) { return json_[":param"][name]; }
+    Json::Value& operator[](const char* name) { EnsureParam(); return json_[Json::StaticString(":param")][name]; }
+    Json::Value& operator[](const std::string& name) { EnsureParam(); return json_[Json::StaticString(":param")][name]; }
+
+    /**
+     * @brief 所有数据体(按添加或接收的顺序).
+     */
+    const std::vector<Body>& bodies() const { EnsureBody(); return bodies_; }
+
+    /**
+     * @brief 获取数据体，不存在时返回空.
+     * 
+     * @details 返回的数据指向接收缓冲区(不复制)，与当前消息的生命周期相同；
+     *          服务端请求的接收缓冲区在处理函数返回后释放，需要保留时调用 TakeBody().
+     */
+    std::string_view GetBody(const std::string& name) const;
+    bool HasBody(const std::string& name) const { return FindBody(name) != nullptr; }
+
+    /**
+     * @brief 取得数据体的所有权(从当前消息中移除)，不存在时返回空字符串.
+     */
+    std::string TakeBody(const std::string& name);
+
+    /**
+     * @brief 添加数据体，同名的数据体会被替换.
+     */
+    void AddBody(const std::string& name, const std::string& value) { SetBody(Body(name, std::string(value))); }
+    void AddBody(const std::string& name, std::string&& value) { SetBody(Body(name, std::move(value))); }
+
+    /**
+     * @brief 添加数据体，只引用数据不复制，发送完成之前必须保持有效.
+     * 
+     * @details 例如服务端原样返回请求中的数据体：res.AddBodyView("image", req.GetBody("image")).
+     */
+    void AddBodyView(const std::string& name, std::string_view value) { SetBody(Body(name, value)); }
 
-    std::map<std::string, std::string>& body() { return body_; }
-    const std::string& GetBody(const std::string& name) const;
-    void AddBody(const std::string& name, const std::string& value) { body_[name] = value; }
+    /**
+     * @brief JSON部分是否使用二进制编码(MessagePack).
+     * 
+     * @details 长度字段的最高位为1时表示二进制编码，反序列化时自动识别.
+     */
+    bool binary() const { return binary_; }
+    void set_binary(bool binary) { binary_ = binary; }
 
 protected:
     void set_id(int64_t id) { id_ = id; }
@@ -39,13 +115,65 @@ protected:
      */
     std::string Serialize(bool clear_body = false);
 
+    /**
+     * @brief 序列化为多个片段，用于发送(数据体不复制).
+     * 
+     * @param head [out] 长度字段和JSON部分
+     * @param buffers [out] 依次为head和各个数据体，发送完成之前head和数据体必须保持有效
+     */
+    void Serialize(std::string* head, std::vector<std::string_view>* buffers);
+
     /**
      * @brief 反序列化，解析字符串数据.
+     * 
+     * @details 数据体引用data，data必须在当前消息使用期间保持有效.
      */
     bool Deserialize(const std::string& data);
 
+    /**
+     * @brief 反序列化，接管接收缓冲区，数据体引用其中的数据.
+     */
+    bool Deserialize(std::string&& data);
+
+    /**
+     * @brief 反序列化，共享data(如缓存的响应)，数据体引用其中的数据.
+     */
+    bool Deserialize(std::shared_ptr<const std::string> data);
+
+    /**
+     * @brief 延迟反序列化，只读取头部，":param"和":body"在第一次访问时才解析.
+     * 
+     * @details 只定位各部分在data中的位置(同时检查格式)，不构造Json::Value；
+     *          data必须在当前消息使用期间保持有效.
+     * @retval false 数据格式不符合预期(或者JSON不是严格的格式)，需要完整解析
+     */
+    bool DeserializeLazy(const std::string& data);
+
+    /**
+     * @brief 不再依赖接收缓冲区：解析延迟的部分，引用接收缓冲区的数据体复制为持有数据.
+     * 
+     * @details 用于在接收缓冲区释放之后继续使用消息(如合并为批次的请求).
+     */
+    void Detach();
+
 private:
+    bool DeserializeImpl(const std::string& data);
+    void EnsureParam() const {
+        if (pending_param_begin_) {
+            ParsePendingParam();
+        }
+    }
+    void EnsureBody() const {
+        if (pending_body_begin_) {
+            ParsePendingBody();
+        }
+    }
+    void ParsePendingParam() const;
+    void ParsePendingBody() const;
+    const Body* FindBody(const std::string& name) const;
+    void SetBody(Body&& body);
     bool ParseJson(const std::string& data, size_t start, size_t end);
+    bool ParseBinary(const std::string& data, size_t start, size_t end);
     bool ParseBody(const std::string& data, size_t body_start);
 
 protected:
@@ -54,6 +182,11 @@ protected:
      */
     int64_t id_{-1};
 
+    /**
+     * @brief JSON部分是否使用二进制编码.
+     */
+    bool binary_{false};
+
     /**
      * @brief JSON数据
      * 
@@ -81,8 +214,26 @@ protected:
      * 
      * @details 元数据信息存在 json_[":body"]中.
      * @details 可以存储任何数据，如大文本数据、二进制数据等.
+     * @details 一个消息通常只有几个数据体，使用数组按名称顺序查找.
+     */
+    std::vector<Body> bodies_;
+
+    /**
+     * @brief 接管的接收缓冲区(客户端收到的响应)，数据体引用其中的数据.
+     * 
+     * @details 复制消息时共享同一个缓冲区.
+     */
+    std::shared_ptr<const std::string> buffer_;
+
+    /**
+     * @brief 延迟解析(DeserializeLazy)的数据，及尚未解析的":param"、":body"的值在其中的位置(解析后置空).
      */
-    std::map<std::string, std::string> body_;
+    const std::string* pending_data_{nullptr};
+    mutable const char* pending_param_begin_{nullptr};
+    mutable const char* pending_param_end_{nullptr};
+    mutable const char* pending_body_begin_{nullptr};
+    mutable const char* pending_body_end_{nullptr};
+    size_t pending_body_start_{0};
 };
 
 } // namespace uds
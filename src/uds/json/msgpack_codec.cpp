@@ -0,0 +1,636 @@
+#include "msgpack_codec.h"
+#include <string.h>
+#include "json_codec.h"
+
+namespace ic {
+namespace uds {
+namespace msgpack {
+
+/**
+ * @brief 与json::Parse一致的最大嵌套深度.
+ */
+static const int MAX_DEPTH = 1000;
+
+/**
+ * @brief 写入大端整数.
+ */
+template <typename T>
+static inline void s_write_be(std::string* out, uint8_t tag, T value) {
+    char buffer[1 + sizeof(T)];
+    buffer[0] = static_cast<char>(tag);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        buffer[sizeof(T) - i] = static_cast<char>(static_cast<uint64_t>(value) >> (i * 8));
+    }
+    out->append(buffer, sizeof(buffer));
+}
+
+/**
+ * @brief 读取大端整数.
+ */
+template <typename T>
+static inline bool s_read_be(const char** p, const char* end, T* value) {
+    if (static_cast<size_t>(end - *p) < sizeof(T)) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        v = (v << 8) | static_cast<uint8_t>((*p)[i]);
+    }
+    *value = static_cast<T>(v);
+    *p += sizeof(T);
+    return true;
+}
+
+static void s_write_uint(uint64_t value, std::string* out) {
+    if (value <= 0x7f) {
+        out->push_back(static_cast<char>(value));
+    }
+    else if (value <= UINT8_MAX) {
+        s_write_be<uint8_t>(out, 0xcc, static_cast<uint8_t>(value));
+    }
+    else if (value <= UINT16_MAX) {
+        s_write_be<uint16_t>(out, 0xcd, static_cast<uint16_t>(value));
+    }
+    else if (value <= UINT32_MAX) {
+        s_write_be<uint32_t>(out, 0xce, static_cast<uint32_t>(value));
+    }
+    else {
+        s_write_be<uint64_t>(out, 0xcf, value);
+    }
+}
+
+static void s_write_int(int64_t value, std::string* out) {
+    if (value >= 0) {
+        s_write_uint(static_cast<uint64_t>(value), out);
+    }
+    else if (value >= -32) {
+        out->push_back(static_cast<char>(value));  /* negative fixint */
+    }
+    else if (value >= INT8_MIN) {
+        s_write_be<int8_t>(out, 0xd0, static_cast<int8_t>(value));
+    }
+    else if (value >= INT16_MIN) {
+        s_write_be<int16_t>(out, 0xd1, static_cast<int16_t>(value));
+    }
+    else if (value >= INT32_MIN) {
+        s_write_be<int32_t>(out, 0xd2, static_cast<int32_t>(value));
+    }
+    else {
+        s_write_be<int64_t>(out, 0xd3, value);
+    }
+}
+
+static void s_write_string(const char* str, size_t len, std::string* out) {
+    if (len <= 31) {
+        out->push_back(static_cast<char>(0xa0 | len));
+    }
+    else if (len <= UINT8_MAX) {
+        s_write_be<uint8_t>(out, 0xd9, static_cast<uint8_t>(len));
+    }
+    else if (len <= UINT16_MAX) {
+        s_write_be<uint16_t>(out, 0xda, static_cast<uint16_t>(len));
+    }
+    else {
+        s_write_be<uint32_t>(out, 0xdb, static_cast<uint32_t>(len));
+    }
+    out->append(str, len);
+}
+
+static void s_write_container_header(size_t count, uint8_t fix_tag, uint8_t tag16, uint8_t tag32, std::string* out) {
+    if (count <= 15) {
+        out->push_back(static_cast<char>(fix_tag | count));
+    }
+    else if (count <= UINT16_MAX) {
+        s_write_be<uint16_t>(out, tag16, static_cast<uint16_t>(count));
+    }
+    else {
+        s_write_be<uint32_t>(out, tag32, static_cast<uint32_t>(count));
+    }
+}
+
+static void s_write_value(const Json::Value& value, std::string* out, const char* first_key) {
+    switch (value.type()) {
+    case Json::nullValue:
+        out->push_back(static_cast<char>(0xc0));
+        break;
+    case Json::intValue:
+        s_write_int(value.asLargestInt(), out);
+        break;
+    case Json::uintValue:
+        s_write_uint(value.asLargestUInt(), out);
+        break;
+    case Json::realValue: {
+        double real = value.asDouble();
+        uint64_t bits = 0;
+        memcpy(&bits, &real, 8);
+        s_write_be<uint64_t>(out, 0xcb, bits);
+        break;
+    }
+    case Json::stringValue: {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        if (value.getString(&begin, &end)) {
+            s_write_string(begin, static_cast<size_t>(end - begin), out);
+        }
+        else {
+            s_write_string("", 0, out);
+        }
+        break;
+    }
+    case Json::booleanValue:
+        out->push_back(static_cast<char>(value.asBool() ? 0xc3 : 0xc2));
+        break;
+    case Json::arrayValue: {
+        Json::ArrayIndex size = value.size();
+        s_write_container_header(size, 0x90, 0xdc, 0xdd, out);
+        for (Json::ArrayIndex i = 0; i < size; ++i) {
+            s_write_value(value[i], out, nullptr);
+        }
+        break;
+    }
+    case Json::objectValue: {
+        size_t count = 0;
+        for (auto iter = value.begin(); iter != value.end(); ++iter) {
+            if (!iter->isNull()) {
+                ++count;
+            }
+        }
+        s_write_container_header(count, 0x80, 0xde, 0xdf, out);
+        const Json::Value* first = nullptr;
+        if (first_key) {
+            first = value.find(first_key, first_key + strlen(first_key));
+            if (first && !first->isNull()) {
+                s_write_string(first_key, strlen(first_key), out);
+                s_write_value(*first, out, nullptr);
+            }
+        }
+        for (auto iter = value.begin(); iter != value.end(); ++iter) {
+            if (iter->isNull() || &(*iter) == first) {
+                continue;
+            }
+            const char* name_end = nullptr;
+            const char* name = iter.memberName(&name_end);
+            s_write_string(name, static_cast<size_t>(name_end - name), out);
+            s_write_value(*iter, out, nullptr);
+        }
+        break;
+    }
+    }
+}
+
+/**
+ * @brief 编码为MessagePack，追加到out末尾.
+ */
+void Write(const Json::Value& value, std::string* out, const char* first_key/* = nullptr*/) {
+    s_write_value(value, out, first_key);
+}
+
+void WriteNil(std::string* out) {
+    out->push_back(static_cast<char>(0xc0));
+}
+
+void WriteBool(bool value, std::string* out) {
+    out->push_back(static_cast<char>(value ? 0xc3 : 0xc2));
+}
+
+void WriteInt(int64_t value, std::string* out) {
+    s_write_int(value, out);
+}
+
+void WriteUint(uint64_t value, std::string* out) {
+    s_write_uint(value, out);
+}
+
+void WriteDouble(double value, std::string* out) {
+    uint64_t bits = 0;
+    memcpy(&bits, &value, 8);
+    s_write_be<uint64_t>(out, 0xcb, bits);
+}
+
+void WriteString(const char* str, size_t len, std::string* out) {
+    s_write_string(str, len, out);
+}
+
+void WriteMapHeader(size_t count, std::string* out) {
+    s_write_container_header(count, 0x80, 0xde, 0xdf, out);
+}
+
+void WriteArrayHeader(size_t count, std::string* out) {
+    s_write_container_header(count, 0x90, 0xdc, 0xdd, out);
+}
+
+/**
+ * @brief 读取str(或bin)类型的值.
+ */
+bool ReadString(const char** p, const char* end, const char** str, size_t* len) {
+    if (*p >= end) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(**p);
+    ++*p;
+    uint32_t length = 0;
+    if ((tag & 0xe0) == 0xa0) {
+        length = tag & 0x1f;
+    }
+    else if (tag == 0xd9 || tag == 0xc4) {
+        uint8_t n = 0;
+        if (!s_read_be(p, end, &n)) {
+            return false;
+        }
+        length = n;
+    }
+    else if (tag == 0xda || tag == 0xc5) {
+        uint16_t n = 0;
+        if (!s_read_be(p, end, &n)) {
+            return false;
+        }
+        length = n;
+    }
+    else if (tag == 0xdb || tag == 0xc6) {
+        if (!s_read_be(p, end, &length)) {
+            return false;
+        }
+    }
+    else {
+        return false;
+    }
+    if (static_cast<size_t>(end - *p) < length) {
+        return false;
+    }
+    *str = *p;
+    *len = length;
+    *p += length;
+    return true;
+}
+
+/**
+ * @brief 读取map类型的头部.
+ */
+bool ReadMapHeader(const char** p, const char* end, uint32_t* count) {
+    if (*p >= end) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(**p);
+    ++*p;
+    if ((tag & 0xf0) == 0x80) {
+        *count = tag & 0x0f;
+        return true;
+    }
+    if (tag == 0xde) {
+        uint16_t n = 0;
+        if (!s_read_be(p, end, &n)) {
+            return false;
+        }
+        *count = n;
+        return true;
+    }
+    if (tag == 0xdf) {
+        return s_read_be(p, end, count);
+    }
+    return false;
+}
+
+/**
+ * @brief 读取array类型的头部.
+ */
+bool ReadArrayHeader(const char** p, const char* end, uint32_t* count) {
+    if (*p >= end) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(**p);
+    ++*p;
+    if ((tag & 0xf0) == 0x90) {
+        *count = tag & 0x0f;
+        return true;
+    }
+    if (tag == 0xdc) {
+        uint16_t n = 0;
+        if (!s_read_be(p, end, &n)) {
+            return false;
+        }
+        *count = n;
+        return true;
+    }
+    if (tag == 0xdd) {
+        return s_read_be(p, end, count);
+    }
+    return false;
+}
+
+bool ReadNil(const char** p, const char* end) {
+    if (*p < end && static_cast<uint8_t>(**p) == 0xc0) {
+        ++*p;
+        return true;
+    }
+    return false;
+}
+
+bool ReadBool(const char** p, const char* end, bool* value) {
+    if (*p >= end) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(**p);
+    if (tag != 0xc2 && tag != 0xc3) {
+        return false;
+    }
+    ++*p;
+    *value = (tag == 0xc3);
+    return true;
+}
+
+/**
+ * @brief 读取整数，有符号的编码返回负数时negative为true.
+ */
+static bool s_read_integer(const char** p, const char* end, bool* negative, uint64_t* magnitude) {
+    if (*p >= end) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(**p);
+    int64_t signed_value = 0;
+    *negative = false;
+    if (tag <= 0x7f) {
+        ++*p;
+        *magnitude = tag;
+        return true;
+    }
+    if (tag >= 0xe0) {
+        ++*p;
+        signed_value = static_cast<int8_t>(tag);
+    }
+    else {
+        const char* q = *p + 1;
+        switch (tag) {
+        case 0xcc: { uint8_t v;  if (!s_read_be(&q, end, &v)) return false; *magnitude = v; *p = q; return true; }
+        case 0xcd: { uint16_t v; if (!s_read_be(&q, end, &v)) return false; *magnitude = v; *p = q; return true; }
+        case 0xce: { uint32_t v; if (!s_read_be(&q, end, &v)) return false; *magnitude = v; *p = q; return true; }
+        case 0xcf: { uint64_t v; if (!s_read_be(&q, end, &v)) return false; *magnitude = v; *p = q; return true; }
+        case 0xd0: { int8_t v;   if (!s_read_be(&q, end, &v)) return false; signed_value = v; break; }
+        case 0xd1: { int16_t v;  if (!s_read_be(&q, end, &v)) return false; signed_value = v; break; }
+        case 0xd2: { int32_t v;  if (!s_read_be(&q, end, &v)) return false; signed_value = v; break; }
+        case 0xd3: { int64_t v;  if (!s_read_be(&q, end, &v)) return false; signed_value = v; break; }
+        default:
+            return false;
+        }
+        *p = q;
+    }
+    *negative = signed_value < 0;
+    *magnitude = *negative ? static_cast<uint64_t>(0) - static_cast<uint64_t>(signed_value) : static_cast<uint64_t>(signed_value);
+    return true;
+}
+
+bool ReadInt(const char** p, const char* end, int64_t* value) {
+    bool negative = false;
+    uint64_t magnitude = 0;
+    if (!s_read_integer(p, end, &negative, &magnitude)) {
+        return false;
+    }
+    if (negative) {
+        *value = static_cast<int64_t>(static_cast<uint64_t>(0) - magnitude);
+        return true;
+    }
+    if (magnitude > static_cast<uint64_t>(INT64_MAX)) {
+        return false;
+    }
+    *value = static_cast<int64_t>(magnitude);
+    return true;
+}
+
+bool ReadUint(const char** p, const char* end, uint64_t* value) {
+    bool negative = false;
+    return s_read_integer(p, end, &negative, value) && !negative;
+}
+
+bool ReadDouble(const char** p, const char* end, double* value) {
+    if (*p >= end) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(**p);
+    if (tag == 0xca || tag == 0xcb) {
+        const char* q = *p + 1;
+        if (tag == 0xca) {
+            uint32_t bits = 0;
+            if (!s_read_be(&q, end, &bits)) {
+                return false;
+            }
+            float real = 0;
+            memcpy(&real, &bits, 4);
+            *value = real;
+        }
+        else {
+            uint64_t bits = 0;
+            if (!s_read_be(&q, end, &bits)) {
+                return false;
+            }
+            memcpy(value, &bits, 8);
+        }
+        *p = q;
+        return true;
+    }
+    bool negative = false;
+    uint64_t magnitude = 0;
+    if (!s_read_integer(p, end, &negative, &magnitude)) {
+        return false;
+    }
+    *value = negative ? -static_cast<double>(magnitude) : static_cast<double>(magnitude);
+    return true;
+}
+
+static bool s_skip_value(const char** p, const char* end, int depth) {
+    if (*p >= end || depth > MAX_DEPTH) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(**p);
+    if ((tag & 0xf0) == 0x80 || tag == 0xde || tag == 0xdf) {
+        uint32_t count = 0;
+        if (!ReadMapHeader(p, end, &count)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!s_skip_value(p, end, depth + 1) || !s_skip_value(p, end, depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if ((tag & 0xf0) == 0x90 || tag == 0xdc || tag == 0xdd) {
+        uint32_t count = 0;
+        if (!ReadArrayHeader(p, end, &count)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!s_skip_value(p, end, depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if ((tag & 0xe0) == 0xa0 || tag == 0xd9 || tag == 0xda || tag == 0xdb || tag == 0xc4 || tag == 0xc5 || tag == 0xc6) {
+        const char* str = nullptr;
+        size_t len = 0;
+        return ReadString(p, end, &str, &len);
+    }
+    if (tag == 0xc0 || tag == 0xc2 || tag == 0xc3) {
+        ++*p;
+        return true;
+    }
+    double value = 0;
+    return ReadDouble(p, end, &value);
+}
+
+bool Skip(const char** p, const char* end) {
+    return s_skip_value(p, end, 0);
+}
+
+/**
+ * @brief 整数转换为Json::Value，类型与json::Parse一致.
+ */
+static inline Json::Value s_int_value(int64_t value) {
+    if (value >= 0 && value > static_cast<int64_t>(Json::Value::maxInt)) {
+        return Json::Value(static_cast<Json::LargestUInt>(value));
+    }
+    return Json::Value(static_cast<Json::LargestInt>(value));
+}
+
+static inline Json::Value s_uint_value(uint64_t value) {
+    if (value <= static_cast<uint64_t>(Json::Value::maxInt)) {
+        return Json::Value(static_cast<Json::LargestInt>(value));
+    }
+    return Json::Value(static_cast<Json::LargestUInt>(value));
+}
+
+static bool s_parse_value(const char** p, const char* end, Json::Value* value, int depth);
+
+static bool s_parse_array(const char** p, const char* end, uint32_t count, Json::Value* value, int depth) {
+    if (depth > MAX_DEPTH || count > static_cast<size_t>(end - *p)) {
+        return false;  /* 每个元素至少1字节 */
+    }
+    *value = Json::Value(Json::arrayValue);
+    if (count > 0) {
+        value->resize(count);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!s_parse_value(p, end, &(*value)[i], depth)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool s_parse_map(const char** p, const char* end, uint32_t count, Json::Value* value, int depth) {
+    if (depth > MAX_DEPTH || count > static_cast<size_t>(end - *p) / 2) {
+        return false;  /* 每个成员至少2字节 */
+    }
+    *value = Json::Value(Json::objectValue);
+    for (uint32_t i = 0; i < count; ++i) {
+        const char* key = nullptr;
+        size_t key_len = 0;
+        if (!ReadString(p, end, &key, &key_len)) {
+            return false;
+        }
+        Json::Value* member = json::DemandMember(value, key, key + key_len);
+        if (!s_parse_value(p, end, member, depth)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool s_parse_value(const char** p, const char* end, Json::Value* value, int depth) {
+    if (*p >= end) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(**p);
+    if (tag <= 0x7f) {
+        ++*p;
+        *value = Json::Value(static_cast<Json::LargestInt>(tag));
+        return true;
+    }
+    if (tag >= 0xe0) {
+        ++*p;
+        *value = Json::Value(static_cast<Json::LargestInt>(static_cast<int8_t>(tag)));
+        return true;
+    }
+    if ((tag & 0xf0) == 0x80 || tag == 0xde || tag == 0xdf) {
+        uint32_t count = 0;
+        return ReadMapHeader(p, end, &count) && s_parse_map(p, end, count, value, depth + 1);
+    }
+    if ((tag & 0xe0) == 0xa0 || tag == 0xd9 || tag == 0xda || tag == 0xdb || tag == 0xc4 || tag == 0xc5 || tag == 0xc6) {
+        const char* str = nullptr;
+        size_t len = 0;
+        if (!ReadString(p, end, &str, &len)) {
+            return false;
+        }
+        *value = Json::Value(str, str + len);
+        return true;
+    }
+    if ((tag & 0xf0) == 0x90) {
+        ++*p;
+        return s_parse_array(p, end, tag & 0x0f, value, depth + 1);
+    }
+
+    ++*p;
+    switch (tag) {
+    case 0xc0:
+        *value = Json::Value();
+        return true;
+    case 0xc2:
+        *value = Json::Value(false);
+        return true;
+    case 0xc3:
+        *value = Json::Value(true);
+        return true;
+    case 0xcc: { uint8_t v;  if (!s_read_be(p, end, &v)) return false; *value = s_uint_value(v); return true; }
+    case 0xcd: { uint16_t v; if (!s_read_be(p, end, &v)) return false; *value = s_uint_value(v); return true; }
+    case 0xce: { uint32_t v; if (!s_read_be(p, end, &v)) return false; *value = s_uint_value(v); return true; }
+    case 0xcf: { uint64_t v; if (!s_read_be(p, end, &v)) return false; *value = s_uint_value(v); return true; }
+    case 0xd0: { int8_t v;   if (!s_read_be(p, end, &v)) return false; *value = s_int_value(v); return true; }
+    case 0xd1: { int16_t v;  if (!s_read_be(p, end, &v)) return false; *value = s_int_value(v); return true; }
+    case 0xd2: { int32_t v;  if (!s_read_be(p, end, &v)) return false; *value = s_int_value(v); return true; }
+    case 0xd3: { int64_t v;  if (!s_read_be(p, end, &v)) return false; *value = s_int_value(v); return true; }
+    case 0xca: {
+        uint32_t bits = 0;
+        if (!s_read_be(p, end, &bits)) {
+            return false;
+        }
+        float real = 0;
+        memcpy(&real, &bits, 4);
+        *value = Json::Value(static_cast<double>(real));
+        return true;
+    }
+    case 0xcb: {
+        uint64_t bits = 0;
+        if (!s_read_be(p, end, &bits)) {
+            return false;
+        }
+        double real = 0;
+        memcpy(&real, &bits, 8);
+        *value = Json::Value(real);
+        return true;
+    }
+    case 0xdc: {
+        uint16_t count = 0;
+        return s_read_be(p, end, &count) && s_parse_array(p, end, count, value, depth + 1);
+    }
+    case 0xdd: {
+        uint32_t count = 0;
+        return s_read_be(p, end, &count) && s_parse_array(p, end, count, value, depth + 1);
+    }
+    default:
+        return false;  /* ext等不支持的类型 */
+    }
+}
+
+/**
+ * @brief 解码MessagePack，直接构造Json::Value.
+ */
+bool Parse(const char* begin, const char* end, Json::Value* root) {
+    const char* p = begin;
+    if (!s_parse_value(&p, end, root, 0)) {
+        return false;
+    }
+    return p == end;
+}
+
+} // namespace msgpack
+} // namespace uds
+} // namespace ic
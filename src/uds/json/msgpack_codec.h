@@ -0,0 +1,96 @@
+/**
+ * @file msgpack_codec.h
+ * @brief 二进制编解码(MessagePack格式的子集)，用于请求、响应的JSON部分.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-24
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_JSON_MSGPACK_CODEC_H_
+#define IC_UDS_JSON_MSGPACK_CODEC_H_
+#include <cstdint>
+#include <string>
+#include <jsoncpp/json/value.h>
+
+namespace ic {
+namespace uds {
+namespace msgpack {
+
+/**
+ * @brief 编码为MessagePack，追加到out末尾.
+ *
+ * @details 使用nil、bool、int、float64、str、array、map类型，整数使用能容纳该值的最短编码.
+ * @details 与json::Write一致，值为null的键被忽略.
+ *
+ * @param first_key 不为空时，顶层对象中的该键最先输出(便于不解码就能读取)，其余的键按字典序输出
+ */
+void Write(const Json::Value& value, std::string* out, const char* first_key = nullptr);
+
+/**
+ * @brief 解码MessagePack，直接构造Json::Value.
+ *
+ * @details 数值类型与json::Parse一致：负整数和不超过Int32最大值的整数为intValue，其他整数为uintValue.
+ * @details 另外接受float32(转换为realValue)和bin(转换为stringValue)，对象的键必须是str.
+ *
+ * @return 是否解码成功(必须恰好是一个完整的值)
+ */
+bool Parse(const char* begin, const char* end, Json::Value* root);
+
+/**
+ * @brief 写入单个值或者容器的头部(编码与Write一致)，用于直接编码结构体(typed_codec.h).
+ */
+void WriteNil(std::string* out);
+void WriteBool(bool value, std::string* out);
+void WriteInt(int64_t value, std::string* out);
+void WriteUint(uint64_t value, std::string* out);
+void WriteDouble(double value, std::string* out);
+void WriteString(const char* str, size_t len, std::string* out);
+void WriteMapHeader(size_t count, std::string* out);
+void WriteArrayHeader(size_t count, std::string* out);
+
+/**
+ * @brief 读取str类型的值(不复制).
+ *
+ * @param p [in,out] 当前位置，成功时移动到该值之后
+ */
+bool ReadString(const char** p, const char* end, const char** str, size_t* len);
+
+/**
+ * @brief 读取map类型的头部(成员数量).
+ */
+bool ReadMapHeader(const char** p, const char* end, uint32_t* count);
+
+/**
+ * @brief 读取array类型的头部(元素数量).
+ */
+bool ReadArrayHeader(const char** p, const char* end, uint32_t* count);
+
+/**
+ * @brief 下一个值为nil时跳过它并返回true.
+ */
+bool ReadNil(const char** p, const char* end);
+
+bool ReadBool(const char** p, const char* end, bool* value);
+
+/**
+ * @brief 读取整数(任意整数编码)，超出范围时返回false.
+ */
+bool ReadInt(const char** p, const char* end, int64_t* value);
+bool ReadUint(const char** p, const char* end, uint64_t* value);
+
+/**
+ * @brief 读取float32、float64或者整数.
+ */
+bool ReadDouble(const char** p, const char* end, double* value);
+
+/**
+ * @brief 跳过一个值.
+ */
+bool Skip(const char** p, const char* end);
+
+} // namespace msgpack
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_JSON_MSGPACK_CODEC_H_
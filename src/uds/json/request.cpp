@@ -1,13 +1,20 @@
 #include "request.h"
+#include <string.h>
+#include "msgpack_codec.h"
 
 namespace ic {
 namespace uds {
 
 std::string Request::Serialize(bool clear_body/* = false*/) {
-    json_[":path"] = path_;
+    json_[Json::StaticString(":path")] = path_;
     return Message::Serialize(clear_body);
 }
 
+void Request::Serialize(std::string* head, std::vector<std::string_view>* buffers) {
+    json_[Json::StaticString(":path")] = path_;
+    Message::Serialize(head, buffers);
+}
+
 bool Request::Deserialize(const std::string& data) {
     if (!Message::Deserialize(data)) {
         return false;
@@ -16,12 +23,123 @@ bool Request::Deserialize(const std::string& data) {
     if (!json_[":path"].isString()) {
         return false;
     }
-    path_ = json_[":path"].asString();
+    /* 直接复制到path_(复用已分配的内存)，不创建临时字符串 */
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    json_[":path"].getString(&begin, &end);
+    path_.assign(begin, end - begin);
     if (path_.empty()) {
         return false;
     }
     return true;
 }
 
+bool Request::DeserializeLazy(const std::string& data) {
+    std::string_view path;
+    if (!PeekPath(data, &path) || !Message::DeserializeLazy(data)) {
+        return false;
+    }
+    path_.assign(path.data(), path.length());
+    return true;
+}
+
+void Request::Reset(Server* svr, const sockaddr_un* client_addr, int64_t id) {
+    std::string path;
+    std::vector<Body> bodies;
+    path.swap(path_);
+    bodies.swap(bodies_);
+    *this = Request(svr, client_addr, id);
+    path.clear();
+    bodies.clear();
+    path_.swap(path);
+    bodies_.swap(bodies);
+}
+
+uint32_t Request::remaining_ms() const {
+    if (!has_deadline()) {
+        return UINT32_MAX;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline_) {
+        return 0;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline_ - now).count();
+    return ms > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(ms);
+}
+
+/**
+ * @brief 不解析JSON，快速读取序列化数据中的请求路径.
+ * 
+ * @details 序列化时JSON对象的键按字典序输出，":path"总是顶层对象的最后一个键，
+ *          即JSON串总是以 ,":path":"/xxx"} 结尾，从尾部向前查找即可.
+ * @details 二进制编码时":path"是顶层map的第一个键，直接读取.
+ */
+bool Request::PeekPath(const std::string& data, std::string_view* path) {
+    static const char kPathKey[] = "\":path\":\"";
+    static const size_t kPathKeyLength = sizeof(kPathKey) - 1;
+
+    size_t len = data.length();
+    if (len < 5) {
+        return false;
+    }
+    unsigned int length_field = *(unsigned int*)(data.c_str());
+    if (length_field & BINARY_ENVELOPE_FLAG) {
+        return PeekBinaryPath(data, length_field & ~BINARY_ENVELOPE_FLAG, path);
+    }
+    if (len < 16) {
+        return false;
+    }
+    size_t json_len = static_cast<size_t>(length_field);
+    if (json_len > 100000000 || json_len + 4 > len || json_len < kPathKeyLength + 4) {
+        return false;
+    }
+    const char* json_begin = data.c_str() + 4;
+    const char* json_end = json_begin + json_len;
+    if (json_end[-1] != '}' || json_end[-2] != '"') {
+        return false;
+    }
+    const char* value_end = json_end - 2;
+    const char* value_begin = value_end;
+    while (value_begin > json_begin && value_begin[-1] != '"') {
+        if (value_begin[-1] == '\\') {
+            return false;  /* 含有转义字符 */
+        }
+        --value_begin;
+    }
+    const char* key_begin = value_begin - kPathKeyLength;
+    if (key_begin <= json_begin || memcmp(key_begin, kPathKey, kPathKeyLength) != 0) {
+        return false;
+    }
+    if (key_begin[-1] != ',' && key_begin[-1] != '{') {
+        return false;
+    }
+    *path = std::string_view(value_begin, value_end - value_begin);
+    return !path->empty();
+}
+
+bool Request::PeekBinaryPath(const std::string& data, size_t json_len, std::string_view* path) {
+    if (json_len > 100000000 || json_len + 4 > data.length()) {
+        return false;
+    }
+    const char* p = data.c_str() + 4;
+    const char* end = p + json_len;
+    uint32_t count = 0;
+    const char* key = nullptr;
+    size_t key_len = 0;
+    if (!msgpack::ReadMapHeader(&p, end, &count) || count == 0 || !msgpack::ReadString(&p, end, &key, &key_len)) {
+        return false;
+    }
+    if (key_len != 5 || memcmp(key, ":path", 5) != 0) {
+        return false;
+    }
+    const char* value = nullptr;
+    size_t value_len = 0;
+    if (!msgpack::ReadString(&p, end, &value, &value_len)) {
+        return false;
+    }
+    *path = std::string_view(value, value_len);
+    return !path->empty();
+}
+
 } // namespace uds
 } // namespace ic
@@ -1,8 +1,14 @@
 #ifndef IC_UDS_JSON_REQUEST_H_
 #define IC_UDS_JSON_REQUEST_H_
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string_view>
 #include <sys/un.h>
 #include "message.h"
+#include "route_tree.h"
+#include "../base/priority.h"
 
 namespace ic {
 namespace uds {
@@ -11,12 +17,14 @@ class Route;
 class Router;
 class Server;
 class Client;
+class DeferredResponse;
 
 class Request : public Message {
 public:
     friend class Router;
     friend class Server;
     friend class Client;
+    friend class RequestBatcher;
     using tp = std::chrono::system_clock::time_point;
 
     Request() = default;
@@ -25,28 +33,120 @@ public:
         : Message(id), svr_(svr), client_addr_(client_addr) {}
 
 public:
+    /**
+     * @brief 指定请求ID(客户端)，通过 Client::NewRequestId() 获取，用于取消请求.
+     * 
+     * @details 未指定时每次发送自动分配新的请求ID.
+     */
+    using Message::set_id;
+
     const std::string& path() const { return path_; }
     void set_path(const std::string& path) { path_ = path; }
 
     const Route* route() const { return route_; }
 
+    /**
+     * @brief 路径参数，如路由 /user/:id 中的id，不存在时返回空.
+     * 
+     * @details 返回的数据指向请求路径，不复制.
+     */
+    std::string_view path_param(std::string_view name) const { return path_params_.Get(path_, name); }
+    const PathParams& path_params() const { return path_params_; }
+
     Server* svr() const { return svr_; }
     const sockaddr_un* client_addr() const { return client_addr_; }
 
     const tp& timepoint() const { return timepoint_; }
     void set_timepoint(const tp& timepoint) { timepoint_ = timepoint; }
 
+    /**
+     * @brief 优先级，随请求头部发送给服务端.
+     */
+    Priority priority() const { return priority_; }
+    void set_priority(Priority priority) { priority_ = priority; }
+
+    /**
+     * @brief 不解析JSON，快速读取序列化数据中的请求路径.
+     * 
+     * @details 返回的path指向data内部，data失效后不可再使用.
+     * @retval false 数据格式不符合预期，需要完整解析
+     */
+    static bool PeekPath(const std::string& data, std::string_view* path);
+
+private:
+    static bool PeekBinaryPath(const std::string& data, size_t json_len, std::string_view* path);
+
+public:
+
+    /**
+     * @brief 客户端的截止时间(服务端).
+     * 
+     * @details 超过截止时间后客户端不再接收响应，耗时的处理函数可据此提前结束.
+     */
+    bool has_deadline() const { return deadline_ != std::chrono::steady_clock::time_point::max(); }
+    const std::chrono::steady_clock::time_point& deadline() const { return deadline_; }
+    bool expired() const { return has_deadline() && std::chrono::steady_clock::now() >= deadline_; }
+
+    /**
+     * @brief 距离截止时间的剩余毫秒数，没有截止时间时返回UINT32_MAX.
+     */
+    uint32_t remaining_ms() const;
+
+    /**
+     * @brief 服务端收到完整请求的时间(服务端).
+     */
+    const std::chrono::steady_clock::time_point& receive_time() const { return receive_time_; }
+
+    /**
+     * @brief 客户端是否已取消该请求(服务端).
+     * 
+     * @details 耗时的处理函数可以定期检查，提前结束处理；已取消的请求不再返回响应.
+     */
+    bool cancelled() const { return cancel_flag_ && cancel_flag_->load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 延迟响应(服务端)，处理函数返回后不发送响应，之后通过返回的对象完成.
+     * 
+     * @details 用于等待其他服务、定时器等异步操作的处理函数，等待期间不占用工作线程.
+     *          处理函数中填写的res被忽略，响应由 DeferredResponse::response() 填写.
+     * @details 超过timeout_ms(为0时使用 Server::set_deferred_timeout_ms() 设置的值)
+     *          或者客户端的截止时间仍未完成时，返回Timeout.
+     * @details 请求(及其参数和数据体)在处理函数返回后释放，之后需要的数据应先复制或者通过 TakeBody() 取出.
+     * @details 多次调用返回同一个对象. 客户端取消请求后不再通知，完成时照常发送.
+     * 
+     * @return 不支持时(客户端、类型化路由)返回nullptr
+     */
+    std::shared_ptr<DeferredResponse> Defer(uint32_t timeout_ms = 0);
+    bool deferred() const { return deferred_ != nullptr; }
+
 protected:
     /**
      * @brief 序列化为字符串，用于发送.
      */
     std::string Serialize(bool clear_body = false);
 
+    /**
+     * @brief 序列化为多个片段，用于发送(数据体不复制).
+     */
+    void Serialize(std::string* head, std::vector<std::string_view>* buffers);
+
     /**
      * @brief 反序列化，解析字符串数据.
      */
     bool Deserialize(const std::string& data);
 
+    /**
+     * @brief 延迟反序列化，只读取请求路径，参数和数据体在处理函数第一次访问时才解析.
+     * 
+     * @retval false 数据格式不符合预期，需要调用 Deserialize() 完整解析
+     */
+    bool DeserializeLazy(const std::string& data);
+
+    /**
+     * @brief 重置为新的请求(工作线程复用同一个对象)，保留请求路径和数据体数组已分配的内存.
+     */
+    void Reset(Server* svr, const sockaddr_un* client_addr, int64_t id);
+
 private:
     Server* svr_{nullptr};
     const sockaddr_un* client_addr_{nullptr};
@@ -56,6 +156,11 @@ private:
      */
     const Route* route_{nullptr};
 
+    /**
+     * @brief 路径参数(在路径中的位置).
+     */
+    PathParams path_params_;
+
     /**
      * @brief 请求路径，如/User/GetInfo
      */
@@ -65,6 +170,43 @@ private:
      * @brief 请求时间戳.
      */
     tp timepoint_{std::chrono::system_clock::now()};
+
+    /**
+     * @brief 优先级.
+     */
+    Priority priority_{Priority::Normal};
+
+    /**
+     * @brief 客户端的截止时间.
+     */
+    std::chrono::steady_clock::time_point deadline_{std::chrono::steady_clock::time_point::max()};
+
+    /**
+     * @brief 服务端收到完整请求的时间.
+     */
+    std::chrono::steady_clock::time_point receive_time_;
+
+    /**
+     * @brief 取消标志.
+     */
+    const std::atomic_bool* cancel_flag_{nullptr};
+
+    /**
+     * @brief 延迟响应.
+     */
+    std::shared_ptr<DeferredResponse> deferred_;
+
+    /**
+     * @brief 响应缓存和合并请求的键(处理函数执行期间)，延迟响应完成时使用.
+     */
+    const std::string* key_{nullptr};
+    bool key_for_cache_{false};
+    bool key_for_single_flight_{false};
+
+    /**
+     * @brief 在接收线程上执行(RouteOptions::inline_execution).
+     */
+    bool inline_{false};
 };
 
 } // namespace uds
@@ -0,0 +1,141 @@
+#include "request_batcher.h"
+#include "deferred_response.h"
+#include "router.h"
+
+namespace ic {
+namespace uds {
+
+RequestBatcher::RequestBatcher(size_t max_size, uint32_t max_delay_us, BatchRequestHandler handler)
+    : max_size_(max_size ? max_size : 1), max_delay_(std::chrono::microseconds(max_delay_us)), handler_(handler)
+{
+    pending_.reserve(max_size_);
+}
+
+/**
+ * @brief 将请求加入批次.
+ * 
+ * @details 请求(及其参数和数据体)移入批次，不再引用接收缓冲区；原请求保留延迟响应，服务器不再发送响应.
+ * @details 加入空批次的请求向计时器登记提交时间，不等待；填满批次的请求取走批次并调用处理函数.
+ * @details 计时器已停止(服务器已释放)时立即提交.
+ */
+void RequestBatcher::Add(Request& req, Response& res) {
+    auto deferred = req.Defer();
+    if (!deferred) {
+        std::vector<BatchItem> batch{ BatchItem{ req, res } };
+        handler_(batch);
+        return;
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->client_addr = *req.client_addr();
+    entry->deferred = deferred;
+    req.Detach();
+    entry->req = std::move(req);
+    entry->req.client_addr_ = &entry->client_addr;
+    entry->req.cancel_flag_ = nullptr;
+    entry->req.key_ = nullptr;
+    req.deferred_ = std::move(deferred);
+
+    auto timer = req.deferred_->timer_;
+    std::vector<std::unique_ptr<Entry>> batch;
+    uint64_t generation = 0;
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        pending_.push_back(std::move(entry));
+        if (pending_.size() >= max_size_) {
+            batch.swap(pending_);
+            pending_.reserve(max_size_);
+            ++generation_;
+        }
+        else if (pending_.size() == 1) {
+            generation = generation_;
+            schedule = true;
+        }
+    }
+    if (!batch.empty()) {
+        Run(batch);
+        return;
+    }
+    if (schedule) {
+        std::weak_ptr<RequestBatcher> self = shared_from_this();
+        bool scheduled = timer->Schedule(clock::now() + max_delay_, [self, generation]{
+            if (auto batcher = self.lock()) {
+                try {
+                    batcher->Flush(generation);
+                }
+                catch (...) {
+                    /* 批次中的请求已经返回UnknownError */
+                }
+            }
+        });
+        if (!scheduled) {
+            Flush(generation);
+        }
+    }
+}
+
+/**
+ * @brief 提交等待超时的批次.
+ * 
+ * @details 批次已被填满的线程取走时(generation已变化)不做任何事.
+ */
+void RequestBatcher::Flush(uint64_t generation) {
+    std::vector<std::unique_ptr<Entry>> batch;
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        if (generation_ != generation || pending_.empty()) {
+            return;
+        }
+        batch.swap(pending_);
+        pending_.reserve(max_size_);
+        ++generation_;
+    }
+    Run(batch);
+}
+
+/**
+ * @brief 调用处理函数，然后发送各个响应.
+ * 
+ * @details 处理函数抛出异常时，批次中的请求都返回UnknownError.
+ */
+void RequestBatcher::Run(std::vector<std::unique_ptr<Entry>>& batch) {
+    std::vector<BatchItem> items;
+    items.reserve(batch.size());
+    for (auto& entry : batch) {
+        items.push_back(BatchItem{ entry->req, entry->deferred->response() });
+    }
+    try {
+        handler_(items);
+    }
+    catch (...) {
+        for (auto& entry : batch) {
+            entry->deferred->Complete(Response::Status::UnknownError);
+        }
+        throw;
+    }
+    for (auto& entry : batch) {
+        entry->deferred->Complete();
+    }
+}
+
+/**
+ * @brief 添加批处理路由，路由的处理函数将请求加入批次.
+ * 
+ * @details 在本文件中实现，不使用批处理路由的程序不链接延迟响应(及服务端).
+ */
+bool Router::AddBatchRoute(const std::string& path, const std::string& description, const RouteOptions& options, BatchRequestHandler handler) {
+    auto batcher = std::make_shared<RequestBatcher>(options.batch_max_size, options.batch_max_delay_us, handler);
+    /* 填满批次的线程调用处理函数，不能占用接收线程 */
+    RouteOptions batch_options = options;
+    batch_options.inline_execution = false;
+    return AddRoute(path, description, batch_options, [batcher](Request& req, Response& res){
+        batcher->Add(req, res);
+    });
+}
+
+bool Router::AddBatchRoute(const std::string& path, const std::string& description, BatchRequestHandler handler) {
+    return AddBatchRoute(path, description, RouteOptions(), handler);
+}
+
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,88 @@
+/**
+ * @file request_batcher.h
+ * @brief 将同一路由的请求合并为批次.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-30
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_JSON_REQUEST_BATCHER_H_
+#define IC_UDS_JSON_REQUEST_BATCHER_H_
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <sys/un.h>
+#include "request.h"
+#include "response.h"
+
+namespace ic {
+namespace uds {
+
+class DeferredResponse;
+
+/**
+ * @brief 批次中的一个请求及其响应.
+ */
+struct BatchItem {
+    Request& req;
+    Response& res;
+};
+
+using BatchRequestHandler = std::function<void(std::vector<BatchItem>& batch)>;
+
+/**
+ * @brief 将同一路由的请求合并为批次，一次调用处理函数.
+ * 
+ * @details 每个请求都通过 Request::Defer() 延迟响应，请求移入批次后工作线程立即返回；
+ *          批次填满(max_size)时由填满批次的线程调用处理函数，否则由延迟响应的计时器在
+ *          第一个请求加入max_delay_us后调用. 处理函数返回后各个响应按各自的请求ID发送.
+ */
+class RequestBatcher : public std::enable_shared_from_this<RequestBatcher> {
+public:
+    using clock = std::chrono::steady_clock;
+
+    RequestBatcher(size_t max_size, uint32_t max_delay_us, BatchRequestHandler handler);
+
+    /**
+     * @brief 将请求加入批次(作为路由的处理函数).
+     * 
+     * @details 不能延迟响应时(如没有服务器，直接调用 Router::HandleRequest())，单独处理该请求.
+     */
+    void Add(Request& req, Response& res);
+
+private:
+    struct Entry {
+        Request req;
+        sockaddr_un client_addr;
+        std::shared_ptr<DeferredResponse> deferred;
+    };
+
+    void Flush(uint64_t generation);
+    void Run(std::vector<std::unique_ptr<Entry>>& batch);
+
+private:
+    size_t max_size_;
+    clock::duration max_delay_;
+    BatchRequestHandler handler_;
+
+    std::mutex mutex_;
+
+    /**
+     * @brief 正在收集的批次.
+     */
+    std::vector<std::unique_ptr<Entry>> pending_;
+
+    /**
+     * @brief 每取走一个批次加1，计时器据此判断批次已被填满的线程取走.
+     */
+    uint64_t generation_{0};
+};
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_JSON_REQUEST_BATCHER_H_
@@ -4,14 +4,56 @@ namespace ic {
 namespace uds {
 
 std::string Response::Serialize(bool clear_body/* = false*/) {
-    json_[":status"] = (int)status_;
+    json_[Json::StaticString(":status")] = (int)status_;
+    if (max_age_ms_ > 0) {
+        json_[Json::StaticString(":max_age")] = max_age_ms_;
+    }
     return Message::Serialize(clear_body);
 }
 
+void Response::Serialize(std::string* head, std::vector<std::string_view>* buffers) {
+    json_[Json::StaticString(":status")] = (int)status_;
+    if (max_age_ms_ > 0) {
+        json_[Json::StaticString(":max_age")] = max_age_ms_;
+    }
+    Message::Serialize(head, buffers);
+}
+
 bool Response::Deserialize(const std::string& data) {
     if (!Message::Deserialize(data)) {
         return false;
     }
+    ParseStatus();
+    return true;
+}
+
+bool Response::Deserialize(std::string&& data) {
+    if (!Message::Deserialize(std::move(data))) {
+        return false;
+    }
+    ParseStatus();
+    return true;
+}
+
+bool Response::Deserialize(std::shared_ptr<const std::string> data) {
+    if (!Message::Deserialize(std::move(data))) {
+        return false;
+    }
+    ParseStatus();
+    return true;
+}
+
+void Response::Reset(int64_t id) {
+    std::vector<Body> bodies;
+    bodies.swap(bodies_);
+    *this = Response(id);
+    bodies.clear();
+    bodies_.swap(bodies);
+}
+
+void Response::ParseStatus() {
+    const Json::Value& max_age = json_.get(":max_age", Json::Value());
+    max_age_ms_ = max_age.isUInt() ? max_age.asUInt() : 0;
     int status_value = json_[":status"].asInt();
     switch (status_value) {
         case (int)Status::Success:
@@ -23,13 +65,15 @@ bool Response::Deserialize(const std::string& data) {
         case (int)Status::RecvFailed:
         case (int)Status::Timeout:
         case (int)Status::UnknownError:
+        case (int)Status::Overloaded:
+        case (int)Status::Cancelled:
+        case (int)Status::ChecksumMismatch:
             status_ = Status(status_value);
             break;
         default:
             status_ = Status::BadResponse;
             break;
     }
-    return true;
 }
 
 const char* Response::message() const {
@@ -42,6 +86,9 @@ const char* Response::message() const {
         case Status::SendFailed:   return "Send request failed";
         case Status::RecvFailed:   return "Receive response failed";
         case Status::Timeout:      return "Receive response timeout";
+        case Status::Overloaded:   return "Server overloaded";
+        case Status::Cancelled:    return "Request cancelled";
+        case Status::ChecksumMismatch: return "Checksum mismatch";
         case Status::UnknownError:
         default:                   return "(not recognized error)";
     }
@@ -14,6 +14,7 @@ public:
     friend class Server;
     friend class Client;
     friend class Router;
+    friend class DeferredResponse;
 
     enum class Status {
         Success = 0,
@@ -24,7 +25,10 @@ public:
         SendFailed,
         RecvFailed,
         Timeout,
-        UnknownError
+        UnknownError,
+        Overloaded,
+        Cancelled,
+        ChecksumMismatch
     };
 
     Response(int64_t id = -1) : Message(id) {}
@@ -35,6 +39,26 @@ public:
     const char* message() const;
     const Json::Value& data() const { return param(); }
 
+    /**
+     * @brief 服务端建议的重试间隔(毫秒)，仅status为Overloaded时有效.
+     */
+    uint32_t retry_after_ms() const { return retry_after_ms_; }
+
+    /**
+     * @brief 本次响应是否可以被缓存(仅对启用了响应缓存的路由有效)，默认可以.
+     */
+    bool cacheable() const { return cacheable_; }
+    void set_cacheable(bool cacheable) { cacheable_ = cacheable; }
+
+    /**
+     * @brief 客户端可以缓存本次响应的时长(毫秒)，0表示不缓存(默认).
+     * 
+     * @details 仅对启用了响应缓存的客户端(Client::EnableResponseCache)有效，
+     *          期间服务端可以通过 Server::InvalidateCache() 使其失效.
+     */
+    uint32_t max_age_ms() const { return max_age_ms_; }
+    void set_max_age_ms(uint32_t max_age_ms) { max_age_ms_ = max_age_ms; }
+
 protected:
     /**
      * @brief 设置状态码.
@@ -46,13 +70,39 @@ protected:
      */
     std::string Serialize(bool clear_body = false);
 
+    /**
+     * @brief 序列化为多个片段，用于发送(数据体不复制).
+     */
+    void Serialize(std::string* head, std::vector<std::string_view>* buffers);
+
     /**
      * @brief 解析接受到的请求.
      */
     bool Deserialize(const std::string& data);
 
+    /**
+     * @brief 解析接受到的请求，接管接收缓冲区(数据体不复制).
+     */
+    bool Deserialize(std::string&& data);
+
+    /**
+     * @brief 解析共享的响应数据(客户端缓存的响应).
+     */
+    bool Deserialize(std::shared_ptr<const std::string> data);
+
+    /**
+     * @brief 重置为新的响应(工作线程复用同一个对象)，保留数据体数组已分配的内存.
+     */
+    void Reset(int64_t id);
+
+private:
+    void ParseStatus();
+
 private:
     Status status_ = Status::BadRequest;
+    uint32_t retry_after_ms_ = 0;
+    bool cacheable_ = true;
+    uint32_t max_age_ms_ = 0;
 };
 
 } // namespace uds
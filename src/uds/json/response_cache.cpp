@@ -0,0 +1,139 @@
+#include "response_cache.h"
+#include "json_codec.h"
+#include "request.h"
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief FNV-1a哈希.
+ */
+static uint64_t s_hash(std::string_view key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+ResponseCache::ResponseCache(uint32_t ttl_ms, size_t max_entries)
+    : ttl_(ttl_ms), max_entries_per_shard_((max_entries + kShardCount - 1) / kShardCount)
+{
+    if (max_entries_per_shard_ == 0) {
+        max_entries_per_shard_ = 1;
+    }
+}
+
+std::string ResponseCache::MakeKey(const Request& req) {
+    std::string key = req.path();
+    key.push_back('\0');
+    key.push_back(req.binary() ? 'b' : 't');
+    json::Write(req.param(), &key);
+    return key;
+}
+
+/**
+ * @brief 查找缓存的响应.
+ */
+std::shared_ptr<const std::string> ResponseCache::Get(const std::string& key) {
+    uint64_t hash = s_hash(key);
+    Shard& shard = GetShard(hash);
+    std::lock_guard<std::mutex> lck(shard.mutex);
+    auto iter = shard.entries.find(hash);
+    if (iter == shard.entries.end() || iter->second.key != key) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Entry& entry = iter->second;
+    if (clock::now() >= entry.expire_time) {
+        shard.lru.erase(entry.lru_iter);
+        shard.entries.erase(iter);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_iter);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return entry.response;
+}
+
+/**
+ * @brief 添加或者替换缓存的响应.
+ *
+ * @details 分片已满时淘汰最久未使用的条目.
+ */
+void ResponseCache::Put(const std::string& key, std::shared_ptr<const std::string> response) {
+    Put(key, std::move(response), ttl_);
+}
+
+void ResponseCache::Put(const std::string& key, std::shared_ptr<const std::string> response, std::chrono::milliseconds ttl) {
+    uint64_t hash = s_hash(key);
+    Shard& shard = GetShard(hash);
+    std::lock_guard<std::mutex> lck(shard.mutex);
+    auto expire_time = clock::now() + ttl;
+    auto iter = shard.entries.find(hash);
+    if (iter != shard.entries.end()) {
+        Entry& entry = iter->second;
+        entry.key = key;
+        entry.response = std::move(response);
+        entry.expire_time = expire_time;
+        shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_iter);
+        return;
+    }
+    if (shard.entries.size() >= max_entries_per_shard_) {
+        shard.entries.erase(shard.lru.back());
+        shard.lru.pop_back();
+    }
+    shard.lru.push_front(hash);
+    Entry& entry = shard.entries[hash];
+    entry.key = key;
+    entry.response = std::move(response);
+    entry.expire_time = expire_time;
+    entry.lru_iter = shard.lru.begin();
+}
+
+/**
+ * @brief 移除路径以prefix开头的条目.
+ */
+size_t ResponseCache::RemovePrefix(std::string_view prefix) {
+    size_t count = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lck(shard.mutex);
+        auto iter = shard.entries.begin();
+        while (iter != shard.entries.end()) {
+            /* 键以路径开头，路径之后为'\0' */
+            if (iter->second.key.compare(0, prefix.length(), prefix) == 0) {
+                shard.lru.erase(iter->second.lru_iter);
+                iter = shard.entries.erase(iter);
+                ++count;
+            }
+            else {
+                ++iter;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 清空缓存.
+ */
+void ResponseCache::Clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lck(shard.mutex);
+        shard.entries.clear();
+        shard.lru.clear();
+    }
+}
+
+size_t ResponseCache::size() const {
+    size_t count = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lck(shard.mutex);
+        count += shard.entries.size();
+    }
+    return count;
+}
+
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,118 @@
+/**
+ * @file response_cache.h
+ * @brief 路由的响应缓存.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-27
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_JSON_RESPONSE_CACHE_H_
+#define IC_UDS_JSON_RESPONSE_CACHE_H_
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ic {
+namespace uds {
+
+class Request;
+
+/**
+ * @brief 响应缓存，缓存序列化后的响应.
+ *
+ * @details 按键的哈希值分片，每个分片一个互斥锁，分片内按最近使用的顺序淘汰.
+ * @details 条目超过有效期后不再返回(查找时检查).
+ * @details 服务端的路由和客户端(Client::EnableResponseCache)共用.
+ */
+class ResponseCache {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @param ttl_ms 有效期(毫秒)
+     * @param max_entries 最大条目数(所有分片合计)
+     */
+    ResponseCache(uint32_t ttl_ms, size_t max_entries);
+
+    /**
+     * @brief 服务端通知客户端缓存失效的主题，消息内容为路径前缀.
+     */
+    static constexpr const char* kInvalidationTopic = ":cache-invalidation";
+
+    /**
+     * @brief 请求对应的键：路径、编码方式、参数(键按字典序输出的紧凑JSON).
+     * 
+     * @details 以路径和'\0'开头，可以按路径前缀移除.
+     */
+    static std::string MakeKey(const Request& req);
+
+    /**
+     * @brief 查找缓存的响应.
+     *
+     * @return 未找到或者已过期时返回nullptr
+     */
+    std::shared_ptr<const std::string> Get(const std::string& key);
+
+    /**
+     * @brief 添加或者替换缓存的响应.
+     */
+    void Put(const std::string& key, std::shared_ptr<const std::string> response);
+
+    /**
+     * @brief 添加或者替换缓存的响应，指定有效期.
+     */
+    void Put(const std::string& key, std::shared_ptr<const std::string> response, std::chrono::milliseconds ttl);
+
+    /**
+     * @brief 移除路径以prefix开头的条目.
+     * 
+     * @return 移除的条目数量
+     */
+    size_t RemovePrefix(std::string_view prefix);
+
+    /**
+     * @brief 清空缓存.
+     */
+    void Clear();
+
+    size_t size() const;
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    static const size_t kShardCount = 16;
+
+    struct Entry {
+        std::string key;  /* 完整的键，哈希冲突时以此区分 */
+        std::shared_ptr<const std::string> response;
+        clock::time_point expire_time;
+        std::list<uint64_t>::iterator lru_iter;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Entry> entries;
+        std::list<uint64_t> lru;  /* 最近使用的在前 */
+    };
+
+    Shard& GetShard(uint64_t hash) { return shards_[hash % kShardCount]; }
+
+private:
+    std::chrono::milliseconds ttl_;
+    size_t max_entries_per_shard_;
+    Shard shards_[kShardCount];
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_JSON_RESPONSE_CACHE_H_
@@ -0,0 +1,262 @@
+#include "route_tree.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief 查找参数值.
+ */
+std::string_view PathParams::Get(std::string_view path, std::string_view name) const {
+    for (size_t i = 0; i < count_; ++i) {
+        if (params_[i].name == name) {
+            return path.substr(params_[i].offset, params_[i].length);
+        }
+    }
+    return std::string_view();
+}
+
+void PathParams::Push(std::string_view name, size_t offset, size_t length) {
+    Param& param = params_[count_++];
+    param.name = name;
+    param.offset = static_cast<uint32_t>(offset);
+    param.length = static_cast<uint32_t>(length);
+}
+
+/**
+ * @brief 路由树的节点.
+ */
+struct RouteTree::Node {
+    ~Node() {
+        for (Node* child : children) {
+            delete child;
+        }
+        delete param_child;
+        delete wildcard_child;
+    }
+
+    /**
+     * @brief 静态节点：压缩后的路径片段；参数、通配符节点：参数名.
+     */
+    std::string prefix;
+
+    /**
+     * @brief 各静态子节点路径片段的首字符，与children一一对应.
+     */
+    std::string indices;
+    std::vector<Node*> children;
+
+    Node* param_child{nullptr};
+    Node* wildcard_child{nullptr};
+
+    /**
+     * @brief 在此结束的路由.
+     */
+    const Route* route{nullptr};
+};
+
+/**
+ * @brief 是否为参数或者通配符的起始位置(位于路径段的开头).
+ */
+static inline bool s_is_param_start(std::string_view path, size_t pos) {
+    return (path[pos] == ':' || path[pos] == '*') && pos > 0 && path[pos - 1] == '/';
+}
+
+/**
+ * @brief 查找首字符为c的静态子节点，子节点一般只有几个，顺序查找.
+ */
+static inline size_t s_find_index(const std::string& indices, char c) {
+    for (size_t i = 0, n = indices.length(); i < n; ++i) {
+        if (indices[i] == c) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+/**
+ * @brief 检查路径格式.
+ */
+static bool s_check_path(const std::string& path) {
+    if (path.empty() || path[0] != '/') {
+        return false;
+    }
+    size_t params_count = 0;
+    for (size_t pos = 1; pos < path.length(); ++pos) {
+        if (!s_is_param_start(path, pos)) {
+            continue;
+        }
+        size_t end = path.find('/', pos);
+        if (end == std::string::npos) {
+            end = path.length();
+        }
+        if (end == pos + 1) {
+            return false;  /* 参数名为空 */
+        }
+        if (path[pos] == '*' && end != path.length()) {
+            return false;  /* 通配符只能在末尾 */
+        }
+        if (++params_count > PathParams::kMaxCount) {
+            return false;
+        }
+        pos = end;
+    }
+    return true;
+}
+
+RouteTree::RouteTree() {
+    root_ = new Node();
+}
+
+RouteTree::~RouteTree() {
+    delete root_;
+}
+
+/**
+ * @brief 添加路由.
+ *
+ * @details 静态片段与已有子节点只有部分公共前缀时，拆分该子节点.
+ */
+bool RouteTree::Insert(const std::string& path, const Route* route) {
+    if (!s_check_path(path)) {
+        return false;
+    }
+    Node* node = root_;
+    size_t pos = 0, len = path.length();
+    while (pos < len) {
+        if (s_is_param_start(path, pos)) {
+            size_t end = path.find('/', pos);
+            if (end == std::string::npos) {
+                end = len;
+            }
+            std::string_view name(path.data() + pos + 1, end - pos - 1);
+            Node*& child = (path[pos] == ':') ? node->param_child : node->wildcard_child;
+            if (!child) {
+                child = new Node();
+                child->prefix = std::string(name);
+            }
+            else if (child->prefix != name) {
+                fprintf(stderr, "Conflicting path parameter. path=%s, existing=%s\n", path.c_str(), child->prefix.c_str());
+                return false;
+            }
+            node = child;
+            pos = end;
+            continue;
+        }
+
+        /* 静态片段，直到下一个参数 */
+        size_t end = pos + 1;
+        while (end < len && !s_is_param_start(path, end)) {
+            ++end;
+        }
+        std::string_view text(path.data() + pos, end - pos);
+        size_t index = s_find_index(node->indices, text[0]);
+        if (index == std::string::npos) {
+            Node* child = new Node();
+            child->prefix = std::string(text);
+            node->indices.push_back(text[0]);
+            node->children.push_back(child);
+            node = child;
+            pos = end;
+            continue;
+        }
+        Node* child = node->children[index];
+        size_t common = 0, max_common = std::min(child->prefix.length(), text.length());
+        while (common < max_common && child->prefix[common] == text[common]) {
+            ++common;
+        }
+        if (common < child->prefix.length()) {
+            Node* middle = new Node();
+            middle->prefix = child->prefix.substr(0, common);
+            child->prefix.erase(0, common);
+            middle->indices.push_back(child->prefix[0]);
+            middle->children.push_back(child);
+            node->children[index] = middle;
+            child = middle;
+        }
+        node = child;
+        pos += common;
+    }
+    if (node->route) {
+        return false;
+    }
+    node->route = route;
+    return true;
+}
+
+/**
+ * @brief 查找路由.
+ */
+const Route* RouteTree::Find(std::string_view path, PathParams* params) const {
+    PathParams local_params;
+    if (!params) {
+        params = &local_params;
+    }
+    params->Clear();
+    return Match(root_, path, 0, params);
+}
+
+/**
+ * @brief 从node开始匹配path[pos, end).
+ *
+ * @details 静态子节点匹配失败时回退，再尝试参数、通配符.
+ */
+const Route* RouteTree::Match(const Node* node, std::string_view path, size_t pos, PathParams* params) {
+    const char* data = path.data();
+    size_t len = path.length();
+
+    /* 静态路径，没有参数、通配符子节点时不需要回退，直接向下查找 */
+    while (true) {
+        if (pos == len) {
+            if (node->route) {
+                return node->route;
+            }
+            break;
+        }
+        size_t index = s_find_index(node->indices, data[pos]);
+        if (index == std::string::npos) {
+            break;
+        }
+        const Node* child = node->children[index];
+        size_t prefix_len = child->prefix.length();
+        if (len - pos < prefix_len || memcmp(data + pos, child->prefix.data(), prefix_len) != 0) {
+            break;
+        }
+        if (!node->param_child && !node->wildcard_child) {
+            node = child;
+            pos += prefix_len;
+            continue;
+        }
+        const Route* route = Match(child, path, pos + prefix_len, params);
+        if (route) {
+            return route;
+        }
+        break;
+    }
+
+    /* 参数，匹配一个非空的路径段 */
+    if (node->param_child && pos < len && path[pos] != '/') {
+        size_t end = path.find('/', pos);
+        if (end == std::string_view::npos) {
+            end = len;
+        }
+        params->Push(node->param_child->prefix, pos, end - pos);
+        const Route* route = Match(node->param_child, path, end, params);
+        if (route) {
+            return route;
+        }
+        params->Pop();
+    }
+
+    /* 通配符，匹配剩余的所有字符 */
+    if (node->wildcard_child && node->wildcard_child->route) {
+        params->Push(node->wildcard_child->prefix, pos, len - pos);
+        return node->wildcard_child->route;
+    }
+    return nullptr;
+}
+
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,104 @@
+/**
+ * @file route_tree.h
+ * @brief 路由树(压缩前缀树)，支持路径参数和通配符.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-26
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_JSON_ROUTE_TREE_H_
+#define IC_UDS_JSON_ROUTE_TREE_H_
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ic {
+namespace uds {
+
+class Route;
+
+/**
+ * @brief 路径参数，如路由 /user/:id 中的id，通配符 /static/*file 中的file.
+ *
+ * @details 固定容量，只记录参数值在请求路径中的位置，不分配内存.
+ */
+class PathParams {
+public:
+    /**
+     * @brief 单个路由最多的参数数量.
+     */
+    static const size_t kMaxCount = 8;
+
+    struct Param {
+        std::string_view name;  /* 指向路由树中的参数名 */
+        uint32_t offset;        /* 参数值在请求路径中的偏移 */
+        uint32_t length;        /* 参数值的长度 */
+    };
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    const Param& operator[](size_t index) const { return params_[index]; }
+
+    /**
+     * @brief 查找参数值.
+     *
+     * @param path 请求路径
+     * @return 不存在时返回空
+     */
+    std::string_view Get(std::string_view path, std::string_view name) const;
+
+    void Push(std::string_view name, size_t offset, size_t length);
+    void Pop() { --count_; }
+    void Clear() { count_ = 0; }
+
+private:
+    Param params_[kMaxCount];
+    size_t count_{0};
+};
+
+/**
+ * @brief 路由树.
+ *
+ * @details 静态部分按公共前缀压缩，每个节点按首字符查找子节点，匹配的时间复杂度与路径长度成正比.
+ * @details 路径格式：
+ *          静态路径    /user/GetInfo
+ *          参数       /user/:id/profile   (匹配一个路径段，不含'/')
+ *          通配符     /static/*file       (匹配剩余的所有字符，只能在末尾)
+ * @details 同一位置优先匹配静态路径，其次是参数，最后是通配符.
+ */
+class RouteTree {
+public:
+    RouteTree();
+    ~RouteTree();
+    RouteTree(const RouteTree&) = delete;
+    RouteTree& operator=(const RouteTree&) = delete;
+
+    /**
+     * @brief 添加路由.
+     *
+     * @retval false 路径格式错误、路由已存在，或者同一位置的参数名不一致
+     */
+    bool Insert(const std::string& path, const Route* route);
+
+    /**
+     * @brief 查找路由.
+     *
+     * @param params [out] 路径参数，可以为空
+     * @return 未找到时返回nullptr
+     */
+    const Route* Find(std::string_view path, PathParams* params) const;
+
+private:
+    struct Node;
+    static const Route* Match(const Node* node, std::string_view path, size_t pos, PathParams* params);
+
+private:
+    Node* root_{nullptr};
+};
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_JSON_ROUTE_TREE_H_
@@ -1,45 +1,444 @@
 #include "router.h"
 #include "request.h"
 #include "response.h"
+#include "json_codec.h"
+#include <thread>
 
 namespace ic {
 namespace uds {
 
+/**
+ * @brief 路由表(发布后不再修改).
+ */
+struct Router::RouteTable {
+    /**
+     * @brief 添加路由.
+     */
+    bool Add(const std::shared_ptr<Route>& route) {
+        if (!tree.Insert(route->path, route.get())) {
+            return false;
+        }
+        routes.push_back(route);
+        if (route->options.priority) {
+            has_priority_routes = true;
+        }
+        if (route->typed_handler) {
+            has_typed_routes = true;
+        }
+        if (route->options.inline_execution) {
+            has_inline_routes = true;
+        }
+        return true;
+    }
+
+    RouteTree tree;
+
+    /**
+     * @brief 路由由各个路由表共享，最后一个引用它的路由表释放时才释放.
+     */
+    std::vector<std::shared_ptr<Route>> routes;
+    bool has_priority_routes{false};
+    bool has_typed_routes{false};
+    bool has_inline_routes{false};
+};
+
+/**
+ * @brief 读取路由表期间占用一个槽位，阻止当前路由表被释放.
+ * 
+ * @details 先在槽位中记录当前纪元，再读取路由表；写入方替换路由表后纪元加1，
+ *          只有所有槽位都空闲或者纪元更大时，才释放被替换的路由表.
+ * @details 每个线程从固定的槽位开始查找，线程数不超过槽位数量时一般不会冲突.
+ * @details 所有槽位都被占用时(同时读取的线程超过kReaderSlots，如处理函数耗时较长、线程池很大)不等待，
+ *          改为增加溢出计数：溢出计数不为0期间不释放任何被替换的路由表，之后替换路由表时再释放.
+ */
+class Router::ReadGuard {
+public:
+    explicit ReadGuard(const Router* router) : router_(router) {
+        static thread_local size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+        size_t index = hint % kReaderSlots;
+        for (size_t i = 0; i < kReaderSlots; ++i) {
+            uint64_t epoch = router->epoch_.load();
+            uint64_t expected = 0;
+            if (router->reader_slots_[index].epoch.compare_exchange_strong(expected, epoch)) {
+                slot_ = &router->reader_slots_[index];
+                break;
+            }
+            index = (index + 1) % kReaderSlots;
+        }
+        if (!slot_) {
+            router->overflow_readers_.fetch_add(1);
+        }
+        table_ = router->table_.load();
+    }
+
+    ~ReadGuard() {
+        if (slot_) {
+            slot_->epoch.store(0, std::memory_order_release);
+        }
+        else {
+            router_->overflow_readers_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    const RouteTable* table() const { return table_; }
+
+private:
+    const Router* router_;
+    ReaderSlot* slot_{nullptr};
+    const RouteTable* table_;
+};
+
+/**
+ * @brief 在接收线程上执行的处理函数超过时间限制时计数，连续多次超过后路由暂时改回在线程池中执行.
+ * 
+ * @details 偶尔一次超时(如被调度出去)不影响，未超过时计数清零.
+ */
+static void s_check_inline_budget(const Route* route, const std::chrono::steady_clock::time_point& start) {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+    if (elapsed <= route->options.inline_budget_us) {
+        route->inline_overruns.store(0, std::memory_order_relaxed);
+        return;
+    }
+    uint32_t overruns = route->inline_overruns.fetch_add(1) + 1;
+    if (overruns >= Route::kInlineOverrunLimit) {
+        auto until = now + std::chrono::milliseconds(Route::kInlineCooldownMs);
+        route->inline_demoted_until.store(std::chrono::duration_cast<std::chrono::nanoseconds>(until.time_since_epoch()).count(), std::memory_order_relaxed);
+        route->inline_overruns.store(0, std::memory_order_relaxed);
+        fprintf(stderr, "Route exceeded inline budget, moved to thread pool for %ums. path=%s, elapsed=%ldus, budget=%uus\n",
+            Route::kInlineCooldownMs, route->path.c_str(), static_cast<long>(elapsed), route->options.inline_budget_us);
+    }
+}
+
+/**
+ * @brief 是否在接收线程上执行，超过时间限制被改回线程池时，冷却期过后恢复.
+ */
+bool Route::inline_enabled() const {
+    if (!options.inline_execution) {
+        return false;
+    }
+    int64_t until = inline_demoted_until.load(std::memory_order_relaxed);
+    if (until == 0) {
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count() >= until;
+}
+
 Router::Router(Server* server/* = nullptr*/)
     : svr_(server)
 {
+    table_ = new RouteTable();
 }
 
 Router::~Router() {
-    for (auto iter = routes_.begin(); iter != routes_.end(); ++iter) {
-        delete iter->second;
+    delete table_.load();
+    for (auto& item : retired_tables_) {
+        delete item.second;
     }
 }
 
 bool Router::AddRoute(const std::string& path, const std::string& description, RequestHandler handler) {
-    auto iter = routes_.find(path);
-    if (iter != routes_.end()) {
-        fprintf(stderr, "Duplicate route. path=%s\n", path.c_str());
+    return AddRoute(path, description, RouteOptions(), handler);
+}
+
+bool Router::AddRoute(const std::string& path, RequestHandler handler) {
+    return AddRoute(path, "", handler);
+}
+
+bool Router::AddRoute(const std::string& path, const std::string& description, const RouteOptions& options, RequestHandler handler) {
+    return AddRoute(std::make_shared<Route>(path, description, options, handler));
+}
+
+/**
+ * @brief 添加路由.
+ * 
+ * @details 复制当前路由表并添加新路由，然后发布新的路由表.
+ */
+bool Router::AddRoute(const std::shared_ptr<Route>& route) {
+    std::lock_guard<std::mutex> lck(write_mutex_);
+    if (route->options.cache_ttl_ms > 0) {
+        route->cache = std::make_shared<ResponseCache>(route->options.cache_ttl_ms, route->options.cache_max_entries);
+    }
+    if (route->options.single_flight) {
+        route->single_flight = std::make_shared<SingleFlight>();
+    }
+    RouteTable* table = new RouteTable();
+    for (auto& item : table_.load()->routes) {
+        table->Add(item);
+    }
+    if (!table->Add(route)) {
+        fprintf(stderr, "Duplicate or invalid route. path=%s\n", route->path.c_str());
+        delete table;
         return false;
     }
-    Route* route = new Route(path, description, handler);
-    routes_.emplace(path, route);
+    Publish(table);
     return true;
 }
 
-bool Router::AddRoute(const std::string& path, RequestHandler handler) {
-    return AddRoute(path, "", handler);
+/**
+ * @brief 移除路由.
+ */
+bool Router::RemoveRoute(const std::string& path) {
+    std::lock_guard<std::mutex> lck(write_mutex_);
+    RouteTable* table = new RouteTable();
+    bool found = false;
+    for (auto& item : table_.load()->routes) {
+        if (item->path == path) {
+            found = true;
+        }
+        else {
+            table->Add(item);
+        }
+    }
+    if (!found) {
+        delete table;
+        return false;
+    }
+    Publish(table);
+    return true;
+}
+
+/**
+ * @brief 发布新的路由表，已调用者持有write_mutex_.
+ */
+void Router::Publish(RouteTable* table) {
+    RouteTable* old_table = table_.exchange(table);
+    has_priority_routes_.store(table->has_priority_routes, std::memory_order_relaxed);
+    has_typed_routes_.store(table->has_typed_routes, std::memory_order_relaxed);
+    has_inline_routes_.store(table->has_inline_routes, std::memory_order_relaxed);
+    uint64_t epoch = epoch_.fetch_add(1);
+    retired_tables_.emplace_back(epoch, old_table);
+    Reclaim();
+}
+
+/**
+ * @brief 释放不再被读取的路由表，调用者持有write_mutex_.
+ * 
+ * @details 被替换时纪元为e的路由表，只可能被槽位纪元不超过e的线程读取.
+ * @details 有溢出的读取方时不释放，留到之后替换路由表时.
+ */
+void Router::Reclaim() {
+    /* 溢出的读取方没有记录纪元，可能读取任何一个被替换的路由表 */
+    if (overflow_readers_.load() > 0) {
+        return;
+    }
+    uint64_t min_epoch = UINT64_MAX;
+    for (auto& slot : reader_slots_) {
+        uint64_t epoch = slot.epoch.load();
+        if (epoch != 0 && epoch < min_epoch) {
+            min_epoch = epoch;
+        }
+    }
+    auto iter = retired_tables_.begin();
+    while (iter != retired_tables_.end()) {
+        if (iter->first < min_epoch) {
+            delete iter->second;
+            iter = retired_tables_.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
+}
+
+const Route* Router::FindRoute(std::string_view path, PathParams* params/* = nullptr*/) const {
+    ReadGuard guard(this);
+    return guard.table()->tree.Find(path, params);
+}
+
+bool Router::FindRouteOptions(std::string_view path, RouteOptions* options) const {
+    ReadGuard guard(this);
+    const Route* route = guard.table()->tree.Find(path, nullptr);
+    if (!route) {
+        return false;
+    }
+    *options = route->options;
+    return true;
+}
+
+bool Router::Classify(std::string_view path, DispatchInfo* info) const {
+    ReadGuard guard(this);
+    const Route* route = guard.table()->tree.Find(path, nullptr);
+    if (!route) {
+        return false;
+    }
+    if (route->options.priority) {
+        info->priority = *route->options.priority;
+    }
+    info->inline_execution = route->inline_enabled();
+    return true;
 }
 
+/**
+ * @brief 移除各路由缓存的响应中路径以prefix开头的条目.
+ */
+size_t Router::InvalidateCaches(std::string_view prefix) {
+    ReadGuard guard(this);
+    size_t count = 0;
+    for (auto& route : guard.table()->routes) {
+        if (route->cache) {
+            count += route->cache->RemovePrefix(prefix);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 处理请求.
+ * 
+ * @details 处理函数执行期间占用读取槽位，期间被移除的路由不会被释放.
+ */
 void Router::HandleRequest(Request& req, Response& res) {
-    auto iter = routes_.find(req.path());
-    if (iter != routes_.end()) {
-        req.route_ = iter->second;
-        iter->second->handler(req, res);
-        res.set_status(Response::Status::Success);
+    HandleRequest(req, res, nullptr);
+}
+
+/**
+ * @brief 处理请求.
+ * 
+ * @details 路由启用了响应缓存时，先查找缓存，命中时不执行处理函数；
+ *          未命中时执行处理函数并序列化响应，然后加入缓存.
+ * @details 路由启用了合并请求时，已有相同的请求正在处理则只登记，由该请求发送响应；
+ *          相同的请求在本请求收到之后已经完成时，直接使用其响应.
+ * @details 序列化在占用读取槽位期间进行，此时路由(及其缓存)不会被释放.
+ */
+void Router::HandleRequest(Request& req, Response& res, HandleResult* result) {
+    ReadGuard guard(this);
+    const Route* route = guard.table()->tree.Find(req.path(), &req.path_params_);
+    if (!route) {
+        HandleInvalidPath(req, res);
+        return;
+    }
+    req.route_ = route;
+
+    /* 类型化路由：参数已被解析(消息不是严格的格式时)，重新写为JSON后解码 */
+    if (route->typed_handler) {
+        std::string param;
+        if (!req.param().isNull()) {
+            json::Write(req.param(), &param);
+        }
+        const char* begin = param.empty() ? nullptr : param.data();
+        HandleTypedRoute(route, req, res, begin, begin + param.length(), false, result);
+        return;
+    }
+
+    /* 未启用缓存和合并请求时不访问数据体(延迟解析时不必解析) */
+    bool keyed = result && (route->cache || route->single_flight) && req.bodies().empty();
+    ResponseCache* cache = keyed ? route->cache.get() : nullptr;
+    SingleFlight* flight = (keyed && req.client_addr()) ? route->single_flight.get() : nullptr;
+    std::string key;
+    if (cache || flight) {
+        key = ResponseCache::MakeKey(req);
+    }
+    if (cache) {
+        auto cached = cache->Get(key);
+        if (cached) {
+            result->serialized = std::move(cached);
+            return;
+        }
+    }
+    if (flight) {
+        auto join_result = flight->Join(key, *req.client_addr(), req.id(), req.receive_time(), &result->serialized);
+        if (join_result == SingleFlight::JoinResult::Waiting) {
+            result->joined = true;
+            return;
+        }
+        else if (join_result == SingleFlight::JoinResult::Completed) {
+            return;
+        }
+    }
+
+    /* 处理函数调用 Request::Defer() 时，延迟响应需要在完成时加入缓存、结束进行中的请求 */
+    req.key_ = (cache || flight) ? &key : nullptr;
+    req.key_for_cache_ = cache != nullptr;
+    req.key_for_single_flight_ = flight != nullptr;
+    auto start = req.inline_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    try {
+        route->handler(req, res);
+    }
+    catch (...) {
+        req.key_ = nullptr;
+        /* 合并到本请求的其他请求不再等待本请求的响应，由调用方返回UnknownError */
+        if (flight && !req.deferred_) {
+            result->waiters = flight->Leave(key, nullptr);
+        }
+        throw;
+    }
+    req.key_ = nullptr;
+    if (req.inline_) {
+        s_check_inline_budget(route, start);
+    }
+    if (req.deferred_) {
+        if (result) {
+            result->deferred = true;
+        }
+        return;
+    }
+    res.set_status(Response::Status::Success);
+
+    bool cacheable = cache && res.cacheable() && res.bodies().empty() && !req.cancelled();
+    if (cacheable || flight) {
+        result->serialized = std::make_shared<const std::string>(res.Serialize());
+    }
+    /* 先加入缓存再结束进行中的请求，之后到达的相同请求可以命中缓存 */
+    if (cacheable) {
+        cache->Put(key, result->serialized);
+    }
+    if (flight) {
+        result->waiters = flight->Leave(key, result->serialized);
+    }
+}
+
+/**
+ * @brief 处理类型化路由的请求.
+ * 
+ * @details 只查找":param"，不解析消息的其他部分；请求路径通过 Request::PeekPath() 读取.
+ */
+bool Router::HandleTypedRequest(Request& req, Response& res, const std::string& data, HandleResult* result) {
+    std::string_view path;
+    if (!Request::PeekPath(data, &path)) {
+        return false;
+    }
+    ReadGuard guard(this);
+    PathParams params;
+    const Route* route = guard.table()->tree.Find(path, &params);
+    if (!route || !route->typed_handler) {
+        return false;
+    }
+    typed::Envelope envelope;
+    if (!typed::ScanEnvelope(data, &envelope)) {
+        return false;
+    }
+    req.path_.assign(path.data(), path.length());
+    req.path_params_ = params;
+    req.route_ = route;
+    req.set_binary(envelope.binary);
+    res.set_binary(envelope.binary);
+    HandleTypedRoute(route, req, res, envelope.param_begin, envelope.param_end, envelope.binary, result);
+    return true;
+}
+
+/**
+ * @brief 调用类型化路由的处理函数，调用者持有读取槽位.
+ * 
+ * @details 响应已序列化，result为空时解析到res中.
+ */
+void Router::HandleTypedRoute(const Route* route, Request& req, Response& res, const char* begin, const char* end, bool binary, HandleResult* result) {
+    std::string response;
+    auto start = req.inline_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    bool ok = route->typed_handler(req, begin, end, binary, &response);
+    if (req.inline_) {
+        s_check_inline_budget(route, start);
+    }
+    if (!ok) {
+        HandleBadRequest(req, res);
+        return;
+    }
+    if (result) {
+        result->serialized = std::make_shared<const std::string>(std::move(response));
     }
     else {
-        HandleInvalidPath(req, res);
+        res.Deserialize(std::move(response));
     }
 }
 
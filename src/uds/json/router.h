@@ -9,9 +9,22 @@
  */
 #ifndef IC_UDS_JSON_ROUTER_H_
 #define IC_UDS_JSON_ROUTER_H_
+#include <atomic>
 #include <functional>
-#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
+#include "request.h"
+#include "request_batcher.h"
+#include "response_cache.h"
+#include "route_tree.h"
+#include "single_flight.h"
+#include "typed_codec.h"
+#include "../base/base_server.h"
+#include "../base/priority.h"
 
 namespace ic {
 namespace uds {
@@ -22,6 +35,67 @@ class Server;
 
 using RequestHandler = std::function<void(Request& req, Response& res)>;
 
+/**
+ * @brief 类型化路由的处理函数，参数和响应为声明了字段(IC_UDS_FIELDS)的结构体.
+ */
+template <typename In, typename Out>
+using TypedRequestHandler = std::function<void(Request& req, const In& in, Out& out)>;
+
+/**
+ * @brief 路由选项.
+ */
+struct RouteOptions {
+    /**
+     * @brief 优先级.
+     * 
+     * @details 设置后覆盖客户端请求头部携带的优先级，在请求进入线程池之前生效.
+     */
+    std::optional<Priority> priority;
+
+    /**
+     * @brief 响应缓存的有效期(毫秒)，0表示不缓存.
+     * 
+     * @details 仅用于幂等的路由：路径和参数相同的请求在有效期内直接返回缓存的响应，
+     *          不执行处理函数，也不重新序列化. 携带数据体的请求不使用缓存.
+     * @details 处理函数可以调用 res.set_cacheable(false) 使本次响应不被缓存(如错误响应).
+     */
+    uint32_t cache_ttl_ms{0};
+
+    /**
+     * @brief 响应缓存的最大条目数.
+     */
+    size_t cache_max_entries{1024};
+
+    /**
+     * @brief 合并相同的进行中请求(路径和参数相同).
+     * 
+     * @details 只有第一个请求执行处理函数，其他请求不占用工作线程等待，
+     *          处理完成后同一份序列化的响应发送给所有请求. 携带数据体的请求不合并.
+     * @details 第一个请求被取消时，其他请求仍然收到响应，处理函数不应因取消而返回不完整的结果.
+     */
+    bool single_flight{false};
+
+    /**
+     * @brief 批次的最大请求数(Router::AddBatchRoute).
+     */
+    size_t batch_max_size{64};
+
+    /**
+     * @brief 批次中的第一个请求最多等待的时间(微秒)，超过后即使批次未填满也调用处理函数.
+     */
+    uint32_t batch_max_delay_us{1000};
+
+    /**
+     * @brief 在接收线程上直接执行处理函数，不进入线程池.
+     * 
+     * @details 只用于很快的路由(健康检查、读取内存中的计数等)，省去入队和唤醒工作线程的开销；
+     *          执行期间服务端不接收其他请求. 压缩的请求仍在线程池中执行，批处理路由忽略该选项.
+     * @details 处理函数的耗时连续多次超过inline_budget_us后，路由改回在线程池中执行，冷却一段时间后再次尝试在接收线程上执行.
+     */
+    bool inline_execution{false};
+    uint32_t inline_budget_us{50};
+};
+
 class Route {
 public:
     Route() = default;
@@ -29,11 +103,55 @@ public:
         : path(path), handler(handler) {}
     Route(const std::string& path, const std::string& description, RequestHandler handler)
         : path(path), description(description), handler(handler) {}
-    RequestHandler handler;
+    Route(const std::string& path, const std::string& description, const RouteOptions& options, RequestHandler handler)
+        : path(path), description(description), options(options), handler(handler) {}
     std::string path;
     std::string description;
+    RouteOptions options;
+    RequestHandler handler;
+
+    /**
+     * @brief 响应缓存，options.cache_ttl_ms不为0时由Router创建.
+     */
+    std::shared_ptr<ResponseCache> cache;
+
+    /**
+     * @brief 进行中的请求，options.single_flight为true时由Router创建.
+     */
+    std::shared_ptr<SingleFlight> single_flight;
+
+    /**
+     * @brief 类型化路由(Router::AddRoute<In, Out>)的处理函数，直接从请求数据解码参数，返回序列化后的响应.
+     * 
+     * @details [begin, end)为":param"的值(binary表示MessagePack编码)，没有参数时为空.
+     * @return false 参数与类型不符
+     */
+    std::function<bool(Request& req, const char* begin, const char* end, bool binary, std::string* response)> typed_handler;
+
+    /**
+     * @brief 在接收线程上执行时连续超过options.inline_budget_us的次数，未超过时清零.
+     * 
+     * @details 达到kInlineOverrunLimit后改回在线程池中执行，kInlineCooldownMs毫秒后再次尝试在接收线程上执行.
+     */
+    mutable std::atomic<uint32_t> inline_overruns{0};
+    static const uint32_t kInlineOverrunLimit = 3;
+    static const uint32_t kInlineCooldownMs = 10000;
+
+    /**
+     * @brief 改回在线程池中执行的截止时间(steady_clock，纳秒)，0表示没有.
+     */
+    mutable std::atomic<int64_t> inline_demoted_until{0};
+
+    bool inline_enabled() const;
 };
 
+/**
+ * @brief 路由.
+ * 
+ * @details 路由表以不可修改的快照发布：添加、移除路由时复制出新的路由表，原子地替换，
+ *          处理请求时不加锁，可以在服务器运行期间添加、移除路由.
+ * @details 被替换的路由表在所有可能读取它的线程退出读取后才释放(基于纪元的回收).
+ */
 class Router {
 public:
     Router(Server* server = nullptr);
@@ -42,8 +160,11 @@ public:
     /**
      * @brief 添加路由.
      * 
+     * @details 路径可以包含参数(/user/:id)和末尾的通配符(/static/*file)，
+     *          处理函数中通过 req.path_param("id") 读取.
+     * 
      * @retval true 添加成功
-     * @retval false 添加失败，路由已存在
+     * @retval false 添加失败，路由已存在或者路径格式错误
      */
     bool AddRoute(const std::string& path, const std::string& description, RequestHandler handler);
 
@@ -55,19 +176,214 @@ public:
      */
     bool AddRoute(const std::string& path, RequestHandler handler);
 
+    /**
+     * @brief 添加路由.
+     * 
+     * @retval true 添加成功
+     * @retval false 添加失败，路由已存在
+     */
+    bool AddRoute(const std::string& path, const std::string& description, const RouteOptions& options, RequestHandler handler);
+
+    /**
+     * @brief 添加类型化路由.
+     * 
+     * @details 请求参数直接从接收到的数据解码到In，处理函数填写的Out直接编码为响应，不构造Json::Value.
+     *          参数与类型不符(如字符串传给整数字段)时返回BadRequest，不认识的键被忽略.
+     * @details 不使用响应缓存和合并请求，请求中的数据体被忽略.
+     * 
+     *   router->AddRoute<GetUserRequest, GetUserResponse>("/user/get", "获取用户信息",
+     *       [](ic::uds::Request& req, const GetUserRequest& in, GetUserResponse& out){ ... });
+     * 
+     * @retval false 添加失败，路由已存在或者路径格式错误
+     */
+    template <typename In, typename Out>
+    bool AddRoute(const std::string& path, const std::string& description, const RouteOptions& options, TypedRequestHandler<In, Out> handler) {
+        auto route = std::make_shared<Route>(path, description, options, nullptr);
+        route->typed_handler = [handler](Request& req, const char* begin, const char* end, bool binary, std::string* response) {
+            In in{};
+            if (begin) {
+                bool ok = binary ? typed::DecodeMsgpack(begin, end, &in) : typed::DecodeJson(begin, end, &in);
+                if (!ok) {
+                    return false;
+                }
+            }
+            Out out{};
+            handler(req, in, out);
+            typed::EncodeResponse(out, req.binary(), response);
+            return true;
+        };
+        return AddRoute(route);
+    }
+
+    template <typename In, typename Out>
+    bool AddRoute(const std::string& path, const std::string& description, TypedRequestHandler<In, Out> handler) {
+        return AddRoute<In, Out>(path, description, RouteOptions(), handler);
+    }
+
+    /**
+     * @brief 添加批处理路由，同一路由的请求合并为批次，一次调用处理函数.
+     * 
+     * @details 收集到options.batch_max_size个请求或者等待options.batch_max_delay_us微秒后调用处理函数，
+     *          适用于写入数据库、日志等批量操作效率更高的路由. 每个响应按各自的请求ID发送给各自的客户端.
+     * @details 批次中的请求不再引用接收缓冲区(参数和数据体已复制)，不能检查是否已取消.
+     * 
+     *   router->AddBatchRoute("/log/write", "写入日志", options, [](std::vector<ic::uds::BatchItem>& batch){
+     *       for (auto& item : batch) { ... item.req["msg"] ... item.res["code"] = 0; }
+     *   });
+     * 
+     * @retval false 添加失败，路由已存在或者路径格式错误
+     */
+    bool AddBatchRoute(const std::string& path, const std::string& description, const RouteOptions& options, BatchRequestHandler handler);
+    bool AddBatchRoute(const std::string& path, const std::string& description, BatchRequestHandler handler);
+
+    /**
+     * @brief 移除路由，正在执行的处理函数不受影响.
+     * 
+     * @retval false 路由不存在
+     */
+    bool RemoveRoute(const std::string& path);
+
+    /**
+     * @brief 查找路由.
+     * 
+     * @param params [out] 路径参数，可以为空
+     * @return 未找到时返回nullptr
+     * @note 返回的路由在被移除后可能失效，运行期间会移除路由时使用 FindRouteOptions()
+     */
+    const Route* FindRoute(std::string_view path, PathParams* params = nullptr) const;
+
+    /**
+     * @brief 查找路由，复制其选项.
+     * 
+     * @retval false 未找到
+     */
+    bool FindRouteOptions(std::string_view path, RouteOptions* options) const;
+
+    /**
+     * @brief 按路由设置请求的调度信息(优先级、是否在接收线程上执行).
+     * 
+     * @retval false 未找到
+     */
+    bool Classify(std::string_view path, DispatchInfo* info) const;
+
+    /**
+     * @brief 移除各路由缓存的响应中，请求路径以prefix开头的条目.
+     * 
+     * @return 移除的条目数量
+     */
+    size_t InvalidateCaches(std::string_view prefix);
+
+    /**
+     * @brief 是否有路由设置了优先级.
+     */
+    bool has_priority_routes() const { return has_priority_routes_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 是否有类型化路由.
+     */
+    bool has_typed_routes() const { return has_typed_routes_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 是否有路由设置了在接收线程上执行.
+     */
+    bool has_inline_routes() const { return has_inline_routes_.load(std::memory_order_relaxed); }
+
     void set_bad_request_handler(RequestHandler handler) { bad_request_handler_ = handler; }
     void set_invalid_path_handler(RequestHandler handler) { invalid_path_handler_ = handler; }
 
 public:
     void HandleRequest(Request& req, Response& res);
+
+    /**
+     * @brief 处理请求的结果(路由启用了响应缓存或者合并请求时).
+     */
+    struct HandleResult {
+        /**
+         * @brief 序列化后的响应，为空时由调用方序列化res.
+         */
+        std::shared_ptr<const std::string> serialized;
+
+        /**
+         * @brief 已合并到相同的进行中请求，由该请求发送响应，调用方不再发送.
+         */
+        bool joined{false};
+
+        /**
+         * @brief 处理函数调用了 Request::Defer()，由延迟响应发送，调用方不再发送.
+         */
+        bool deferred{false};
+
+        /**
+         * @brief 合并到本请求的其他请求，调用方同样向它们发送serialized.
+         * 
+         * @details 处理函数抛出异常时(serialized为空)，调用方向它们发送UnknownError.
+         */
+        std::vector<SingleFlight::Waiter> waiters;
+    };
+
+    /**
+     * @brief 处理请求，路由启用了响应缓存或者合并请求时返回序列化后的响应.
+     */
+    void HandleRequest(Request& req, Response& res, HandleResult* result);
+
+    /**
+     * @brief 处理类型化路由的请求，不解析整个消息.
+     * 
+     * @param data 接收到的请求数据
+     * @retval false 不是类型化路由(或者消息不是严格的格式)，调用方解析后调用 HandleRequest()
+     */
+    bool HandleTypedRequest(Request& req, Response& res, const std::string& data, HandleResult* result);
     void HandleBadRequest(Request& req, Response& res);
     void HandleInvalidPath(Request& req, Response& res);
 
+private:
+    struct RouteTable;
+    class ReadGuard;
+    bool AddRoute(const std::shared_ptr<Route>& route);
+    void HandleTypedRoute(const Route* route, Request& req, Response& res, const char* begin, const char* end, bool binary, HandleResult* result);
+    void Publish(RouteTable* table);
+    void Reclaim();
+
 private:
     Server* svr_{nullptr};
     RequestHandler bad_request_handler_;
     RequestHandler invalid_path_handler_;
-    std::map<std::string, Route*> routes_;
+
+    /**
+     * @brief 当前的路由表.
+     */
+    std::atomic<RouteTable*> table_{nullptr};
+    std::atomic_bool has_priority_routes_{false};
+    std::atomic_bool has_typed_routes_{false};
+    std::atomic_bool has_inline_routes_{false};
+
+    /**
+     * @brief 添加、移除路由之间互斥(不影响读取).
+     */
+    std::mutex write_mutex_;
+
+    /**
+     * @brief 纪元，每次替换路由表后加1.
+     */
+    mutable std::atomic<uint64_t> epoch_{1};
+
+    /**
+     * @brief 读取路由表的线程占用一个槽位，记录开始读取时的纪元(0表示空闲).
+     * 
+     * @details 处理函数执行期间一直占用槽位；同时读取的线程超过kReaderSlots时，
+     *          其余的线程计入overflow_readers_，期间不释放被替换的路由表.
+     */
+    static const size_t kReaderSlots = 64;
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};
+    };
+    mutable ReaderSlot reader_slots_[kReaderSlots];
+    mutable std::atomic<size_t> overflow_readers_{0};
+
+    /**
+     * @brief 已被替换、等待释放的路由表，及其被替换时的纪元.
+     */
+    std::vector<std::pair<uint64_t, RouteTable*>> retired_tables_;
 };
 
 } // namespace uds
@@ -1,4 +1,6 @@
 #include "server.h"
+#include <algorithm>
+#include "deferred_response.h"
 #include "request.h"
 #include "response.h"
 #include "router.h"
@@ -6,28 +8,209 @@
 namespace ic {
 namespace uds {
 
+/**
+ * @brief 工作线程复用的序列化缓冲区.
+ * 
+ * @details 发送完成后只清空内容、保留容量，之后的响应不再分配内存；超过上限时才释放.
+ */
+struct ResponseBuffers {
+    static const size_t kMaxRetainedBytes = 64 * 1024;
+
+    void Reset() {
+        fragments.clear();
+        if (head.capacity() > kMaxRetainedBytes) {
+            std::string().swap(head);
+        }
+    }
+
+    std::string head;
+    std::vector<std::string_view> fragments;
+};
+
+static ResponseBuffers& s_response_buffers() {
+    static thread_local ResponseBuffers buffers;
+    return buffers;
+}
+
+/**
+ * @brief 工作线程复用的请求和响应对象.
+ */
+struct WorkerMessages {
+    Request req;
+    Response res;
+    bool in_use = false;
+};
+
+/**
+ * @brief 从工作线程复用的对象中取出请求和响应，重置后使用.
+ * 
+ * @details 请求路径、数据体数组保留已分配的内存，之后的请求不再分配；
+ *          处理结束时释放解析结果和延迟响应等引用.
+ *          处理函数中嵌套执行请求(如在接收线程上执行的路由)时使用新的对象.
+ */
+class Server::MessagesLease {
+public:
+    MessagesLease(Server* svr, const RequestContext& context) {
+        static thread_local WorkerMessages messages;
+        if (messages.in_use) {
+            owned_.reset(new WorkerMessages());
+            messages_ = owned_.get();
+        }
+        else {
+            messages_ = &messages;
+        }
+        messages_->in_use = true;
+        messages_->req.Reset(svr, &context.client_addr, context.request_id);
+        messages_->res.Reset(context.request_id);
+    }
+
+    ~MessagesLease() {
+        messages_->req.Reset(nullptr, nullptr, -1);
+        messages_->res.Reset(-1);
+        messages_->in_use = false;
+    }
+
+    Request& req() { return messages_->req; }
+    Response& res() { return messages_->res; }
+
+private:
+    WorkerMessages* messages_ = nullptr;
+    std::unique_ptr<WorkerMessages> owned_;
+};
+
 Server::Server() {
     router_ = new Router();
-    this->set_request_callback([](BaseServer* base_server, const sockaddr_un& client_addr, int64_t request_id, const std::string& data){
+    deferred_timer_ = std::make_shared<DeferredResponseTimer>(this);
+    this->set_request_callback([](BaseServer* base_server, const RequestContext& context, const std::string& data){
         Server* server = dynamic_cast<Server*>(base_server);
-        Request req(server, &client_addr, request_id);
-        Response res(request_id);
-        if (req.Deserialize(data)) {
-            server->router_->HandleRequest(req, res);
+        MessagesLease lease(server, context);
+        Request& req = lease.req();
+        req.set_priority(context.priority);
+        req.deadline_ = context.deadline;
+        req.receive_time_ = context.receive_time;
+        req.cancel_flag_ = context.cancel_flag.get();
+        req.inline_ = context.inline_execution;
+        Response& res = lease.res();
+        Router::HandleResult result;
+        bool ok = true;
+        bool handled = false;
+        /* 类型化路由不解析整个消息 */
+        if (server->router_->has_typed_routes()) {
+            if (req.expired() || req.cancelled()) {
+                return;
+            }
+            handled = server->router_->HandleTypedRequest(req, res, data, &result);
+        }
+        if (!handled) {
+            /* 延迟解析失败(如JSON不是严格的格式)时完整解析 */
+            ok = (server->lazy_parsing_ && req.DeserializeLazy(data)) || req.Deserialize(data);
+            /* 响应使用与请求相同的编码 */
+            res.set_binary(req.binary());
+            if (ok) {
+                /* 解析完成后客户端已不再等待，不必再处理 */
+                if (req.expired() || req.cancelled()) {
+                    return;
+                }
+                try {
+                    server->router_->HandleRequest(req, res, &result);
+                }
+                catch (...) {
+                    /* 合并到本请求的其他请求不会再收到响应，返回UnknownError */
+                    if (!result.waiters.empty()) {
+                        Response error;
+                        error.set_status(Response::Status::UnknownError);
+                        error.set_binary(req.binary());
+                        std::string serialized = error.Serialize();
+                        for (auto& waiter : result.waiters) {
+                            server->SendResponse(waiter.client_addr, waiter.request_id, serialized);
+                        }
+                    }
+                    throw;
+                }
+            }
+        }
+        if (ok) {
+            /* 由延迟响应(或者合并到的请求)发送 */
+            if (result.joined || result.deferred) {
+                return;
+            }
+            /* 合并到本请求的其他请求，使用各自的请求ID发送同一份响应 */
+            for (auto& waiter : result.waiters) {
+                server->SendResponse(waiter.client_addr, waiter.request_id, *result.serialized);
+            }
+            if (req.cancelled()) {
+                return;
+            }
+            /* 命中响应缓存(或者类型化路由)时直接发送序列化后的响应 */
+            if (result.serialized) {
+                server->SendResponse(context.client_addr, context.request_id, *result.serialized);
+                return;
+            }
         }
         else {
             server->router_->HandleBadRequest(req, res);
         }
-        server->SendResponse(client_addr, request_id, res.Serialize());
+        /* 数据体不复制，发送时直接引用(可以引用请求中的数据体) */
+        ResponseBuffers& buffers = s_response_buffers();
+        res.Serialize(&buffers.head, &buffers.fragments);
+        server->SendResponse(context.client_addr, context.request_id, buffers.fragments);
+        buffers.Reset();
+    });
+    /* 按路由设置的优先级调度，很快的路由在接收线程上执行 */
+    this->set_classify_callback([this](const sockaddr_un& client_addr, const std::string& data, DispatchInfo& info){
+        if (!router_->has_priority_routes() && !router_->has_inline_routes()) {
+            return;
+        }
+        /* 压缩的请求使用客户端在头部携带的路径 */
+        std::string_view path = info.route_hint;
+        if (path.empty() && !Request::PeekPath(data, &path)) {
+            return;
+        }
+        router_->Classify(path, &info);
     });
 }
 
 Server::~Server() {
+    deferred_timer_->Shutdown();
     if (router_) {
         delete router_;
         router_ = nullptr;
     }
 }
 
+/**
+ * @brief 创建延迟响应，截止时间取超时时间和客户端的截止时间中较早的一个.
+ */
+std::shared_ptr<DeferredResponse> Server::Defer(Request& req, uint32_t timeout_ms) {
+    std::shared_ptr<DeferredResponse> deferred(new DeferredResponse());
+    deferred->timer_ = deferred_timer_;
+    deferred->client_addr_ = *req.client_addr();
+    deferred->request_id_ = req.id();
+    deferred->res_.set_binary(req.binary());
+    auto timeout = std::chrono::milliseconds(timeout_ms ? timeout_ms : deferred_timeout_ms_);
+    deferred->deadline_ = std::min(std::chrono::steady_clock::now() + timeout, req.deadline());
+    if (req.key_ && req.route_) {
+        deferred->key_ = *req.key_;
+        if (req.key_for_cache_) {
+            deferred->cache_ = req.route_->cache;
+        }
+        if (req.key_for_single_flight_) {
+            deferred->single_flight_ = req.route_->single_flight;
+        }
+    }
+    deferred_timer_->Add(deferred);
+    return deferred;
+}
+
+/**
+ * @brief 使路径以prefix开头的缓存失效.
+ * 
+ * @details 先移除服务端各路由的缓存，再通知订阅了失效通知的客户端.
+ */
+size_t Server::InvalidateCache(const std::string& path_prefix) {
+    router_->InvalidateCaches(path_prefix);
+    return Publish(ResponseCache::kInvalidationTopic, path_prefix);
+}
+
 } // namespace uds
 } // namespace ic
@@ -1,11 +1,15 @@
 #ifndef IC_UDS_JSON_SERVER_H_
 #define IC_UDS_JSON_SERVER_H_
+#include <memory>
 #include "../base/base_server.h"
 
 namespace ic {
 namespace uds {
 
 class Router;
+class Request;
+class DeferredResponse;
+class DeferredResponseTimer;
 
 class Server : public BaseServer {
 public:
@@ -14,8 +18,42 @@ public:
 
     Router* router() { return router_; }
 
+    /**
+     * @brief 使请求路径以path_prefix开头的缓存失效.
+     * 
+     * @details 包括各路由的响应缓存，和启用了响应缓存的客户端(Client::EnableResponseCache)中缓存的响应.
+     * 
+     * @return 收到通知的客户端数量
+     */
+    size_t InvalidateCache(const std::string& path_prefix);
+
+    /**
+     * @brief 启用/禁用延迟解析请求，默认禁用.
+     * 
+     * @details 启用后先只读取请求路径并查找路由，参数和数据体在处理函数第一次访问时才解析：
+     *          路径无效、已超过截止时间或者已取消的请求不解析参数，只读取数据体的处理函数不解析参数.
+     * @details 消息格式在查找路由之前检查，但参数和数据体的元数据在访问时才解析，
+     *          此时解析失败(如数据体超出范围)不返回BadRequest，参数或数据体为空.
+     */
+    void set_lazy_parsing(bool enabled) { lazy_parsing_ = enabled; }
+
+    /**
+     * @brief 延迟响应(Request::Defer)的默认超时时间(毫秒)，默认30秒.
+     */
+    void set_deferred_timeout_ms(uint32_t timeout_ms) { deferred_timeout_ms_ = timeout_ms; }
+
+private:
+    friend class Request;
+    std::shared_ptr<DeferredResponse> Defer(Request& req, uint32_t timeout_ms);
+
+    /* 工作线程复用的请求和响应对象 */
+    class MessagesLease;
+
 private:
     Router* router_;
+    bool lazy_parsing_{false};
+    uint32_t deferred_timeout_ms_{30000};
+    std::shared_ptr<DeferredResponseTimer> deferred_timer_;
 };
 
 } // namespace uds
@@ -0,0 +1,71 @@
+#include "single_flight.h"
+
+namespace ic {
+namespace uds {
+
+constexpr std::chrono::milliseconds SingleFlight::kRetention;
+
+SingleFlight::JoinResult SingleFlight::Join(const std::string& key, const sockaddr_un& client_addr, int64_t request_id,
+                                            clock::time_point receive_time, std::shared_ptr<const std::string>* response)
+{
+    std::lock_guard<std::mutex> lck(mutex_);
+    auto iter = calls_.find(key);
+    if (iter == calls_.end()) {
+        calls_.emplace(key, Call());
+        return JoinResult::Leader;
+    }
+    Call& call = iter->second;
+    if (!call.completed) {
+        call.waiters.push_back(Waiter{ client_addr, request_id });
+        return JoinResult::Waiting;
+    }
+    if (call.complete_time >= receive_time) {
+        *response = call.response;
+        return JoinResult::Completed;
+    }
+    /* 已完成的响应早于本请求，重新执行 */
+    call.completed = false;
+    call.response.reset();
+    return JoinResult::Leader;
+}
+
+std::vector<SingleFlight::Waiter> SingleFlight::Leave(const std::string& key, std::shared_ptr<const std::string> response) {
+    std::vector<Waiter> waiters;
+    auto now = clock::now();
+    std::lock_guard<std::mutex> lck(mutex_);
+    auto iter = calls_.find(key);
+    if (iter != calls_.end()) {
+        waiters.swap(iter->second.waiters);
+        if (response) {
+            iter->second.completed = true;
+            iter->second.complete_time = now;
+            iter->second.response = std::move(response);
+        }
+        else {
+            calls_.erase(iter);
+        }
+    }
+    if (now - last_cleanup_time_ >= kRetention) {
+        RemoveCompleted(now);
+        last_cleanup_time_ = now;
+    }
+    return waiters;
+}
+
+/**
+ * @brief 移除超过保留时长的响应，调用者持有mutex_.
+ */
+void SingleFlight::RemoveCompleted(clock::time_point now) {
+    auto iter = calls_.begin();
+    while (iter != calls_.end()) {
+        if (iter->second.completed && now - iter->second.complete_time >= kRetention) {
+            iter = calls_.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
+}
+
+} // namespace uds
+} // namespace ic
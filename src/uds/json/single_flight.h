@@ -0,0 +1,90 @@
+/**
+ * @file single_flight.h
+ * @brief 合并相同的进行中请求.
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-28
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_JSON_SINGLE_FLIGHT_H_
+#define IC_UDS_JSON_SINGLE_FLIGHT_H_
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/un.h>
+
+namespace ic {
+namespace uds {
+
+/**
+ * @brief 合并相同的进行中请求.
+ *
+ * @details 第一个请求执行处理函数，处理期间到达的相同请求只登记客户端地址和请求ID，
+ *          不占用工作线程等待；第一个请求处理完成后，同一份响应发送给所有登记的请求.
+ * @details 工作线程不足时，相同的请求可能在队列中等待，第一个请求完成后才被取出.
+ *          因此完成的响应保留一段时间，在它完成之前收到的相同请求直接使用该响应.
+ */
+class SingleFlight {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 等待响应的请求.
+     */
+    struct Waiter {
+        sockaddr_un client_addr;
+        int64_t request_id;
+    };
+
+    enum class JoinResult {
+        Leader,     /* 没有相同的进行中请求，调用方执行处理函数，完成后必须调用 Leave() */
+        Waiting,    /* 已登记，由进行中的请求发送响应 */
+        Completed,  /* 相同的请求在本请求收到之后完成，直接使用其响应 */
+    };
+
+    /**
+     * @brief 加入相同的进行中请求.
+     *
+     * @param receive_time 收到本请求的时间
+     * @param response [out] 返回Completed时为已完成的响应
+     */
+    JoinResult Join(const std::string& key, const sockaddr_un& client_addr, int64_t request_id,
+                    clock::time_point receive_time, std::shared_ptr<const std::string>* response);
+
+    /**
+     * @brief 结束进行中的请求，返回处理期间登记的请求.
+     *
+     * @param response 序列化后的响应，为空时(处理失败)不保留
+     */
+    std::vector<Waiter> Leave(const std::string& key, std::shared_ptr<const std::string> response);
+
+private:
+    void RemoveCompleted(clock::time_point now);
+
+private:
+    /**
+     * @brief 完成的响应保留的时长.
+     */
+    static constexpr std::chrono::milliseconds kRetention{1000};
+
+    struct Call {
+        bool completed{false};
+        std::vector<Waiter> waiters;
+        clock::time_point complete_time;
+        std::shared_ptr<const std::string> response;
+    };
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Call> calls_;
+    clock::time_point last_cleanup_time_{clock::now()};
+};
+
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_JSON_SINGLE_FLIGHT_H_
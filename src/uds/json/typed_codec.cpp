@@ -0,0 +1,99 @@
+#include "typed_codec.h"
+#include "message.h"
+
+namespace ic {
+namespace uds {
+namespace typed {
+
+/**
+ * @brief 在序列化的消息中查找":param"和":body"的值.
+ * 
+ * @details 只读取顶层对象的键，值直接跳过(同时检查格式).
+ */
+bool ScanEnvelope(const std::string& data, Envelope* envelope) {
+    if (data.length() < 5) {
+        return false;
+    }
+    unsigned int length_field = 0;
+    memcpy(&length_field, data.data(), 4);
+    envelope->binary = (length_field & Message::BINARY_ENVELOPE_FLAG) != 0;
+    size_t json_len = static_cast<size_t>(length_field & ~Message::BINARY_ENVELOPE_FLAG);
+    if (json_len + 4 > data.length()) {
+        return false;
+    }
+    const char* json_begin = data.data() + 4;
+    const char* json_end = json_begin + json_len;
+    envelope->param_begin = envelope->param_end = nullptr;
+    envelope->body_begin = envelope->body_end = nullptr;
+    envelope->body_start = 4 + json_len;
+
+    auto on_member = [envelope](auto& reader, const char* key, size_t len) {
+        const char** begin = nullptr;
+        const char** end = nullptr;
+        if (len == 6 && memcmp(key, ":param", 6) == 0) {
+            begin = &envelope->param_begin;
+            end = &envelope->param_end;
+        }
+        else if (len == 5 && memcmp(key, ":body", 5) == 0) {
+            begin = &envelope->body_begin;
+            end = &envelope->body_end;
+        }
+        const char* value_begin = reader.position();
+        if (!reader.Skip()) {
+            return false;
+        }
+        if (begin) {
+            *begin = value_begin;
+            *end = reader.position();
+        }
+        return true;
+    };
+    if (envelope->binary) {
+        MsgpackReader reader(json_begin, json_end);
+        return reader.ReadObject([&](const char* key, size_t len){ return on_member(reader, key, len); })
+            && reader.position() == json_end;
+    }
+    json::Reader reader(json_begin, json_end);
+    return reader.ReadObject([&](const char* key, size_t len){ return on_member(reader, key, len); })
+        && reader.position() == json_end;
+}
+
+/**
+ * @brief 写入响应的长度字段(之后回填)和":param"的键.
+ */
+void BeginResponse(bool binary, std::string* out) {
+    out->assign(4, '\0');
+    if (binary) {
+        msgpack::WriteMapHeader(2, out);
+        msgpack::WriteString(":param", 6, out);
+    }
+    else {
+        out->append("{\":param\":", 10);
+    }
+}
+
+/**
+ * @brief 写入状态码，回填长度字段.
+ * 
+ * @details 与Response::Serialize一致(键按字典序，":status"在":param"之后).
+ */
+void EndResponse(bool binary, int status, std::string* out) {
+    if (binary) {
+        msgpack::WriteString(":status", 7, out);
+        msgpack::WriteInt(status, out);
+    }
+    else {
+        out->append(",\":status\":", 11);
+        json::WriteInt(status, out);
+        out->push_back('}');
+    }
+    unsigned int json_len = static_cast<unsigned int>(out->length() - 4);
+    if (binary) {
+        json_len |= Message::BINARY_ENVELOPE_FLAG;
+    }
+    memcpy(&(*out)[0], &json_len, 4);
+}
+
+} // namespace typed
+} // namespace uds
+} // namespace ic
@@ -0,0 +1,477 @@
+/**
+ * @file typed_codec.h
+ * @brief 结构体与请求、响应数据之间的直接编解码(不构造Json::Value).
+ * @author Leopard-C (leopard.c@outlook.com)
+ * @version 0.1
+ * @date 2023-04-29
+ *
+ * @copyright Copyright (c) 2023-present, Jinbao Chen.
+ */
+#ifndef IC_UDS_JSON_TYPED_CODEC_H_
+#define IC_UDS_JSON_TYPED_CODEC_H_
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "json_codec.h"
+#include "msgpack_codec.h"
+
+/**
+ * @brief 声明结构体的字段，之后可以直接编解码(类型化路由 Router::AddRoute<In, Out>).
+ *
+ * @details 在结构体所在的命名空间中使用，最多32个字段，JSON中的键名与字段名相同.
+ * @details 字段类型可以是bool、整数、浮点数、std::string、std::vector<T>、std::optional<T>，
+ *          以及同样声明了字段的结构体.
+ *
+ *   struct GetUserRequest {
+ *       int64_t uid = 0;
+ *       std::string name;
+ *   };
+ *   IC_UDS_FIELDS(GetUserRequest, uid, name)
+ */
+#define IC_UDS_FIELDS(Type, ...) \
+    inline constexpr auto uds_typed_fields(const Type*) { \
+        using uds_typed_type = Type; \
+        return std::make_tuple(IC_UDS_TYPED_FOR_EACH(IC_UDS_TYPED_FIELD, __VA_ARGS__)); \
+    }
+
+#define IC_UDS_TYPED_FIELD(name) ::ic::uds::typed::MakeField(#name, &uds_typed_type::name)
+#define IC_UDS_TYPED_EXPAND(x) x
+#define IC_UDS_TYPED_FE_1(m, x) m(x)
+#define IC_UDS_TYPED_FE_2(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_1(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_3(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_2(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_4(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_3(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_5(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_4(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_6(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_5(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_7(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_6(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_8(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_7(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_9(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_8(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_10(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_9(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_11(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_10(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_12(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_11(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_13(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_12(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_14(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_13(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_15(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_14(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_16(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_15(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_17(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_16(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_18(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_17(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_19(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_18(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_20(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_19(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_21(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_20(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_22(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_21(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_23(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_22(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_24(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_23(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_25(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_24(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_26(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_25(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_27(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_26(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_28(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_27(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_29(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_28(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_30(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_29(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_31(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_30(m, __VA_ARGS__))
+#define IC_UDS_TYPED_FE_32(m, x, ...) m(x), IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_FE_31(m, __VA_ARGS__))
+#define IC_UDS_TYPED_GET_FE(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, NAME, ...) NAME
+#define IC_UDS_TYPED_FOR_EACH(m, ...) \
+    IC_UDS_TYPED_EXPAND(IC_UDS_TYPED_GET_FE(__VA_ARGS__, IC_UDS_TYPED_FE_32, IC_UDS_TYPED_FE_31, IC_UDS_TYPED_FE_30, IC_UDS_TYPED_FE_29, IC_UDS_TYPED_FE_28, IC_UDS_TYPED_FE_27, IC_UDS_TYPED_FE_26, IC_UDS_TYPED_FE_25, IC_UDS_TYPED_FE_24, IC_UDS_TYPED_FE_23, IC_UDS_TYPED_FE_22, IC_UDS_TYPED_FE_21, IC_UDS_TYPED_FE_20, IC_UDS_TYPED_FE_19, IC_UDS_TYPED_FE_18, IC_UDS_TYPED_FE_17, IC_UDS_TYPED_FE_16, IC_UDS_TYPED_FE_15, IC_UDS_TYPED_FE_14, IC_UDS_TYPED_FE_13, IC_UDS_TYPED_FE_12, IC_UDS_TYPED_FE_11, IC_UDS_TYPED_FE_10, IC_UDS_TYPED_FE_9, IC_UDS_TYPED_FE_8, IC_UDS_TYPED_FE_7, IC_UDS_TYPED_FE_6, IC_UDS_TYPED_FE_5, IC_UDS_TYPED_FE_4, IC_UDS_TYPED_FE_3, IC_UDS_TYPED_FE_2, IC_UDS_TYPED_FE_1)(m, __VA_ARGS__))
+
+namespace ic {
+namespace uds {
+namespace typed {
+
+/**
+ * @brief 字段描述：键名和成员指针.
+ */
+template <typename C, typename M>
+struct Field {
+    const char* name;
+    size_t length;
+    M C::* member;
+};
+
+template <typename C, typename M, size_t N>
+constexpr Field<C, M> MakeField(const char (&name)[N], M C::* member) {
+    return Field<C, M>{ name, N - 1, member };
+}
+
+template <typename T, typename = void>
+struct HasFields : std::false_type {};
+
+template <typename T>
+struct HasFields<T, std::void_t<decltype(uds_typed_fields(static_cast<const T*>(nullptr)))>> : std::true_type {};
+
+template <typename T>
+struct IsVector : std::false_type {};
+
+template <typename T, typename A>
+struct IsVector<std::vector<T, A>> : std::true_type {};
+
+template <typename T>
+struct IsOptional : std::false_type {};
+
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+/**
+ * @brief 读取MessagePack，接口与json::Reader一致.
+ */
+class MsgpackReader {
+public:
+    MsgpackReader(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    const char* position() const { return p_; }
+    bool ReadNull() { return msgpack::ReadNil(&p_, end_); }
+    bool ReadBool(bool* value) { return msgpack::ReadBool(&p_, end_, value); }
+    bool ReadInt(int64_t* value) { return msgpack::ReadInt(&p_, end_, value); }
+    bool ReadUint(uint64_t* value) { return msgpack::ReadUint(&p_, end_, value); }
+    bool ReadDouble(double* value) { return msgpack::ReadDouble(&p_, end_, value); }
+    bool Skip() { return msgpack::Skip(&p_, end_); }
+
+    bool ReadString(std::string* value) {
+        const char* str = nullptr;
+        size_t len = 0;
+        if (!msgpack::ReadString(&p_, end_, &str, &len)) {
+            return false;
+        }
+        value->assign(str, len);
+        return true;
+    }
+
+    template <typename F>
+    bool ReadObject(F&& on_member) {
+        uint32_t count = 0;
+        if (!msgpack::ReadMapHeader(&p_, end_, &count)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            const char* key = nullptr;
+            size_t key_len = 0;
+            if (!msgpack::ReadString(&p_, end_, &key, &key_len) || !on_member(key, key_len)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename F>
+    bool ReadArray(F&& on_element) {
+        uint32_t count = 0;
+        if (!msgpack::ReadArrayHeader(&p_, end_, &count) || count > static_cast<size_t>(end_ - p_)) {
+            return false;  /* 每个元素至少1字节 */
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!on_element()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+/**
+ * @brief 写入紧凑的JSON(格式与json::Write一致，对象的键按字段声明的顺序).
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string* out) : out_(out) {}
+
+    void WriteNull() { out_->append("null", 4); }
+    void WriteBool(bool value) { value ? out_->append("true", 4) : out_->append("false", 5); }
+    void WriteInt(int64_t value) { json::WriteInt(value, out_); }
+    void WriteUint(uint64_t value) { json::WriteUint(value, out_); }
+    void WriteDouble(double value) { json::WriteDouble(value, out_); }
+    void WriteString(const std::string& value) { json::WriteString(value.data(), value.length(), out_); }
+
+    void BeginObject(size_t) { out_->push_back('{'); }
+    void EndObject() { out_->push_back('}'); }
+    void BeginArray(size_t) { out_->push_back('['); }
+    void EndArray() { out_->push_back(']'); }
+
+    /**
+     * @brief 键名是字段名(标识符)，不需要转义.
+     */
+    void Key(size_t index, const char* name, size_t len) {
+        if (index > 0) {
+            out_->push_back(',');
+        }
+        out_->push_back('"');
+        out_->append(name, len);
+        out_->append("\":", 2);
+    }
+
+    void Element(size_t index) {
+        if (index > 0) {
+            out_->push_back(',');
+        }
+    }
+
+private:
+    std::string* out_;
+};
+
+/**
+ * @brief 写入MessagePack(编码与msgpack::Write一致).
+ */
+class MsgpackWriter {
+public:
+    explicit MsgpackWriter(std::string* out) : out_(out) {}
+
+    void WriteNull() { msgpack::WriteNil(out_); }
+    void WriteBool(bool value) { msgpack::WriteBool(value, out_); }
+    void WriteInt(int64_t value) { msgpack::WriteInt(value, out_); }
+    void WriteUint(uint64_t value) { msgpack::WriteUint(value, out_); }
+    void WriteDouble(double value) { msgpack::WriteDouble(value, out_); }
+    void WriteString(const std::string& value) { msgpack::WriteString(value.data(), value.length(), out_); }
+
+    void BeginObject(size_t count) { msgpack::WriteMapHeader(count, out_); }
+    void EndObject() {}
+    void BeginArray(size_t count) { msgpack::WriteArrayHeader(count, out_); }
+    void EndArray() {}
+    void Key(size_t, const char* name, size_t len) { msgpack::WriteString(name, len, out_); }
+    void Element(size_t) {}
+
+private:
+    std::string* out_;
+};
+
+/**
+ * @brief 解码一个值，值为null时保持不变(与访问Json::Value中不存在的键一致).
+ */
+template <typename Reader, typename T>
+bool Decode(Reader& reader, T* value) {
+    if constexpr (IsOptional<T>::value) {
+        if (reader.ReadNull()) {
+            value->reset();
+            return true;
+        }
+        return Decode(reader, &value->emplace());
+    }
+    else {
+        if (reader.ReadNull()) {
+            return true;
+        }
+        if constexpr (std::is_same_v<T, bool>) {
+            return reader.ReadBool(value);
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            int64_t integer = 0;
+            if (!reader.ReadInt(&integer) || integer < std::numeric_limits<T>::min() || integer > std::numeric_limits<T>::max()) {
+                return false;
+            }
+            *value = static_cast<T>(integer);
+            return true;
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            uint64_t integer = 0;
+            if (!reader.ReadUint(&integer) || integer > std::numeric_limits<T>::max()) {
+                return false;
+            }
+            *value = static_cast<T>(integer);
+            return true;
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            double real = 0;
+            if (!reader.ReadDouble(&real)) {
+                return false;
+            }
+            *value = static_cast<T>(real);
+            return true;
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            return reader.ReadString(value);
+        }
+        else if constexpr (IsVector<T>::value) {
+            value->clear();
+            return reader.ReadArray([&reader, value]{
+                typename T::value_type element{};
+                if (!Decode(reader, &element)) {
+                    return false;
+                }
+                value->push_back(std::move(element));
+                return true;
+            });
+        }
+        else {
+            static_assert(HasFields<T>::value, "use IC_UDS_FIELDS to declare the fields of this type");
+            static constexpr auto fields = uds_typed_fields(static_cast<const T*>(nullptr));
+            return reader.ReadObject([&reader, value](const char* key, size_t len){
+                bool matched = false;
+                bool ok = true;
+                std::apply([&](const auto&... field){
+                    ((!matched && field.length == len && memcmp(field.name, key, len) == 0
+                        ? (matched = true, ok = Decode(reader, &(value->*field.member)))
+                        : false), ...);
+                }, fields);
+                /* 不认识的键被忽略 */
+                return matched ? ok : reader.Skip();
+            });
+        }
+    }
+}
+
+/**
+ * @brief 结构体的字段是否输出(值为空的std::optional不输出).
+ */
+template <typename T>
+bool IsPresent(const T& member) {
+    if constexpr (IsOptional<T>::value) {
+        return member.has_value();
+    }
+    else {
+        return true;
+    }
+}
+
+/**
+ * @brief 编码一个值.
+ */
+template <typename Writer, typename T>
+void Encode(Writer& writer, const T& value) {
+    if constexpr (IsOptional<T>::value) {
+        if (value) {
+            Encode(writer, *value);
+        }
+        else {
+            writer.WriteNull();
+        }
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+        writer.WriteBool(value);
+    }
+    else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        writer.WriteInt(static_cast<int64_t>(value));
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        writer.WriteUint(static_cast<uint64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        writer.WriteDouble(static_cast<double>(value));
+    }
+    else if constexpr (std::is_same_v<T, std::string>) {
+        writer.WriteString(value);
+    }
+    else if constexpr (IsVector<T>::value) {
+        writer.BeginArray(value.size());
+        size_t index = 0;
+        for (const auto& element : value) {
+            writer.Element(index++);
+            Encode(writer, static_cast<const typename T::value_type&>(element));
+        }
+        writer.EndArray();
+    }
+    else {
+        static_assert(HasFields<T>::value, "use IC_UDS_FIELDS to declare the fields of this type");
+        static constexpr auto fields = uds_typed_fields(static_cast<const T*>(nullptr));
+        /* 与json::Write一致，值为空的std::optional不输出 */
+        size_t count = 0;
+        std::apply([&](const auto&... field){
+            ((count += IsPresent(value.*field.member) ? 1 : 0), ...);
+        }, fields);
+        writer.BeginObject(count);
+        size_t index = 0;
+        std::apply([&](const auto&... field){
+            ([&]{
+                const auto& member = value.*field.member;
+                if (!IsPresent(member)) {
+                    return;
+                }
+                writer.Key(index++, field.name, field.length);
+                Encode(writer, member);
+            }(), ...);
+        }, fields);
+        writer.EndObject();
+    }
+}
+
+/**
+ * @brief 从JSON解码，必须是完整的值(末尾只能有空白).
+ */
+template <typename T>
+bool DecodeJson(const char* begin, const char* end, T* value) {
+    json::Reader reader(begin, end);
+    return Decode(reader, value) && reader.position() == end;
+}
+
+/**
+ * @brief 从MessagePack解码，必须恰好是一个完整的值.
+ */
+template <typename T>
+bool DecodeMsgpack(const char* begin, const char* end, T* value) {
+    MsgpackReader reader(begin, end);
+    return Decode(reader, value) && reader.position() == end;
+}
+
+/**
+ * @brief 编码为JSON，追加到out末尾.
+ */
+template <typename T>
+void EncodeJson(const T& value, std::string* out) {
+    JsonWriter writer(out);
+    Encode(writer, value);
+}
+
+/**
+ * @brief 编码为MessagePack，追加到out末尾.
+ */
+template <typename T>
+void EncodeMsgpack(const T& value, std::string* out) {
+    MsgpackWriter writer(out);
+    Encode(writer, value);
+}
+
+/**
+ * @brief 序列化的消息中各部分的位置.
+ */
+struct Envelope {
+    bool binary{false};                 /* JSON部分是否使用二进制编码 */
+    const char* param_begin{nullptr};   /* ":param"的值，没有":param"时为nullptr */
+    const char* param_end{nullptr};
+    const char* body_begin{nullptr};    /* ":body"的值(数据体的元数据)，没有":body"时为nullptr */
+    const char* body_end{nullptr};
+    size_t body_start{0};               /* 数据体的起始位置(JSON部分之后) */
+};
+
+/**
+ * @brief 在序列化的消息中查找":param"和":body"的值(不解析，只跳过).
+ *
+ * @retval false 消息格式不符合预期(或者JSON不是严格的格式)
+ */
+bool ScanEnvelope(const std::string& data, Envelope* envelope);
+
+/**
+ * @brief 写入响应的长度字段和":param"之前的部分(覆盖out原有的内容).
+ */
+void BeginResponse(bool binary, std::string* out);
+
+/**
+ * @brief 写入响应":param"之后的部分(状态码)，回填长度字段.
+ */
+void EndResponse(bool binary, int status, std::string* out);
+
+/**
+ * @brief 序列化响应，":param"为value，状态为成功.
+ */
+template <typename T>
+void EncodeResponse(const T& value, bool binary, std::string* out) {
+    BeginResponse(binary, out);
+    if (binary) {
+        EncodeMsgpack(value, out);
+    }
+    else {
+        EncodeJson(value, out);
+    }
+    EndResponse(binary, 0, out);
+}
+
+} // namespace typed
+} // namespace uds
+} // namespace ic
+
+#endif // IC_UDS_JSON_TYPED_CODEC_H_
@@ -0,0 +1,283 @@
+/**
+ * @file lz4_block.h
+ * @brief LZ4 block format codec (header-only).
+ *
+ * A small, dependency-free implementation of the LZ4 block format as specified in
+ * https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+ * Output is compatible with the reference LZ4_decompress_safe().
+ *
+ * Only the block format is implemented (no frame format, no dictionaries).
+ * The compressor is a single-pass greedy matcher with a 4K-entry hash table.
+ */
+#ifndef LZ4_BLOCK_H_
+#define LZ4_BLOCK_H_
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace lz4_block {
+
+namespace detail {
+
+static const size_t kMinMatch = 4;
+static const size_t kLastLiterals = 5;  /* the last 5 bytes are always literals */
+static const size_t kMFLimit = 12;      /* the last match must start at least 12 bytes before the end */
+static const size_t kMaxOffset = 65535;
+static const int kHashLog = 12;
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+/* number of equal leading bytes of two little-endian words */
+inline size_t common_bytes(uint64_t diff) {
+#if defined(__GNUC__)
+    return static_cast<size_t>(__builtin_ctzll(diff)) >> 3;
+#else
+    size_t n = 0;
+    while ((diff & 0xff) == 0) {
+        diff >>= 8;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+/* copies in 8-byte steps, may write up to 7 bytes past `dst + len` */
+inline void wild_copy(uint8_t* dst, const uint8_t* src, size_t len) {
+    uint8_t* const end = dst + len;
+    do {
+        memcpy(dst, src, 8);
+        dst += 8;
+        src += 8;
+    } while (dst < end);
+}
+
+inline uint32_t hash(uint32_t seq) {
+    return (seq * 2654435761U) >> (32 - kHashLog);
+}
+
+/* writes the 255-run extension of a length field */
+inline uint8_t* write_length(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+} // namespace detail
+
+/**
+ * @brief Upper bound of the compressed size of `src_size` bytes.
+ */
+inline size_t compress_bound(size_t src_size) {
+    return src_size + src_size / 255 + 16;
+}
+
+/**
+ * @brief Compress `src` into `dst`.
+ *
+ * @return number of bytes written, 0 if `dst_capacity` is too small
+ */
+inline size_t compress(const char* src, size_t src_size, char* dst, size_t dst_capacity) {
+    using namespace detail;
+    const uint8_t* const base = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* const iend = base + src_size;
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+    uint8_t* const oend = op + dst_capacity;
+
+    if (src_size > kMFLimit) {
+        const uint8_t* const mflimit = iend - kMFLimit;
+        const uint8_t* const matchlimit = iend - kLastLiterals;
+        uint32_t table[1 << kHashLog];
+        memset(table, 0, sizeof(table));
+
+        ++ip;
+        while (ip < mflimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash(seq);
+            const uint8_t* ref = base + table[h];
+            table[h] = static_cast<uint32_t>(ip - base);
+            if (ref >= ip || static_cast<size_t>(ip - ref) > kMaxOffset || read32(ref) != seq) {
+                /* skip faster through incompressible data */
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            /* extend backwards and forwards */
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            const uint8_t* mp = ip + kMinMatch;
+            const uint8_t* rp = ref + kMinMatch;
+            while (mp + 8 <= matchlimit) {
+                uint64_t diff = read64(mp) ^ read64(rp);
+                if (diff != 0) {
+                    mp += common_bytes(diff);
+                    goto match_end;
+                }
+                mp += 8;
+                rp += 8;
+            }
+            while (mp < matchlimit && *mp == *rp) {
+                ++mp;
+                ++rp;
+            }
+        match_end:
+
+            size_t literals = static_cast<size_t>(ip - anchor);
+            size_t match_len = static_cast<size_t>(mp - ip) - kMinMatch;
+            if (op + 1 + literals / 255 + 1 + literals + 2 + match_len / 255 + 1 > oend) {
+                return 0;
+            }
+
+            uint8_t* token = op++;
+            if (literals >= 15) {
+                *token = 15 << 4;
+                op = write_length(op, literals - 15);
+            }
+            else {
+                *token = static_cast<uint8_t>(literals << 4);
+            }
+            memcpy(op, anchor, literals);
+            op += literals;
+
+            uint16_t offset = static_cast<uint16_t>(ip - ref);
+            *op++ = static_cast<uint8_t>(offset & 0xff);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+
+            if (match_len >= 15) {
+                *token |= 15;
+                op = write_length(op, match_len - 15);
+            }
+            else {
+                *token |= static_cast<uint8_t>(match_len);
+            }
+
+            ip = mp;
+            anchor = ip;
+            if (ip - 2 > base) {
+                table[hash(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+            }
+        }
+    }
+
+    /* last literals */
+    size_t literals = static_cast<size_t>(iend - anchor);
+    if (op + 1 + literals / 255 + 1 + literals > oend) {
+        return 0;
+    }
+    if (literals >= 15) {
+        *op++ = 15 << 4;
+        op = write_length(op, literals - 15);
+    }
+    else {
+        *op++ = static_cast<uint8_t>(literals << 4);
+    }
+    memcpy(op, anchor, literals);
+    op += literals;
+    return static_cast<size_t>(op - reinterpret_cast<uint8_t*>(dst));
+}
+
+/**
+ * @brief Decompress `src` into `dst`, never reading or writing out of bounds.
+ *
+ * @return number of bytes written, -1 if the input is malformed or `dst_capacity` is too small
+ */
+inline long decompress(const char* src, size_t src_size, char* dst, size_t dst_capacity) {
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* const iend = ip + src_size;
+    uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+    uint8_t* const ostart = op;
+    uint8_t* const oend = op + dst_capacity;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        /* literals */
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                literals += b;
+            } while (b == 255);
+        }
+        if (literals > static_cast<size_t>(iend - ip) || literals > static_cast<size_t>(oend - op)) {
+            return -1;
+        }
+        if (literals + 8 <= static_cast<size_t>(iend - ip) && literals + 8 <= static_cast<size_t>(oend - op)) {
+            detail::wild_copy(op, ip, literals);
+        }
+        else {
+            memcpy(op, ip, literals);
+        }
+        ip += literals;
+        op += literals;
+        if (ip == iend) {
+            break;  /* the last sequence has no match */
+        }
+
+        /* match */
+        if (iend - ip < 2) {
+            return -1;
+        }
+        size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - ostart)) {
+            return -1;
+        }
+        size_t match_len = token & 15;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += detail::kMinMatch;
+        if (match_len > static_cast<size_t>(oend - op)) {
+            return -1;
+        }
+        const uint8_t* ref = op - offset;
+        if (offset >= 8 && match_len + 8 <= static_cast<size_t>(oend - op)) {
+            /* each 8-byte step reads bytes that are already written */
+            detail::wild_copy(op, ref, match_len);
+            op += match_len;
+        }
+        else if (offset >= match_len) {
+            memcpy(op, ref, match_len);
+            op += match_len;
+        }
+        else {
+            /* overlapping copy, byte by byte */
+            for (size_t i = 0; i < match_len; ++i) {
+                *op++ = *ref++;
+            }
+        }
+    }
+    return static_cast<long>(op - ostart);
+}
+
+} // namespace lz4_block
+
+#endif // LZ4_BLOCK_H_
@@ -61,6 +61,66 @@ target("benchmark_client")
     add_deps("uds_base")
     set_targetdir("bin")
 
+target("benchmark_compression")
+    set_kind("binary")
+    add_files("example/benchmark/compression.cpp")
+    add_deps("uds_base")
+    set_targetdir("bin")
+
+target("benchmark_json_codec")
+    set_kind("binary")
+    add_files("example/benchmark/json_codec.cpp")
+    add_deps("uds_json", "uds_base")
+    set_targetdir("bin")
+
+target("benchmark_router")
+    set_kind("binary")
+    add_files("example/benchmark/router.cpp")
+    add_deps("uds_json", "uds_base")
+    set_targetdir("bin")
+
+target("benchmark_typed_route")
+    set_kind("binary")
+    add_files("example/benchmark/typed_route.cpp")
+    add_deps("uds_json", "uds_base")
+    set_targetdir("bin")
+
+target("benchmark_allocations")
+    set_kind("binary")
+    add_files("example/benchmark/allocations.cpp")
+    add_deps("uds_json", "uds_base")
+    set_targetdir("bin")
+
+target("benchmark_batch_route")
+    set_kind("binary")
+    add_files("example/benchmark/batch_route.cpp")
+    add_deps("uds_json", "uds_base")
+    set_targetdir("bin")
+
+target("benchmark_inline_route")
+    set_kind("binary")
+    add_files("example/benchmark/inline_route.cpp")
+    add_deps("uds_json", "uds_base")
+    set_targetdir("bin")
+
+target("check_json_codec")
+    set_kind("binary")
+    add_files("example/check/json_codec.cpp")
+    add_deps("uds_json", "uds_base")
+    set_targetdir("bin")
+
+target("check_route_tree")
+    set_kind("binary")
+    add_files("example/check/route_tree.cpp")
+    add_deps("uds_json", "uds_base")
+    set_targetdir("bin")
+
+target("check_lz4")
+    set_kind("binary")
+    add_files("example/check/lz4.cpp")
+    add_deps("uds_base")
+    set_targetdir("bin")
+
 target("file_receiver")
     set_kind("binary")
     add_files("example/file_transfer/receiver.cpp")
@@ -73,6 +133,18 @@ target("file_sender")
     add_deps("uds_base")
     set_targetdir("bin")
 
+target("publisher")
+    set_kind("binary")
+    add_files("example/pubsub/publisher.cpp")
+    add_deps("uds_base")
+    set_targetdir("bin")
+
+target("subscriber")
+    set_kind("binary")
+    add_files("example/pubsub/subscriber.cpp")
+    add_deps("uds_base")
+    set_targetdir("bin")
+
 target("uds_base_cli")
     set_kind("binary")
     add_files("example/uds_base_cli/uds_base_cli.cpp")